@@ -239,7 +239,7 @@ void GameTechRenderer::RenderShadowMapPass(std::vector<ObjectSortState>& list) {
 	for (const auto&i : list) {
 		const RenderObject* o = i.object;
 
-		Matrix4 modelMatrix = o->GetTransform().GetMatrix();
+		Matrix4 modelMatrix = o->GetTransform().GetRenderMatrix();
 		Matrix4 mvpMatrix	= mvMatrix * modelMatrix;
 		glUniformMatrix4fv(mvpLocation, 1, false, (float*)&mvpMatrix);
 		BindMesh((OGLMesh&)*o->GetMesh());
@@ -333,7 +333,7 @@ void GameTechRenderer::RenderOpaquePass(std::vector<ObjectSortState>& list) {
 		if (diffuseTex) {
 			BindTextureToShader(*diffuseTex, "mainTex", 0);
 		}
-		Matrix4 modelMatrix = o->GetTransform().GetMatrix();
+		Matrix4 modelMatrix = o->GetTransform().GetRenderMatrix();
 		glUniformMatrix4fv(modelLocation, 1, false, (float*)&modelMatrix);
 
 		Matrix4 fullShadowMat = shadowMatrix * modelMatrix;
@@ -402,7 +402,7 @@ void GameTechRenderer::RenderTransparentPass(std::vector<ObjectSortState>& list)
 		if (diffuseTex) {
 			BindTextureToShader(*diffuseTex, "mainTex", 0);
 		}
-		Matrix4 modelMatrix = o->GetTransform().GetMatrix();
+		Matrix4 modelMatrix = o->GetTransform().GetRenderMatrix();
 		glUniformMatrix4fv(modelLocation, 1, false, (float*)&modelMatrix);
 
 		Matrix4 fullShadowMat = shadowMatrix * modelMatrix;
@@ -474,7 +474,7 @@ void GameTechVulkanRenderer::UpdateObjectList() {
 	auto objectWriter = [&](std::vector<ObjectSortState>& objects) {
 		for (auto& o : objects) {
 			ObjectState state;
-			state.modelMatrix	= o.object->GetTransform().GetMatrix();
+			state.modelMatrix	= o.object->GetTransform().GetRenderMatrix();
 			state.colour		= o.object->GetColour();
 			state.index[0]		= 0;
 
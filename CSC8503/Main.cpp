@@ -385,6 +385,9 @@ int main() {
     GameWorld* world = new GameWorld();
     PhysicsSystem* physics = new PhysicsSystem(*world);
 
+    JobSystem* jobs = new JobSystem();
+    physics->SetJobSystem(jobs);
+
 #ifdef USEVULKAN
     GameTechVulkanRenderer* renderer = new GameTechVulkanRenderer(*world);
 #elif defined(USEOPENGL)
@@ -446,6 +449,9 @@ int main() {
         Debug::UpdateRenderables(dt);
     }
 
+    physics->SetJobSystem(nullptr);
+    delete jobs;
+
     Window::DestroyGameWindow();
     return 0;
 }
\ No newline at end of file
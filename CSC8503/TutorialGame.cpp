@@ -80,6 +80,8 @@ TutorialGame::TutorialGame(GameWorld& inWorld, GameTechRendererInterface& inRend
 }
 
 TutorialGame::~TutorialGame()	{
+	delete playerFlow;
+	delete mazeGrid;
 }
 
 void TutorialGame::UpdateGame(float dt) {
@@ -181,7 +183,7 @@ void TutorialGame::UpdateGame(float dt) {
 		Matrix4 camWorld = Matrix::Inverse(view);
 		Vector3 forward = -Vector3(camWorld.GetColumn(2)); // 相机朝向（摄像机看向的方向）
 
-		Vector3 objPos = lockedObject->GetTransform().GetPosition();
+		Vector3 objPos = lockedObject->GetTransform().GetInterpolatedPosition(); //Where it's drawn, so the camera moves as smoothly
 
 		// 你可以用 lockedOffset 里面的 y / z 定义高度和距离，
 		// 或者直接写死一个你觉得舒服的值：
@@ -209,10 +211,42 @@ void TutorialGame::UpdateGame(float dt) {
 		InitCamera(); //F2 will reset the camera to a specific default place
 	}
 
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F3)) {
+		showProfiler = !showProfiler;
+	}
+	//F4 starts recording a trace, and pressing it again saves it
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F4)) {
+		PhysicsProfiler& profiler = physics.GetProfiler();
+		if (profiler.IsTracing()) {
+			profiler.SetTracing(false);
+			profiler.ExportChromeTrace("physics_trace.json");
+		}
+		else {
+			profiler.SetTracing(true);
+		}
+	}
+
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::G)) {
 		useGravity = !useGravity; //Toggle gravity!
 		physics.UseGravity(useGravity);
 	}
+
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
+		physics.UseBroadPhase(!physics.UsingBroadPhase());
+		std::cout << "Setting broadphase to " << physics.UsingBroadPhase() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
+		physics.UseSimpleContainer(!physics.UsingSimpleContainer());
+		std::cout << "Setting broad container to " << physics.UsingSimpleContainer() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
+		physics.SetSolverIterations(physics.GetSolverIterations() - 1);
+		std::cout << "Setting solver iterations to " << physics.GetSolverIterations() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
+		physics.SetSolverIterations(physics.GetSolverIterations() + 1);
+		std::cout << "Setting solver iterations to " << physics.GetSolverIterations() << std::endl;
+	}
 	
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F9)) {
 		world.ShuffleConstraints(true);
@@ -272,30 +306,19 @@ void TutorialGame::UpdateGame(float dt) {
 	if (playerObject) {
 		Vector3 playerPos = playerObject->GetTransform().GetPosition();
 		float collectDist = 3.0f;                    // 碰撞判定距离，可以改大/改小
-		float collectDistSq = collectDist * collectDist;
-
-		for (auto it = bonusItems.begin(); it != bonusItems.end(); ) {
-			GameObject* ball = *it;
-
-			if (!ball) {
-				it = bonusItems.erase(it);
-				continue;
-			}
 
-			Vector3 diff = ball->GetTransform().GetPosition() - playerPos;
-
-			// 注意：NCL 的 Vector3 没有 .LengthSquared()，要用 Vector::LengthSquared
-			if (Vector::LengthSquared(diff) < collectDistSq) {
-				// 吃到球！
-				score++;
-				// 从物理世界移除这个球
-				world.RemoveGameObject(ball, true);  // 如果编译报错，看看 RemoveGameObject 的签名改一下参数
-
-				it = bonusItems.erase(it);
-			}
-			else {
-				++it;
-			}
+		//Only the balls near the player are looked at, via the physics trees
+		const int maxCollected = 16;
+		GameObject* collected[maxCollected];
+		int count = world.FindNearest(playerPos, collected, maxCollected, collectDist, LayerBonus);
+
+		for (int i = 0; i < count; ++i) {
+			GameObject* ball = collected[i];
+			// 吃到球！
+			score++;
+			bonusItems.erase(std::find(bonusItems.begin(), bonusItems.end(), ball));
+			// 从物理世界移除这个球
+			world.RemoveGameObject(ball, true);
 		}
 	}
 	UpdateEnemies(dt);
@@ -305,6 +328,9 @@ void TutorialGame::UpdateGame(float dt) {
 			o->Update(dt);
 		}
 	);
+	if (showProfiler) {
+		physics.GetProfiler().DrawOverlay(Vector2(5, 20));
+	}
 	if (showMiniMap) {
 		DrawMiniMap();
 	}
@@ -409,11 +435,24 @@ void TutorialGame::InitWorld() {
 		for (int x = 0; x < (int)mazeData[z].size(); ++x) {
 			if (mazeData[z][x] == 1) {
 				Vector3 pos = Vector3(x * cellSize, wallHeight, z * cellSize);
-				AddCubeToWorld(pos, dims, 0.0f);
+				AddCubeToWorld(pos, dims, 0.0f, true);
 			}
 		}
 	}
 
+	//The enemies find their way over the same cells the walls were built from
+	delete playerFlow;
+	delete mazeGrid;
+
+	std::vector<char> mazeTypes;
+	for (const std::vector<int>& row : mazeData) {
+		for (int cell : row) {
+			mazeTypes.push_back(cell == 1 ? 'x' : '.');
+		}
+	}
+	mazeGrid	= new NavigationGrid((int)mazeData[0].size(), (int)mazeData.size(), (int)cellSize, mazeTypes);
+	playerFlow	= new FlowField(*mazeGrid);
+
 	// ---- 地板 ----
 	float totalSizeX = mazeData[0].size() * cellSize;
 	float totalSizeZ = mazeData.size() * cellSize;
@@ -443,8 +482,6 @@ void TutorialGame::InitWorld() {
 		EnemyInfo info;
 		info.object = e;
 		info.hitCooldown = 0.0f;
-		info.pathIndex = 0;
-		info.repathTimer = 0.0f;
 		enemies.push_back(info);
 	}
 
@@ -492,24 +529,23 @@ void TutorialGame::DrawMiniMap() {
 	float startY = 5.0f;
 	float lineStep = 1.2f;
 
+	//Mark each ball's cell once, rather than searching every ball for every cell
+	miniMapBalls.assign(W * H, 0);
+	for (auto b : bonusItems) {
+		Vector3 bp = b->GetTransform().GetPosition();
+		int bx = (int)std::round(bp.x / mazeCellSize);
+		int bz = (int)std::round(bp.z / mazeCellSize);
+		if (bx >= 0 && bx < W && bz >= 0 && bz < H) {
+			miniMapBalls[bz * W + bx] = 1;
+		}
+	}
+
 	for (int z = 0; z < H; ++z) {
 		std::string line;
 		line.reserve(W);
 
 		for (int x = 0; x < W; ++x) {
-			bool hasBallHere = false;
-
-			// 查一下这个格子有没有球
-			for (auto b : bonusItems) {
-				if (!b) continue;
-				Vector3 bp = b->GetTransform().GetPosition();
-				int bx = (int)std::round(bp.x / mazeCellSize);
-				int bz = (int)std::round(bp.z / mazeCellSize);
-				if (bx == x && bz == z) {
-					hasBallHere = true;
-					break;
-				}
-			}
+			bool hasBallHere = miniMapBalls[z * W + x] != 0;
 
 			if (x == px && z == pz) {
 				line.push_back('@');         // 猫
@@ -549,7 +585,8 @@ GameObject* TutorialGame::AddFloorToWorld(const Vector3& position) {
 	floor->GetPhysicsObject()->SetInverseMass(0);
 	floor->GetPhysicsObject()->InitCubeInertia();
 
-	world.AddGameObject(floor);
+	floor->SetCollisionLayer(LayerMaze);
+	world.AddStaticObject(floor);
 
 	return floor;
 }
@@ -586,7 +623,11 @@ GameObject* TutorialGame::AddSphereToWorld(const Vector3& position, float radius
 	return sphere;
 }
 
-GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass) {
+/*
+Static cubes (which should have an inverse mass of 0) go in the world's static
+layer, so must never be moved once added - like the walls of the maze.
+*/
+GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass, bool isStatic) {
 	GameObject* cube = new GameObject();
 
 	AABBVolume* volume = new AABBVolume(dimensions);
@@ -602,7 +643,13 @@ GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimens
 	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
 	cube->GetPhysicsObject()->InitCubeInertia();
 
-	world.AddGameObject(cube);
+	if (isStatic) {
+		cube->SetCollisionLayer(LayerMaze);
+		world.AddStaticObject(cube);
+	}
+	else {
+		world.AddGameObject(cube);
+	}
 
 	return cube;
 }
@@ -625,8 +672,9 @@ GameObject* TutorialGame::AddPlayerToWorld(const Vector3& position) {
 	character->SetPhysicsObject(new PhysicsObject(character->GetTransform(), character->GetBoundingVolume()));
 
 	character->GetPhysicsObject()->SetInverseMass(inverseMass);
+	character->GetPhysicsObject()->SetContinuousCollision(true); //Can be pushed fast enough to pass through the maze walls
 	
-	
+	character->SetCollisionLayer(LayerPlayer);
 
 	world.AddGameObject(character);
 
@@ -653,6 +701,10 @@ GameObject* TutorialGame::AddEnemyToWorld(const Vector3& position) {
 	character->GetPhysicsObject()->SetInverseMass(inverseMass);
 	character->GetPhysicsObject()->InitSphereInertia();
 
+	//Enemies walk straight through each other, rather than getting stuck in the corridors
+	character->SetCollisionLayer(LayerEnemy);
+	character->SetCollisionMask(~LayerEnemy);
+
 	world.AddGameObject(character);
 
 	return character;
@@ -678,6 +730,11 @@ GameObject* TutorialGame::AddBonusToWorld(const Vector3& position) {
 	// 静态物体不用惯性张量，可以不调
 	// apple->GetPhysicsObject()->InitSphereInertia();
 
+	//Only the player can pick bonuses up, and walks through them to do so
+	apple->SetCollisionLayer(LayerBonus);
+	apple->SetCollisionMask(LayerPlayer);
+	apple->SetTrigger(true);
+
 	world.AddGameObject(apple);
 	return apple;
 }
@@ -903,12 +960,12 @@ void TutorialGame::DebugObjectMovement() {
 
 
 void TutorialGame::BridgeConstraintTest() {
-	Vector3 cubeSize = Vector3(2, 2, 2);    // 方块半尺寸（实际大小 4x4x4）
+	Vector3 cubeSize = Vector3(0.5f, 0.5f, 0.5f);    // 方块半尺寸（实际大小 1x1x1）
 
 	float invCubeMass = 1.0f;              // 中间节点的“逆质量” (1/mass)
-	int   numLinks = 10;                // 中间方块数量
-	float cubeDistance = 10.0f;             // 相邻方块之间的距离
-	float maxDistance = 12.0f;             // 约束允许的最大距离（略大于 cubeDistance）
+	int   numLinks = 200;               // 中间方块数量
+	float cubeDistance = 2.0f;              // 相邻方块之间的距离
+	float maxDistance = cubeDistance;       // 约束距离（与间距相同，桥在重力下自然下垂）
 
 	// 把桥放在原点附近，略微高于地板（地板 y = -20）
 	Vector3 startPos = Vector3(-50, 30, 0);  // 从左往右拉一条链子
@@ -983,119 +1040,6 @@ void TutorialGame::ClearWorldForMenu() {
 	// 相机调成主菜单视角（随便给一个你喜欢的）
 	InitCamera();
 }
-bool TutorialGame::FindPathInMazeAStar(const Vector3& startPos,
-	const Vector3& endPos,
-	std::vector<Vector3>& outPath) {
-	outPath.clear();
-	if (mazeData.empty()) return false;
-
-	int H = (int)mazeData.size();
-	int W = (int)mazeData[0].size();
-
-	auto WorldToCell = [&](const Vector3& p, int& cx, int& cz) {
-		cx = (int)std::round(p.x / mazeCellSize);
-		cz = (int)std::round(p.z / mazeCellSize);
-		cx = std::max(0, std::min(cx, W - 1));
-		cz = std::max(0, std::min(cz, H - 1));
-		};
-
-	int sx, sz, ex, ez;
-	WorldToCell(startPos, sx, sz);
-	WorldToCell(endPos, ex, ez);
-
-	// 起点或终点在墙里就直接失败
-	if (mazeData[sz][sx] == 1 || mazeData[ez][ex] == 1) {
-		return false;
-	}
-
-	struct Node {
-		int x, z;
-		float f, g;
-	};
-	struct Cmp {
-		bool operator()(const Node& a, const Node& b) const {
-			return a.f > b.f;   // 小顶堆
-		}
-	};
-
-	const float INF = 1e9f;
-	std::vector<std::vector<float>> gCost(H, std::vector<float>(W, INF));
-	std::vector<std::vector<bool>>  closed(H, std::vector<bool>(W, false));
-	std::vector<std::vector<std::pair<int, int>>> parent(
-		H, std::vector<std::pair<int, int>>(W, { -1,-1 })
-	);
-
-	auto heuristic = [&](int x, int z) {
-		// 曼哈顿距离
-		return float(std::abs(x - ex) + std::abs(z - ez));
-		};
-
-	std::priority_queue<Node, std::vector<Node>, Cmp> open;
-
-	gCost[sz][sx] = 0.0f;
-	open.push({ sx, sz, heuristic(sx, sz), 0.0f });
-
-	const int dx[4] = { 1, -1, 0, 0 };
-	const int dz[4] = { 0, 0, 1, -1 };
-
-	bool found = false;
-
-	while (!open.empty()) {
-		Node cur = open.top();
-		open.pop();
-
-		int x = cur.x;
-		int z = cur.z;
-
-		if (closed[z][x]) continue;
-		closed[z][x] = true;
-
-		if (x == ex && z == ez) {
-			found = true;
-			break;
-		}
-
-		for (int i = 0; i < 4; ++i) {
-			int nx = x + dx[i];
-			int nz = z + dz[i];
-			if (nx < 0 || nz < 0 || nx >= W || nz >= H) continue;
-			if (mazeData[nz][nx] == 1) continue;   // 墙，不能走
-			if (closed[nz][nx]) continue;
-
-			float newG = gCost[z][x] + 1.0f;       // 网格，每步代价为 1
-			if (newG < gCost[nz][nx]) {
-				gCost[nz][nx] = newG;
-				parent[nz][nx] = { x, z };
-				float f = newG + heuristic(nx, nz);
-				open.push({ nx, nz, f, newG });
-			}
-		}
-	}
-
-	if (!found) return false;
-
-	// 回溯路径（格子坐标）
-	std::vector<std::pair<int, int>> cells;
-	int cx = ex, cz = ez;
-	while (!(cx == sx && cz == sz)) {
-		cells.emplace_back(cx, cz);
-		auto p = parent[cz][cx];
-		if (p.first == -1 && p.second == -1) break;
-		cx = p.first;
-		cz = p.second;
-	}
-	cells.emplace_back(sx, sz);
-	std::reverse(cells.begin(), cells.end());
-
-	// 转成世界坐标（稍微抬高一点 Y）
-	outPath.reserve(cells.size());
-	for (auto& c : cells) {
-		int x = c.first;
-		int z = c.second;
-		outPath.emplace_back(x * mazeCellSize, 3.0f, z * mazeCellSize);
-	}
-	return true;
-}
 //void TutorialGame::UpdateEnemies(float dt) {
 //	if (!playerObject) return;
 //
@@ -1166,10 +1110,16 @@ bool TutorialGame::FindPathInMazeAStar(const Vector3& startPos,
 //	}
 //}
 void TutorialGame::UpdateEnemies(float dt) {
-	if (!playerObject) return;
+	if (!playerObject || !playerFlow) return;
 
 	Vector3 playerPos = playerObject->GetTransform().GetPosition();
 
+	//The walls are centred on their cells, but the grid counts a cell as starting at its corner
+	Vector3 halfCell = Vector3(mazeCellSize * 0.5f, 0.0f, mazeCellSize * 0.5f);
+
+	//Every enemy reads the same field, which only needs patching when the player moves into another cell
+	playerFlow->SetGoal(playerPos + halfCell);
+
 	const float moveSpeed = 8.0f;   // 敌人移动速度
 	const float arriveDist = 0.5f;   // 到达路径点的判定距离（调大一点，避免抖动原地）
 	const float arriveDistSq = arriveDist * arriveDist;
@@ -1177,7 +1127,6 @@ void TutorialGame::UpdateEnemies(float dt) {
 	const float hitDistance = 3.0f;   // 与玩家的“碰撞伤害距离”
 	const float hitDistSq = hitDistance * hitDistance;
 
-	const float repathTime = 0.8f;   // 多久重新寻路一次（调大避免频繁重算）
 	const float hitCooldownT = 1.0f;   // 扣分冷却时间
 
 	for (auto& e : enemies) {
@@ -1190,29 +1139,19 @@ void TutorialGame::UpdateEnemies(float dt) {
 			e.hitCooldown -= dt;
 		}
 
-		// 定期 + 必要时重新寻路
-		e.repathTimer -= dt;
-		if (e.repathTimer <= 0.0f ||
-			e.path.empty() ||
-			e.pathIndex >= (int)e.path.size()) {
-
-			std::vector<Vector3> newPath;
-			if (FindPathInMazeAStar(enemyPos, playerPos, newPath)) {
-				e.path = std::move(newPath);
-				e.pathIndex = 0;
-			}
-			e.repathTimer = repathTime;   // 不管成不成功，下一次再尝试
+		//Walks from cell centre to cell centre, only asking the way once it's reached one, so it never cuts a corner
+		if (!e.hasTarget) {
+			e.hasTarget = playerFlow->GetNextStep(enemyPos + halfCell, e.target);
 		}
 
 		// === 按路径移动（不用 AddForce，不参与物理推墙） ===
-		if (!e.path.empty() && e.pathIndex < (int)e.path.size()) {
-			Vector3 target = e.path[e.pathIndex];
-			Vector3 toTarget = target - enemyPos;
+		if (e.hasTarget) {
+			Vector3 toTarget = e.target - enemyPos;
 			toTarget.y = 0.0f;
 
 			if (Vector::LengthSquared(toTarget) < arriveDistSq) {
 				// 够近了，切换到下一个路径点
-				e.pathIndex++;
+				e.hasTarget = false;
 			}
 			else {
 				Vector3 dir = Vector::Normalise(toTarget);
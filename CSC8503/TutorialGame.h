@@ -1,6 +1,7 @@
 #pragma once
 #include "RenderObject.h"
 #include "StateGameObject.h"
+#include "FlowField.h"
 namespace NCL {
 	class Controller;
 
@@ -29,30 +30,38 @@ namespace NCL {
 			void SaveHighScore(int newScore);
 			std::vector<int> LoadHighScores();
 		protected:
+			//Collision layer bits - see GameObject::SetCollisionLayer
+			enum CollisionLayers {
+				LayerDefault	= 1,
+				LayerMaze		= 2,
+				LayerPlayer		= 4,
+				LayerEnemy		= 8,
+				LayerBonus		= 16
+			};
+
 			struct EnemyInfo {
 				GameObject* object = nullptr;     // ˱
 				float hitCooldown = 0.0f;        // ÿο۷ֺȴʱ
-				std::vector<Vector3> path;       // ǰ A* ·꣩
-				int pathIndex = 0;               // ߵ·еĵڼ
-				float repathTimer = 0.0f;        // ʱ·
+				Vector3 target;					//The cell it's walking to, one step along the flow field
+				bool hasTarget = false;
 			};
-			bool FindPathInMazeAStar(const Vector3& startPos,
-				const Vector3& endPos,
-				std::vector<Vector3>& outPath);
-
 			void UpdateEnemies(float dt);
 			std::vector<EnemyInfo> enemies;
 			void InitCamera();
 			void InitWorld();
 			std::vector<std::vector<int>> mazeData;
 			float mazeCellSize = 2.0f;
+			NavigationGrid*		mazeGrid	= nullptr;
+			FlowField*			playerFlow	= nullptr;
 			bool gameStarted = false;
 			bool gameOver = false;
 			float gameTimer = 60.0f;
 			bool showMiniMap = false;   // ǷʾСͼ
+			bool showProfiler = false;	//Physics timings and counters, down the left
 			std::vector<GameObject*> bonusItems; 
 			int score = 0;
 			void DrawMiniMap();
+			std::vector<char> miniMapBalls;	//Which maze cells have a ball in, rebuilt each time the minimap is drawn
 			/*
 			These are some of the world/object creation functions I created when testing the functionality
 			in the module. Feel free to mess around with them to see different objects being created in different
@@ -71,7 +80,7 @@ namespace NCL {
 			GameObject* playerObject = nullptr;
 			GameObject* AddFloorToWorld(const NCL::Maths::Vector3& position);
 			GameObject* AddSphereToWorld(const NCL::Maths::Vector3& position, float radius, float inverseMass = 10.0f);
-			GameObject* AddCubeToWorld(const NCL::Maths::Vector3& position, NCL::Maths::Vector3 dimensions, float inverseMass = 10.0f);
+			GameObject* AddCubeToWorld(const NCL::Maths::Vector3& position, NCL::Maths::Vector3 dimensions, float inverseMass = 10.0f, bool isStatic = false);
 
 			GameObject* AddPlayerToWorld(const NCL::Maths::Vector3& position);
 			GameObject* AddEnemyToWorld(const NCL::Maths::Vector3& position);
@@ -0,0 +1,17 @@
+#include "BallSocketConstraint.h"
+#include "GameObject.h"
+using namespace NCL;
+using namespace Maths;
+using namespace CSC8503;
+
+BallSocketConstraint::BallSocketConstraint(GameObject* a, GameObject* b, const Vector3& worldAnchor) : Constraint(ConstraintType::BallSocket)
+{
+	objectA = a;
+	objectB = b;
+
+	const Transform& transformA = a->GetTransform();
+	const Transform& transformB = b->GetTransform();
+	anchorA = transformA.GetOrientation().Conjugate() * (worldAnchor - transformA.GetPosition());
+	anchorB = transformB.GetOrientation().Conjugate() * (worldAnchor - transformB.GetPosition());
+}
+
@@ -0,0 +1,41 @@
+#pragma once
+#include "Constraint.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		class GameObject;
+
+		/*
+		Pins a point on one object to a point on another, leaving them free to
+		swing and twist around it - a shoulder, or the links of a chain that
+		should hang from their ends rather than their middles. The anchor is
+		given in world space, and stays fixed to each object from then on.
+		Solved in bulk by the ConstraintSolver.
+		*/
+		class BallSocketConstraint : public Constraint
+		{
+			friend class ConstraintSolver;
+		public:
+			BallSocketConstraint(GameObject* a, GameObject* b, const Vector3& worldAnchor);
+			~BallSocketConstraint() = default;
+
+			GameObject* GetObjectA() const override {
+				return objectA;
+			}
+
+			GameObject* GetObjectB() const override {
+				return objectB;
+			}
+
+		protected:
+			GameObject* objectA;
+			GameObject* objectB;
+
+			Vector3 anchorA;	//The anchor in each object's space
+			Vector3 anchorB;
+			Vector3 impulse;	//Built up by the solver, and carried across steps to warm start it
+		};
+	}
+}
+
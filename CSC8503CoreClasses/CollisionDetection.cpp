@@ -3,6 +3,7 @@
 #include "AABBVolume.h"
 #include "OBBVolume.h"
 #include "SphereVolume.h"
+#include "ConvexCollision.h"
 #include "Window.h"
 #include "Maths.h"
 #include "Debug.h"
@@ -144,8 +145,57 @@ bool CollisionDetection::RaySphereIntersection(const Ray&r, const Transform& wor
 	return true;
 }
 
+/*
+A capsule is a cylinder with a sphere on each end, so the ray hits whichever
+of those it reaches first - as long as the cylinder hit is between the ends.
+*/
 bool CollisionDetection::RayCapsuleIntersection(const Ray& r, const Transform& worldTransform, const CapsuleVolume& volume, RayCollision& collision) {
-	return false;
+	Vector3 up			= Quaternion::RotationMatrix<Matrix3>(worldTransform.GetOrientation()) * Vector3(0, 1, 0);
+	float	radius		= volume.GetRadius();
+	float	lineLength	= std::max(0.0f, volume.GetHalfHeight() - radius) * 2.0f;
+	Vector3 bottom		= worldTransform.GetPosition() - up * (lineLength * 0.5f);
+
+	Vector3 rayPos	= r.GetPosition();
+	Vector3 rayDir	= r.GetDirection();
+	float	bestT	= FLT_MAX;
+
+	//The ray and its start point, with everything along the capsule's line taken out
+	Vector3 flatDir		= rayDir - up * Vector::Dot(rayDir, up);
+	Vector3 flatStart	= (rayPos - bottom) - up * Vector::Dot(rayPos - bottom, up);
+
+	float a = Vector::Dot(flatDir, flatDir);
+	float b = 2.0f * Vector::Dot(flatDir, flatStart);
+	float c = Vector::Dot(flatStart, flatStart) - radius * radius;
+	float discriminant = b * b - 4.0f * a * c;
+
+	if (a > 0.0f && discriminant >= 0.0f) {
+		float t		 = (-b - sqrt(discriminant)) / (2.0f * a);
+		float height = Vector::Dot(rayPos + rayDir * t - bottom, up);
+		if (t >= 0.0f && height >= 0.0f && height <= lineLength) {
+			bestT = t;
+		}
+	}
+
+	Vector3 ends[2] = { bottom, bottom + up * lineLength };
+	for (const Vector3& centre : ends) {
+		Vector3 dir		= centre - rayPos;
+		float	proj	= Vector::Dot(dir, rayDir);
+		float	distSq	= Vector::Dot(dir, dir) - proj * proj;
+		if (distSq > radius * radius) {
+			continue;
+		}
+		float t = proj - sqrt(radius * radius - distSq);
+		if (t >= 0.0f && t < bestT) {
+			bestT = t;
+		}
+	}
+
+	if (bestT == FLT_MAX) {
+		return false;
+	}
+	collision.rayDistance	= bestT;
+	collision.collidedAt	= rayPos + rayDir * bestT;
+	return true;
 }
 
 bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo) {
@@ -156,8 +206,13 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return false;
 	}
 
+	//A separating axis remembered from last time points from whichever object was a then
+	if (collisionInfo.hasSeparatingAxis && collisionInfo.a != a) {
+		collisionInfo.separatingAxis = -collisionInfo.separatingAxis;
+	}
 	collisionInfo.a = a;
 	collisionInfo.b = b;
+	collisionInfo.pointCount = 0;
 
 	Transform& transformA = a->GetTransform();
 	Transform& transformB = b->GetTransform();
@@ -177,14 +232,16 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return OBBIntersection((OBBVolume&)*volA, transformA, (OBBVolume&)*volB, transformB, collisionInfo);
 	}
 	//Two Capsules
+	if (pairType == VolumeType::Capsule) {
+		return CapsuleIntersection((CapsuleVolume&)*volA, transformA, (CapsuleVolume&)*volB, transformB, collisionInfo);
+	}
 
 	//AABB vs Sphere pairs
 	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
 		return AABBSphereIntersection((AABBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		collisionInfo.Swap();
 		return AABBSphereIntersection((AABBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
@@ -193,8 +250,7 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return OBBSphereIntersection((OBBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::OBB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		collisionInfo.Swap();
 		return OBBSphereIntersection((OBBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
@@ -203,8 +259,7 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return SphereCapsuleIntersection((CapsuleVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Capsule) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		collisionInfo.Swap();
 		return SphereCapsuleIntersection((CapsuleVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
@@ -212,11 +267,15 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return AABBCapsuleIntersection((CapsuleVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volB->type == VolumeType::Capsule && volA->type == VolumeType::AABB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		collisionInfo.Swap();
 		return AABBCapsuleIntersection((CapsuleVolume&)*volB, transformB, (AABBVolume&)*volA, transformA, collisionInfo);
 	}
 
+	//Everything else left (OBBs against AABBs and capsules) is still a pair of convex shapes
+	const int convexTypes = (int)VolumeType::AABB | (int)VolumeType::OBB | (int)VolumeType::Sphere | (int)VolumeType::Capsule;
+	if (((int)pairType & ~convexTypes) == 0) {
+		return ConvexIntersection(*volA, transformA, *volB, transformB, collisionInfo);
+	}
 	return false;
 }
 
@@ -224,9 +283,9 @@ bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, cons
 	Vector3 delta = posB - posA;
 	Vector3 totalSize = halfSizeA + halfSizeB;
 
-	if (abs(delta.x) < totalSize.x &&
-		abs(delta.y) < totalSize.y &&
-		abs(delta.z) < totalSize.z) {
+	if (std::abs(delta.x) < totalSize.x &&
+		std::abs(delta.y) < totalSize.y &&
+		std::abs(delta.z) < totalSize.z) {
 		return true;
 	}
 	return false;
@@ -268,22 +327,57 @@ bool CollisionDetection::AABBIntersection(const AABBVolume& volumeA, const Trans
 		};
 
 		float penetration = FLT_MAX;
-		Vector3 bestAxis;
+		int bestFace = 0;
 
 		for (int i = 0; i < 6; i++) {
 			if (distances[i] < penetration) {
 				penetration = distances[i];
-				bestAxis = faces[i];
+				bestFace = i;
 			}
 		}
 
-		collisionInfo.AddContactPoint(Vector3(), Vector3(), bestAxis, penetration);
+		AddAABBContactFace(boxAPos, boxASize, boxBPos, boxBSize, bestFace / 2, faces[bestFace], penetration, collisionInfo);
 		return true;
 	}
 
 	return false;
 }
 
+/*
+The boxes' overlap, seen along the collision axis, is a rectangle - its corners,
+halfway through the penetration, make up the contact manifold. If the rectangle
+has collapsed down to an edge or a point, the doubled up corners are dropped.
+*/
+void CollisionDetection::AddAABBContactFace(const Vector3& posA, const Vector3& halfSizeA, const Vector3& posB, const Vector3& halfSizeB,
+											int axis, const Vector3& normal, float penetration, CollisionInfo& collisionInfo) {
+	const float minExtent = 0.001f;
+
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+
+	float side	= normal[axis];
+	float plane = ((posA[axis] + halfSizeA[axis] * side) + (posB[axis] - halfSizeB[axis] * side)) * 0.5f;
+
+	float uMin = std::max(posA[u] - halfSizeA[u], posB[u] - halfSizeB[u]);
+	float uMax = std::min(posA[u] + halfSizeA[u], posB[u] + halfSizeB[u]);
+	float vMin = std::max(posA[v] - halfSizeA[v], posB[v] - halfSizeB[v]);
+	float vMax = std::min(posA[v] + halfSizeA[v], posB[v] + halfSizeB[v]);
+
+	int uCount = (uMax - uMin) > minExtent ? 2 : 1;
+	int vCount = (vMax - vMin) > minExtent ? 2 : 1;
+
+	for (int i = 0; i < uCount; ++i) {
+		for (int j = 0; j < vCount; ++j) {
+			Vector3 p;
+			p[axis] = plane;
+			p[u]	= uCount == 2 ? (i == 0 ? uMin : uMax) : (uMin + uMax) * 0.5f;
+			p[v]	= vCount == 2 ? (j == 0 ? vMin : vMax) : (vMin + vMax) * 0.5f;
+
+			collisionInfo.AddContactPoint(p - posA, p - posB, normal, penetration);
+		}
+	}
+}
+
 //Sphere / Sphere Collision
 bool CollisionDetection::SphereIntersection(const SphereVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
@@ -333,24 +427,58 @@ bool CollisionDetection::AABBSphereIntersection(const AABBVolume& volumeA, const
 
 bool  CollisionDetection::OBBSphereIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo);
 }
 
 bool CollisionDetection::AABBCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo);
 }
 
 bool CollisionDetection::SphereCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo);
 }
 
 bool CollisionDetection::OBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 	const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo);
+}
+
+bool CollisionDetection::CapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA,
+	const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	return ConvexIntersection(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo);
+}
+
+/*
+The separating axis that last kept the pair apart is tried first, as objects
+don't move far between frames - if it still works, that's the whole test.
+Otherwise, whichever test ran gives a new one to try next time.
+*/
+bool CollisionDetection::ConvexIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	ConvexShape shapeA(volumeA, worldTransformA);
+	ConvexShape shapeB(volumeB, worldTransformB);
+
+	if (collisionInfo.hasSeparatingAxis && ConvexCollision::SeparatedOnAxis(shapeA, shapeB, collisionInfo.separatingAxis)) {
+		return false;
+	}
+	Vector3 axis = collisionInfo.hasSeparatingAxis ? collisionInfo.separatingAxis : shapeB.GetPosition() - shapeA.GetPosition();
+
+	ConvexCollision::Contact contact;
+	bool hit = (shapeA.IsBox() && shapeB.IsBox()) ?
+		ConvexCollision::BoxIntersection(shapeA, shapeB, axis, contact) :
+		ConvexCollision::GJKIntersection(shapeA, shapeB, axis, contact);
+
+	collisionInfo.hasSeparatingAxis = !hit;
+	if (!hit) {
+		collisionInfo.separatingAxis = axis;
+		return false;
+	}
+	ConvexCollision::AddManifold(shapeA, shapeB, contact, collisionInfo);
+	return true;
 }
 
 Matrix4 GenerateInverseView(const Camera &c) {
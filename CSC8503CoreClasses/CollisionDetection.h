@@ -19,27 +19,53 @@ namespace NCL {
 	{
 	public:
 		struct ContactPoint {
-			Vector3 localA;
+			Vector3 localA;		//Offsets from each object's centre, in world space
 			Vector3 localB;
 			Vector3 normal;
 			float	penetration;
+
+			//Built up by the solver, and carried across frames to warm start it
+			float	normalImpulse		= 0.0f;
+			float	tangentImpulse[2]	= { 0.0f, 0.0f };
 		};
 		struct CollisionInfo {
+			static const int MaxContactPoints = 4;
+
 			GameObject* a;
 			GameObject* b;		
 			int		framesLeft;
 
-			ContactPoint point;
+			ContactPoint	points[MaxContactPoints];
+			int				pointCount = 0;
+
+			//The last axis (from a to b) found to separate the pair, if it has been
+			//tested before - it'll usually still separate them, so is tried first
+			Vector3			separatingAxis;
+			bool			hasSeparatingAxis = false;
 
 			CollisionInfo() {
 
 			}
 
+			//Swaps which object is a and which is b
+			void Swap() {
+				std::swap(a, b);
+				separatingAxis = -separatingAxis;
+			}
+
+			//Any points past MaxContactPoints are ignored
 			void AddContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p) {
-				point.localA		= localA;
-				point.localB		= localB;
-				point.normal		= normal;
-				point.penetration	= p;
+				if (pointCount == MaxContactPoints) {
+					return;
+				}
+				ContactPoint& point = points[pointCount++];
+				point.localA			= localA;
+				point.localB			= localB;
+				point.normal			= normal;
+				point.penetration		= p;
+				point.normalImpulse		= 0.0f;
+				point.tangentImpulse[0] = 0.0f;
+				point.tangentImpulse[1] = 0.0f;
 			}
 
 			//Advanced collision detection / resolution
@@ -91,6 +117,10 @@ namespace NCL {
 		static bool AABBIntersection(	const AABBVolume& volumeA, const Transform& worldTransformA,
 										const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 
+		//Adds the corners of the face where two overlapping boxes meet, across the given axis (0 - 2)
+		static void AddAABBContactFace(const Vector3& posA, const Vector3& halfSizeA, const Vector3& posB, const Vector3& halfSizeB,
+										int axis, const Vector3& normal, float penetration, CollisionInfo& collisionInfo);
+
 		static bool SphereIntersection(	const SphereVolume& volumeA, const Transform& worldTransformA,
 										const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 
@@ -104,6 +134,13 @@ namespace NCL {
 		static bool OBBSphereIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 			const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 
+		static bool CapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA,
+			const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		//Any pair of boxes, spheres and capsules, using GJK / EPA (or SAT for two boxes)
+		static bool ConvexIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
 
 		static Vector3 Unproject(const Vector3& screenPos, const PerspectiveCamera& cam);
 
@@ -2,13 +2,44 @@
 
 namespace NCL {
 	namespace CSC8503 {
+		class GameObject;
+
+		/*
+		Constraints of a type the ConstraintSolver knows about are copied into
+		its arrays and solved there, in bulk, each step. Anything else is left
+		as Custom, and solved by calling UpdateConstraint once per iteration.
+		*/
+		enum class ConstraintType {
+			Custom,
+			Distance,
+			BallSocket,
+			Orientation
+		};
+
 		class Constraint	
 		{
 		public:
-			Constraint() {}
+			Constraint(ConstraintType t = ConstraintType::Custom) : type(t) {}
 			virtual ~Constraint() = default;
 
-			virtual void UpdateConstraint(float dt) = 0;
+			virtual void UpdateConstraint(float dt) {}
+
+			ConstraintType GetType() const {
+				return type;
+			}
+
+			//The objects the constraint acts upon, so the PhysicsSystem knows which
+			//island to solve it in. Constraints that don't say are solved last, alone.
+			virtual GameObject* GetObjectA() const {
+				return nullptr;
+			}
+
+			virtual GameObject* GetObjectB() const {
+				return nullptr;
+			}
+
+		protected:
+			ConstraintType type;
 		};
 	}
 }
\ No newline at end of file
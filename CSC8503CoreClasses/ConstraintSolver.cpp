@@ -0,0 +1,394 @@
+#include "ConstraintSolver.h"
+#include "PositionConstraint.h"
+#include "BallSocketConstraint.h"
+#include "OrientationConstraint.h"
+#include "PhysicsObject.h"
+#include "GameObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const float JointFrequency		= 60.0f;	//How stiff the constraints are, as a spring (in hertz)
+	const float JointDampingRatio	= 2.0f;		//Over damped, so they settle rather than ring
+
+	const int ColourCount	= 32;				//One per bit of a body's colour mask
+	const int SerialColour	= ColourCount - 1;	//Rows that don't fit any other colour end up here
+	const int RowGrainSize	= 256;
+
+	//Any two axes perpendicular to n - always the same two for the same n
+	void TangentBasis(const Vector3& n, Vector3& t1, Vector3& t2) {
+		if (std::abs(n.x) >= 0.57735f) {
+			t1 = Vector::Normalise(Vector3(n.y, -n.x, 0.0f));
+		}
+		else {
+			t1 = Vector::Normalise(Vector3(0.0f, n.z, -n.y));
+		}
+		t2 = Vector::Cross(n, t1);
+	}
+
+	float InverseOrZero(float f) {
+		return f > 0.0f ? 1.0f / f : 0.0f;
+	}
+}
+
+void ConstraintSolver::Reset(int bodyCount) {
+	distanceRows.clear();
+	ballSocketRows.clear();
+	orientationRows.clear();
+	bodyColours.assign(bodyCount, 0);
+}
+
+bool ConstraintSolver::Add(Constraint* c, int bodyA, int bodyB) {
+	switch (c->GetType()) {
+		case ConstraintType::Distance: {
+			DistanceRow row;
+			if (SetBodies(row, c, bodyA, bodyB)) {
+				row.owner = (PositionConstraint*)c;
+				distanceRows.emplace_back(row);
+			}
+		}break;
+		case ConstraintType::BallSocket: {
+			BallSocketRow row;
+			if (SetBodies(row, c, bodyA, bodyB)) {
+				row.owner = (BallSocketConstraint*)c;
+				ballSocketRows.emplace_back(row);
+			}
+		}break;
+		case ConstraintType::Orientation: {
+			OrientationRow row;
+			if (SetBodies(row, c, bodyA, bodyB)) {
+				row.owner = (OrientationConstraint*)c;
+				orientationRows.emplace_back(row);
+			}
+		}break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+//Constraints joining an object without any physics have nothing to push against, and are dropped
+bool ConstraintSolver::SetBodies(BodyPair& pair, Constraint* c, int bodyA, int bodyB) {
+	pair.physA = c->GetObjectA()->GetPhysicsObject();
+	pair.physB = c->GetObjectB()->GetPhysicsObject();
+	if (!pair.physA || !pair.physB) {
+		return false;
+	}
+	pair.bodyA		= bodyA;
+	pair.bodyB		= bodyB;
+	pair.invMassA	= bodyA >= 0 ? pair.physA->GetInverseMass() : 0.0f;
+	pair.invMassB	= bodyB >= 0 ? pair.physB->GetInverseMass() : 0.0f;
+	if (pair.invMassA + pair.invMassB == 0.0f) {
+		return false;
+	}
+	pair.invInertiaA = pair.invMassA > 0.0f ? pair.physA->GetInertiaTensor() : Matrix::Scale3x3(Vector3());
+	pair.invInertiaB = pair.invMassB > 0.0f ? pair.physB->GetInertiaTensor() : Matrix::Scale3x3(Vector3());
+	return true;
+}
+
+/*
+Constraints are treated as very stiff, heavily damped springs (soft
+constraints), rather than pushing a fixed fraction of their error back out
+each step. The spring's stiffness and damping turn into how much of the
+error to correct (biasRate), how much of each impulse to apply (massScale),
+and how much of the built up impulse to let go of each iteration
+(impulseScale). Without that last part, warm starting a long chain keeps
+reapplying the error correction it has already done, and feeds energy in.
+*/
+void ConstraintSolver::PreStep(float dt, JobSystem* jobs) {
+	float omega		= 2.0f * PI * JointFrequency;
+	float zeta		= 2.0f * JointDampingRatio + dt * omega;
+	float stiffness = dt * omega * zeta;
+
+	biasRate		= omega / zeta;
+	massScale		= stiffness / (1.0f + stiffness);
+	impulseScale	= 1.0f / (1.0f + stiffness);
+
+	Colour(distanceRows, distanceScratch, distanceColours);
+	Colour(ballSocketRows, ballSocketScratch, ballSocketColours);
+	Colour(orientationRows, orientationScratch, orientationColours);
+
+	ForEachRow(distanceRows, distanceColours, jobs, [&](DistanceRow& row) { PreStep(row); });
+	ForEachRow(ballSocketRows, ballSocketColours, jobs, [&](BallSocketRow& row) { PreStep(row); });
+	ForEachRow(orientationRows, orientationColours, jobs, [&](OrientationRow& row) { PreStep(row); });
+}
+
+void ConstraintSolver::WarmStart(JobSystem* jobs) {
+	ForEachRow(distanceRows, distanceColours, jobs, [&](DistanceRow& row) {
+		ApplyImpulse(row, Vector3(), Vector3(), row.normal * row.impulse);
+	});
+	ForEachRow(ballSocketRows, ballSocketColours, jobs, [&](BallSocketRow& row) {
+		ApplyImpulse(row, row.rA, row.rB, row.impulse);
+	});
+	ForEachRow(orientationRows, orientationColours, jobs, [&](OrientationRow& row) {
+		Vector3 impulse;
+		for (int i = 0; i < row.axisCount; ++i) {
+			impulse += row.axes[i] * row.impulse[i];
+		}
+		ApplyAngularImpulse(row, impulse);
+	});
+}
+
+void ConstraintSolver::Solve(JobSystem* jobs) {
+	ForEachRow(distanceRows, distanceColours, jobs, [&](DistanceRow& row) { Solve(row); });
+	ForEachRow(ballSocketRows, ballSocketColours, jobs, [&](BallSocketRow& row) { Solve(row); });
+	ForEachRow(orientationRows, orientationColours, jobs, [&](OrientationRow& row) { Solve(row); });
+}
+
+void ConstraintSolver::StoreImpulses() {
+	for (const DistanceRow& row : distanceRows) {
+		row.owner->impulse = row.impulse;
+	}
+	for (const BallSocketRow& row : ballSocketRows) {
+		row.owner->impulse = row.impulse;
+	}
+	for (const OrientationRow& row : orientationRows) {
+		Vector3 impulse;
+		for (int i = 0; i < row.axisCount; ++i) {
+			impulse += row.axes[i] * row.impulse[i];
+		}
+		row.owner->impulse = impulse;
+	}
+}
+
+Vector3 ConstraintSolver::GetImpulse(const Constraint* c) {
+	switch (c->GetType()) {
+		case ConstraintType::Distance:
+			return Vector3(((const PositionConstraint*)c)->impulse, 0.0f, 0.0f);
+		case ConstraintType::BallSocket:
+			return ((const BallSocketConstraint*)c)->impulse;
+		case ConstraintType::Orientation:
+			return ((const OrientationConstraint*)c)->impulse;
+		default:
+			return Vector3();
+	}
+}
+
+void ConstraintSolver::SetImpulse(Constraint* c, const Vector3& impulse) {
+	switch (c->GetType()) {
+		case ConstraintType::Distance:
+			((PositionConstraint*)c)->impulse = impulse.x;
+			break;
+		case ConstraintType::BallSocket:
+			((BallSocketConstraint*)c)->impulse = impulse;
+			break;
+		case ConstraintType::Orientation:
+			((OrientationConstraint*)c)->impulse = impulse;
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+Distance constraints act through the objects' centres, so only ever change
+their linear velocities, and the effective mass is just the summed inverse
+masses. Objects that have ended up exactly on top of each other are pushed
+apart along y.
+*/
+void ConstraintSolver::PreStep(DistanceRow& row) {
+	Vector3 offset = row.owner->objectB->GetTransform().GetPosition() - row.owner->objectA->GetTransform().GetPosition();
+	float length = Vector::Length(offset);
+
+	row.normal	= length > 0.0f ? offset / length : Vector3(0, 1, 0);
+	row.mass	= InverseOrZero(row.invMassA + row.invMassB);
+	row.bias	= biasRate * (length - row.owner->distance);
+	row.impulse = row.owner->impulse;
+}
+
+void ConstraintSolver::Solve(DistanceRow& row) {
+	Vector3 relativeVelocity = row.physB->GetLinearVelocity() - row.physA->GetLinearVelocity();
+
+	float lambda = -(Vector::Dot(relativeVelocity, row.normal) + row.bias) * row.mass * massScale - row.impulse * impulseScale;
+	row.impulse += lambda;
+
+	ApplyImpulse(row, Vector3(), Vector3(), row.normal * lambda);
+}
+
+/*
+The anchors can move apart along any axis, so the effective mass is a 3x3
+matrix, built a column at a time from how an impulse along each world axis
+changes their relative velocity - and inverted once here, rather than being
+solved for each iteration.
+*/
+void ConstraintSolver::PreStep(BallSocketRow& row) {
+	const Transform& transformA = row.owner->objectA->GetTransform();
+	const Transform& transformB = row.owner->objectB->GetTransform();
+
+	row.rA = transformA.GetOrientation() * row.owner->anchorA;
+	row.rB = transformB.GetOrientation() * row.owner->anchorB;
+
+	Matrix3 k;
+	for (int i = 0; i < 3; ++i) {
+		Vector3 axis;
+		axis[i] = 1.0f;
+		Vector3 angularA = Vector::Cross(row.invInertiaA * Vector::Cross(row.rA, axis), row.rA);
+		Vector3 angularB = Vector::Cross(row.invInertiaB * Vector::Cross(row.rB, axis), row.rB);
+		k.SetColumn(i, axis * (row.invMassA + row.invMassB) + angularA + angularB);
+	}
+	row.mass = Matrix::Inverse(k);
+
+	Vector3 error = (transformB.GetPosition() + row.rB) - (transformA.GetPosition() + row.rA);
+	row.bias	= error * biasRate;
+	row.impulse = row.owner->impulse;
+}
+
+void ConstraintSolver::Solve(BallSocketRow& row) {
+	Vector3 velocityA = row.physA->GetLinearVelocity() + Vector::Cross(row.physA->GetAngularVelocity(), row.rA);
+	Vector3 velocityB = row.physB->GetLinearVelocity() + Vector::Cross(row.physB->GetAngularVelocity(), row.rB);
+
+	Vector3 lambda = row.mass * -(velocityB - velocityA + row.bias) * massScale - row.impulse * impulseScale;
+	row.impulse += lambda;
+
+	ApplyImpulse(row, row.rA, row.rB, lambda);
+}
+
+/*
+A lock measures how far B has turned away from where A says it should be,
+as a small rotation about each world axis. A hinge only cares that the two
+objects' copies of the hinge axis still line up - the rotation that would
+bring them back together is measured about two axes across the hinge, so
+turning about the hinge itself is left free. Each axis is solved on its own.
+*/
+void ConstraintSolver::PreStep(OrientationRow& row) {
+	const OrientationConstraint& c = *row.owner;
+	Quaternion orientationA = c.objectA->GetTransform().GetOrientation();
+	Quaternion orientationB = c.objectB->GetTransform().GetOrientation();
+
+	Vector3 error;
+	if (c.isHinge) {
+		Vector3 hingeA = orientationA * c.hingeAxisA;
+		Vector3 hingeB = orientationB * c.hingeAxisB;
+
+		TangentBasis(hingeA, row.axes[0], row.axes[1]);
+		row.axisCount = 2;
+
+		Vector3 turn = Vector::Cross(hingeA, hingeB);
+		error = Vector3(Vector::Dot(turn, row.axes[0]), Vector::Dot(turn, row.axes[1]), 0.0f);
+	}
+	else {
+		row.axes[0] = Vector3(1, 0, 0);
+		row.axes[1] = Vector3(0, 1, 0);
+		row.axes[2] = Vector3(0, 0, 1);
+		row.axisCount = 3;
+
+		Quaternion difference = orientationB * (orientationA * c.relativeOrientation).Conjugate();
+		//q and -q are the same rotation - take whichever is the shorter way round
+		float side = difference.w < 0.0f ? -2.0f : 2.0f;
+		error = Vector3(difference.x, difference.y, difference.z) * side;
+	}
+
+	for (int i = 0; i < row.axisCount; ++i) {
+		const Vector3& axis = row.axes[i];
+		row.mass[i]		= InverseOrZero(Vector::Dot(row.invInertiaA * axis + row.invInertiaB * axis, axis));
+		row.bias[i]		= biasRate * error[i];
+		row.impulse[i]	= Vector::Dot(c.impulse, axis);
+	}
+}
+
+void ConstraintSolver::Solve(OrientationRow& row) {
+	for (int i = 0; i < row.axisCount; ++i) {
+		Vector3 relativeVelocity = row.physB->GetAngularVelocity() - row.physA->GetAngularVelocity();
+
+		float lambda = -(Vector::Dot(relativeVelocity, row.axes[i]) + row.bias[i]) * row.mass[i] * massScale - row.impulse[i] * impulseScale;
+		row.impulse[i] += lambda;
+
+		ApplyAngularImpulse(row, row.axes[i] * lambda);
+	}
+}
+
+void ConstraintSolver::ApplyImpulse(const BodyPair& pair, const Vector3& rA, const Vector3& rB, const Vector3& impulse) {
+	if (pair.invMassA > 0.0f) {
+		pair.physA->SetLinearVelocity(pair.physA->GetLinearVelocity() - impulse * pair.invMassA);
+		pair.physA->SetAngularVelocity(pair.physA->GetAngularVelocity() - pair.invInertiaA * Vector::Cross(rA, impulse));
+	}
+	if (pair.invMassB > 0.0f) {
+		pair.physB->SetLinearVelocity(pair.physB->GetLinearVelocity() + impulse * pair.invMassB);
+		pair.physB->SetAngularVelocity(pair.physB->GetAngularVelocity() + pair.invInertiaB * Vector::Cross(rB, impulse));
+	}
+}
+
+void ConstraintSolver::ApplyAngularImpulse(const BodyPair& pair, const Vector3& impulse) {
+	if (pair.invMassA > 0.0f) {
+		pair.physA->SetAngularVelocity(pair.physA->GetAngularVelocity() - pair.invInertiaA * impulse);
+	}
+	if (pair.invMassB > 0.0f) {
+		pair.physB->SetAngularVelocity(pair.physB->GetAngularVelocity() + pair.invInertiaB * impulse);
+	}
+}
+
+/*
+Each row takes the first colour neither of its bodies has been given yet.
+The rows are then counting sorted by colour, which keeps them in the order
+they were added within each colour - so the same constraints always get
+solved in the same order.
+*/
+template<typename Row>
+void ConstraintSolver::Colour(std::vector<Row>& rows, std::vector<Row>& scratch, std::vector<int>& colourStarts) {
+	colourStarts.assign(ColourCount + 1, 0);
+	rowColours.resize(rows.size());
+
+	for (size_t i = 0; i < rows.size(); ++i) {
+		const Row& row = rows[i];
+		uint32_t used = (row.bodyA >= 0 ? bodyColours[row.bodyA] : 0) | (row.bodyB >= 0 ? bodyColours[row.bodyB] : 0);
+
+		int colour = 0;
+		while (colour < SerialColour && (used & (1u << colour))) {
+			colour++;
+		}
+		if (colour < SerialColour) {
+			if (row.bodyA >= 0) {
+				bodyColours[row.bodyA] |= 1u << colour;
+			}
+			if (row.bodyB >= 0) {
+				bodyColours[row.bodyB] |= 1u << colour;
+			}
+		}
+		rowColours[i] = colour;
+		colourStarts[colour + 1]++;
+	}
+	for (int i = 0; i < ColourCount; ++i) {
+		colourStarts[i + 1] += colourStarts[i];
+	}
+	int next[ColourCount];
+	std::copy(colourStarts.begin(), colourStarts.begin() + ColourCount, next);
+
+	scratch.resize(rows.size());
+	for (size_t i = 0; i < rows.size(); ++i) {
+		scratch[next[rowColours[i]]++] = rows[i];
+	}
+	rows.swap(scratch);
+
+	//Leave the masks clear for the next type
+	for (const Row& row : rows) {
+		if (row.bodyA >= 0) {
+			bodyColours[row.bodyA] = 0;
+		}
+		if (row.bodyB >= 0) {
+			bodyColours[row.bodyB] = 0;
+		}
+	}
+}
+
+template<typename Row, typename F>
+void ConstraintSolver::ForEachRow(std::vector<Row>& rows, const std::vector<int>& colourStarts, JobSystem* jobs, F&& func) {
+	for (int colour = 0; colour < ColourCount; ++colour) {
+		int first	= colourStarts[colour];
+		int count	= colourStarts[colour + 1] - first;
+
+		if (!jobs || colour == SerialColour || count <= RowGrainSize) {
+			for (int i = first; i < first + count; ++i) {
+				func(rows[i]);
+			}
+			continue;
+		}
+		jobs->ParallelFor(count, RowGrainSize,
+			[&](int firstRow, int lastRow) {
+				for (int i = first + firstRow; i < first + lastRow; ++i) {
+					func(rows[i]);
+				}
+			});
+	}
+}
+
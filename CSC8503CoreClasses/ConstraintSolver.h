@@ -0,0 +1,139 @@
+#pragma once
+#include "JobSystem.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		class Constraint;
+		class PositionConstraint;
+		class BallSocketConstraint;
+		class OrientationConstraint;
+		class PhysicsObject;
+
+		/*
+		A sequential impulse solver for the built in constraint types, which
+		keeps each type in its own contiguous array of rows - so every
+		iteration is a tight loop over one kind of constraint, rather than a
+		virtual call per constraint. Everything that stays the same while
+		iterating (directions, effective masses, position error) is worked out
+		once per step in PreStep, and the impulse each constraint built up is
+		stored back in it afterwards, to warm start it next step.
+
+		Rows are split up by greedy graph colouring, so that no two rows of the
+		same colour move the same body. Each colour can then be solved across
+		threads, with the same result as solving it on one - static bodies are
+		only ever read from, so don't count. Rows that don't fit any colour
+		go in one final colour, which is solved serially.
+
+		Usage is to Reset with the number of bodies in the store, Add this
+		step's constraints, then PreStep, WarmStart and Solve them, and finally
+		StoreImpulses.
+		*/
+		class ConstraintSolver {
+		public:
+			ConstraintSolver() = default;
+			~ConstraintSolver() = default;
+
+			void Reset(int bodyCount);
+
+			//Body indices are the objects' store indices, or -1 if static.
+			//Returns false for constraints that aren't one of the built in types
+			bool Add(Constraint* c, int bodyA, int bodyB);
+
+			void PreStep(float dt, JobSystem* jobs = nullptr);
+			void WarmStart(JobSystem* jobs = nullptr);
+			//A single iteration over every constraint
+			void Solve(JobSystem* jobs = nullptr);
+			void StoreImpulses();
+
+			//The impulse a constraint has built up, as a vector (distance constraints only use x)
+			static Vector3	GetImpulse(const Constraint* c);
+			static void		SetImpulse(Constraint* c, const Vector3& impulse);
+
+			int GetConstraintCount() const {
+				return (int)(distanceRows.size() + ballSocketRows.size() + orientationRows.size());
+			}
+
+		protected:
+			struct BodyPair {
+				PhysicsObject*	physA;
+				PhysicsObject*	physB;
+				float			invMassA;
+				float			invMassB;
+				Matrix3			invInertiaA;
+				Matrix3			invInertiaB;
+				int				bodyA;
+				int				bodyB;
+			};
+
+			struct DistanceRow : BodyPair {
+				PositionConstraint* owner;
+				Vector3 normal;		//From A to B
+				float	mass;
+				float	bias;
+				float	impulse;
+			};
+
+			struct BallSocketRow : BodyPair {
+				BallSocketConstraint* owner;
+				Vector3 rA;
+				Vector3 rB;
+				Matrix3 mass;
+				Vector3 bias;
+				Vector3 impulse;
+			};
+
+			struct OrientationRow : BodyPair {
+				OrientationConstraint* owner;
+				Vector3 axes[3];
+				float	mass[3];
+				float	bias[3];
+				float	impulse[3];
+				int		axisCount;	//3 for a lock, 2 for a hinge
+			};
+
+			void PreStep(DistanceRow& row);
+			void PreStep(BallSocketRow& row);
+			void PreStep(OrientationRow& row);
+
+			void Solve(DistanceRow& row);
+			void Solve(BallSocketRow& row);
+			void Solve(OrientationRow& row);
+
+			bool SetBodies(BodyPair& pair, Constraint* c, int bodyA, int bodyB);
+
+			//The impulse is applied to B, and the opposite to A
+			static void ApplyImpulse(const BodyPair& pair, const Vector3& rA, const Vector3& rB, const Vector3& impulse);
+			static void ApplyAngularImpulse(const BodyPair& pair, const Vector3& impulse);
+
+			//Sorts rows into contiguous runs of the same colour, filling colourStarts with where each begins
+			template<typename Row>
+			void Colour(std::vector<Row>& rows, std::vector<Row>& scratch, std::vector<int>& colourStarts);
+
+			//Runs func over each row, one colour at a time
+			template<typename Row, typename F>
+			void ForEachRow(std::vector<Row>& rows, const std::vector<int>& colourStarts, JobSystem* jobs, F&& func);
+
+			std::vector<DistanceRow>	distanceRows;
+			std::vector<BallSocketRow>	ballSocketRows;
+			std::vector<OrientationRow> orientationRows;
+
+			//Swapped with the rows as they're sorted, so neither is reallocated each step
+			std::vector<DistanceRow>	distanceScratch;
+			std::vector<BallSocketRow>	ballSocketScratch;
+			std::vector<OrientationRow> orientationScratch;
+
+			std::vector<int>	distanceColours;
+			std::vector<int>	ballSocketColours;
+			std::vector<int>	orientationColours;
+
+			float biasRate		= 0.0f;	//Set up in PreStep from the joint stiffness and damping
+			float massScale		= 1.0f;
+			float impulseScale	= 0.0f;
+
+			std::vector<uint32_t>	bodyColours;	//Bit mask of the colours touching each body
+			std::vector<int>		rowColours;
+		};
+	}
+}
+
@@ -0,0 +1,181 @@
+#include "ContactSolver.h"
+#include "PhysicsObject.h"
+#include "GameObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const float BaumgarteFactor			= 0.2f;		//How much of the penetration to push back out each step
+	const float PenetrationSlop			= 0.01f;	//Allowed overlap, so resting contacts don't jitter
+	const float RestitutionThreshold	= 1.0f;		//Slower impacts than this don't bounce
+	const float MatchDistance			= 0.1f;		//How far a point may drift and still be warm started
+	const float MatchNormalDot			= 0.95f;
+
+	//Any two axes perpendicular to the normal - always the same two for the same normal
+	void TangentBasis(const Vector3& n, Vector3& t1, Vector3& t2) {
+		if (std::abs(n.x) >= 0.57735f) {
+			t1 = Vector::Normalise(Vector3(n.y, -n.x, 0.0f));
+		}
+		else {
+			t1 = Vector::Normalise(Vector3(0.0f, n.z, -n.y));
+		}
+		t2 = Vector::Cross(n, t1);
+	}
+}
+
+void ContactSolver::Reset(int manifoldCount) {
+	manifolds.resize(manifoldCount);
+	points.resize(manifoldCount * CollisionDetection::CollisionInfo::MaxContactPoints);
+}
+
+void ContactSolver::PreStep(int index, CollisionDetection::CollisionInfo& manifold, float dt) {
+	SolverManifold& m = manifolds[index];
+	m.info		= &manifold;
+	m.physA		= manifold.a->GetPhysicsObject();
+	m.physB		= manifold.b->GetPhysicsObject();
+	m.pointCount = 0;
+
+	if (!m.physA || !m.physB) {
+		return;
+	}
+	m.invMassA = m.physA->GetInverseMass();
+	m.invMassB = m.physB->GetInverseMass();
+
+	if (m.invMassA + m.invMassB == 0.0f) {
+		return;
+	}
+	//Static objects can be touched by more than one island at once, so are only
+	//ever read from - treating them as having no inverse inertia keeps it that way
+	m.invInertiaA = m.invMassA > 0.0f ? m.physA->GetInertiaTensor() : Matrix::Scale3x3(Vector3());
+	m.invInertiaB = m.invMassB > 0.0f ? m.physB->GetInertiaTensor() : Matrix::Scale3x3(Vector3());
+
+	m.friction = std::sqrt(m.physA->GetFriction() * m.physB->GetFriction());
+	float restitution = m.physA->GetElasticity() * m.physB->GetElasticity();
+
+	m.pointCount = manifold.pointCount;
+
+	for (int i = 0; i < m.pointCount; ++i) {
+		const CollisionDetection::ContactPoint& p = manifold.points[i];
+		SolverPoint& s = points[index * CollisionDetection::CollisionInfo::MaxContactPoints + i];
+
+		s.rA = p.localA;
+		s.rB = p.localB;
+
+		Vector3 angularA = Vector::Cross(m.invInertiaA * Vector::Cross(s.rA, p.normal), s.rA);
+		Vector3 angularB = Vector::Cross(m.invInertiaB * Vector::Cross(s.rB, p.normal), s.rB);
+		s.normalMass = 1.0f / (m.invMassA + m.invMassB + Vector::Dot(angularA + angularB, p.normal));
+
+		TangentBasis(p.normal, s.tangents[0], s.tangents[1]);
+		for (int t = 0; t < 2; ++t) {
+			angularA = Vector::Cross(m.invInertiaA * Vector::Cross(s.rA, s.tangents[t]), s.rA);
+			angularB = Vector::Cross(m.invInertiaB * Vector::Cross(s.rB, s.tangents[t]), s.rB);
+			s.tangentMass[t] = 1.0f / (m.invMassA + m.invMassB + Vector::Dot(angularA + angularB, s.tangents[t]));
+		}
+
+		//Push out whatever's overlapping past the slop, or bounce, whichever is faster
+		float approach	= Vector::Dot(RelativeVelocity(m, s.rA, s.rB), p.normal);
+		float bounce	= approach < -RestitutionThreshold ? -restitution * approach : 0.0f;
+		float pushOut	= (BaumgarteFactor / dt) * std::max(0.0f, p.penetration - PenetrationSlop);
+
+		s.bias = std::max(bounce, pushOut);
+	}
+}
+
+void ContactSolver::WarmStart(int index) {
+	const SolverManifold& m = manifolds[index];
+
+	for (int i = 0; i < m.pointCount; ++i) {
+		const CollisionDetection::ContactPoint& p = m.info->points[i];
+		const SolverPoint& s = points[index * CollisionDetection::CollisionInfo::MaxContactPoints + i];
+
+		Vector3 impulse = p.normal * p.normalImpulse
+			+ s.tangents[0] * p.tangentImpulse[0]
+			+ s.tangents[1] * p.tangentImpulse[1];
+
+		ApplyImpulse(m, s.rA, s.rB, impulse);
+	}
+}
+
+/*
+Friction goes first, clamped by the normal impulse built up so far, then the
+normal impulse itself - friction is the one that matters least if the solver
+runs out of iterations before everything has converged.
+*/
+void ContactSolver::Solve(int index) {
+	const SolverManifold& m = manifolds[index];
+
+	for (int i = 0; i < m.pointCount; ++i) {
+		CollisionDetection::ContactPoint& p = m.info->points[i];
+		const SolverPoint& s = points[index * CollisionDetection::CollisionInfo::MaxContactPoints + i];
+
+		float maxFriction = m.friction * p.normalImpulse;
+
+		for (int t = 0; t < 2; ++t) {
+			float velocity	= Vector::Dot(RelativeVelocity(m, s.rA, s.rB), s.tangents[t]);
+			float lambda	= -velocity * s.tangentMass[t];
+
+			float oldImpulse	= p.tangentImpulse[t];
+			p.tangentImpulse[t] = std::clamp(oldImpulse + lambda, -maxFriction, maxFriction);
+
+			ApplyImpulse(m, s.rA, s.rB, s.tangents[t] * (p.tangentImpulse[t] - oldImpulse));
+		}
+
+		float velocity	= Vector::Dot(RelativeVelocity(m, s.rA, s.rB), p.normal);
+		float lambda	= (s.bias - velocity) * s.normalMass;
+
+		float oldImpulse	= p.normalImpulse;
+		p.normalImpulse		= std::max(oldImpulse + lambda, 0.0f);
+
+		ApplyImpulse(m, s.rA, s.rB, p.normal * (p.normalImpulse - oldImpulse));
+	}
+}
+
+//The impulse is applied to B, and the opposite to A
+void ContactSolver::ApplyImpulse(const SolverManifold& m, const Vector3& rA, const Vector3& rB, const Vector3& impulse) {
+	if (m.invMassA > 0.0f) {
+		m.physA->SetLinearVelocity(m.physA->GetLinearVelocity() - impulse * m.invMassA);
+		m.physA->SetAngularVelocity(m.physA->GetAngularVelocity() - m.invInertiaA * Vector::Cross(rA, impulse));
+	}
+	if (m.invMassB > 0.0f) {
+		m.physB->SetLinearVelocity(m.physB->GetLinearVelocity() + impulse * m.invMassB);
+		m.physB->SetAngularVelocity(m.physB->GetAngularVelocity() + m.invInertiaB * Vector::Cross(rB, impulse));
+	}
+}
+
+//Velocity of the contact point on B, relative to the same point on A
+Vector3 ContactSolver::RelativeVelocity(const SolverManifold& m, const Vector3& rA, const Vector3& rB) const {
+	Vector3 velocityA = m.physA->GetLinearVelocity() + Vector::Cross(m.physA->GetAngularVelocity(), rA);
+	Vector3 velocityB = m.physB->GetLinearVelocity() + Vector::Cross(m.physB->GetAngularVelocity(), rB);
+	return velocityB - velocityA;
+}
+
+void ContactSolver::CarryImpulses(const CollisionDetection::CollisionInfo& from, CollisionDetection::CollisionInfo& to) {
+	//If the pair has swapped around, so have the normals, and nothing lines up
+	if (from.a != to.a) {
+		return;
+	}
+	for (int i = 0; i < to.pointCount; ++i) {
+		CollisionDetection::ContactPoint& p = to.points[i];
+
+		float bestDistance = MatchDistance * MatchDistance;
+		int	  best = -1;
+		for (int j = 0; j < from.pointCount; ++j) {
+			const CollisionDetection::ContactPoint& old = from.points[j];
+			if (Vector::Dot(old.normal, p.normal) < MatchNormalDot) {
+				continue;
+			}
+			Vector3 drift	= old.localA - p.localA;
+			float distance	= Vector::Dot(drift, drift);
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				best = j;
+			}
+		}
+		if (best >= 0) {
+			p.normalImpulse		= from.points[best].normalImpulse;
+			p.tangentImpulse[0] = from.points[best].tangentImpulse[0];
+			p.tangentImpulse[1] = from.points[best].tangentImpulse[1];
+		}
+	}
+}
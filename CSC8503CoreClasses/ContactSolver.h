@@ -0,0 +1,70 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class PhysicsObject;
+
+		/*
+		A sequential impulse solver for contact manifolds. Rather than resolving
+		each contact once, in one go, every point is given a small impulse per
+		iteration, and the running total kept for each point is clamped - so it
+		can only ever push the objects apart, and friction can never be more than
+		the normal impulse allows (Coulomb's law, using the objects' friction).
+
+		Those totals are kept in the manifold's ContactPoints, which live on in
+		the PhysicsSystem's pair cache, so next frame's manifold can start from
+		where this frame's ended up (warm starting). Objects resting on each
+		other then only need a few iterations to settle each frame.
+
+		Usage is to Reset with the number of manifolds this step, then PreStep,
+		WarmStart and Solve them by index. Manifolds sharing no dynamic object
+		can be worked on by separate threads.
+		*/
+		class ContactSolver {
+		public:
+			ContactSolver() = default;
+			~ContactSolver() = default;
+
+			void Reset(int manifoldCount);
+
+			//Works out everything about the manifold that stays the same while iterating
+			void PreStep(int index, CollisionDetection::CollisionInfo& manifold, float dt);
+			//Reapplies the impulses the manifold's points finished on last frame
+			void WarmStart(int index);
+			void Solve(int index);
+
+			//Copies the built up impulses of any points in the old manifold that are close
+			//enough to a point in the new one to be the same contact, just a frame later
+			static void CarryImpulses(const CollisionDetection::CollisionInfo& from, CollisionDetection::CollisionInfo& to);
+
+		protected:
+			struct SolverPoint {
+				Vector3 rA;
+				Vector3 rB;
+				Vector3 tangents[2];
+				float	normalMass;
+				float	tangentMass[2];
+				float	bias;
+			};
+
+			struct SolverManifold {
+				CollisionDetection::CollisionInfo* info;
+				PhysicsObject*	physA;
+				PhysicsObject*	physB;
+				float			invMassA;
+				float			invMassB;
+				Matrix3			invInertiaA;
+				Matrix3			invInertiaB;
+				float			friction;
+				int				pointCount;
+			};
+
+			void ApplyImpulse(const SolverManifold& m, const Vector3& rA, const Vector3& rB, const Vector3& impulse);
+			Vector3 RelativeVelocity(const SolverManifold& m, const Vector3& rA, const Vector3& rB) const;
+
+			std::vector<SolverManifold>	manifolds;
+			std::vector<SolverPoint>	points;	//MaxContactPoints per manifold
+		};
+	}
+}
@@ -0,0 +1,817 @@
+#include "ConvexCollision.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const int	GJKMaxIterations	= 32;
+	const float GJKTolerance		= 1e-4f;	//Relative progress GJK must make each iteration to keep going
+	const float CoreTolerance		= 1e-4f;	//Cores closer than this are treated as overlapping
+
+	const int	EPAMaxIterations	= 48;
+	const int	EPAMaxVertices		= 64;
+	const int	EPAMaxFaces			= 128;
+	const float EPATolerance		= 1e-4f;
+
+	const int	TOIMaxIterations	= 20;
+	const float TOITolerance		= 1e-3f;	//Shapes closer than this count as touching
+
+	//A box axis has to be this much better than the best so far to replace it - so
+	//near ties go to a face of A, then a face of B, and only then an edge pair
+	const float FaceRelativeTolerance	= 0.98f;
+	const float FaceAbsoluteTolerance	= 0.001f;
+	const float EdgeRelativeTolerance	= 0.95f;
+	const float EdgeAbsoluteTolerance	= 0.01f;
+
+	//How well a face has to line up with the contact normal to clip against it
+	const float AlignedDot = 0.95f;
+
+	const int MaxClippedPoints = 8;
+
+	struct EPAFace {
+		int		v[3];
+		Vector3 normal;
+		float	distance;
+	};
+
+	struct EPAEdge {
+		int a;
+		int b;
+	};
+
+	//Closest point to the origin on the line ab, as weights of a and b
+	Vector3 ClosestOnSegment(const Vector3& a, const Vector3& b, float weights[2]) {
+		Vector3 ab		= b - a;
+		float	length	= Vector::Dot(ab, ab);
+		float	t		= length > 0.0f ? std::clamp(-Vector::Dot(a, ab) / length, 0.0f, 1.0f) : 0.0f;
+
+		weights[0] = 1.0f - t;
+		weights[1] = t;
+		return a + ab * t;
+	}
+
+	//Closest point to the origin on the triangle abc, as weights of its corners
+	//(Real Time Collision Detection, Ericson, 5.1.5)
+	Vector3 ClosestOnTriangle(const Vector3& a, const Vector3& b, const Vector3& c, float weights[3]) {
+		Vector3 ab = b - a;
+		Vector3 ac = c - a;
+
+		float d1 = -Vector::Dot(ab, a);
+		float d2 = -Vector::Dot(ac, a);
+		if (d1 <= 0.0f && d2 <= 0.0f) {
+			weights[0] = 1.0f; weights[1] = 0.0f; weights[2] = 0.0f;
+			return a;
+		}
+		float d3 = -Vector::Dot(ab, b);
+		float d4 = -Vector::Dot(ac, b);
+		if (d3 >= 0.0f && d4 <= d3) {
+			weights[0] = 0.0f; weights[1] = 1.0f; weights[2] = 0.0f;
+			return b;
+		}
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			float v = d1 / (d1 - d3);
+			weights[0] = 1.0f - v; weights[1] = v; weights[2] = 0.0f;
+			return a + ab * v;
+		}
+		float d5 = -Vector::Dot(ab, c);
+		float d6 = -Vector::Dot(ac, c);
+		if (d6 >= 0.0f && d5 <= d6) {
+			weights[0] = 0.0f; weights[1] = 0.0f; weights[2] = 1.0f;
+			return c;
+		}
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			float w = d2 / (d2 - d6);
+			weights[0] = 1.0f - w; weights[1] = 0.0f; weights[2] = w;
+			return a + ac * w;
+		}
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			weights[0] = 0.0f; weights[1] = 1.0f - w; weights[2] = w;
+			return b + (c - b) * w;
+		}
+		float denom = 1.0f / (va + vb + vc);
+		float v = vb * denom;
+		float w = vc * denom;
+		weights[0] = 1.0f - v - w; weights[1] = v; weights[2] = w;
+		return a + ab * v + ac * w;
+	}
+
+	//Weights of the corners of abc that make up p, which should be on its plane
+	void Barycentric(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c, float weights[3]) {
+		Vector3 v0 = b - a;
+		Vector3 v1 = c - a;
+		Vector3 v2 = p - a;
+		float d00 = Vector::Dot(v0, v0);
+		float d01 = Vector::Dot(v0, v1);
+		float d11 = Vector::Dot(v1, v1);
+		float d20 = Vector::Dot(v2, v0);
+		float d21 = Vector::Dot(v2, v1);
+		float denom = d00 * d11 - d01 * d01;
+
+		if (denom == 0.0f) {
+			weights[0] = 1.0f; weights[1] = 0.0f; weights[2] = 0.0f;
+			return;
+		}
+		weights[1] = (d11 * d20 - d01 * d21) / denom;
+		weights[2] = (d00 * d21 - d01 * d20) / denom;
+		weights[0] = 1.0f - weights[1] - weights[2];
+	}
+
+	//Closest points between the lines p1-q1 and p2-q2 (Ericson, 5.1.9)
+	void ClosestBetweenSegments(const Vector3& p1, const Vector3& q1, const Vector3& p2, const Vector3& q2, Vector3& c1, Vector3& c2) {
+		Vector3 d1 = q1 - p1;
+		Vector3 d2 = q2 - p2;
+		Vector3 r  = p1 - p2;
+		float a = Vector::Dot(d1, d1);
+		float e = Vector::Dot(d2, d2);
+		float f = Vector::Dot(d2, r);
+		float c = Vector::Dot(d1, r);
+		float b = Vector::Dot(d1, d2);
+		float denom = a * e - b * b;
+
+		float s = denom > 0.0f ? std::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+		float t = e > 0.0f ? (b * s + f) / e : 0.0f;
+
+		if (t < 0.0f) {
+			t = 0.0f;
+			s = a > 0.0f ? std::clamp(-c / a, 0.0f, 1.0f) : 0.0f;
+		}
+		else if (t > 1.0f) {
+			t = 1.0f;
+			s = a > 0.0f ? std::clamp((b - c) / a, 0.0f, 1.0f) : 0.0f;
+		}
+		c1 = p1 + d1 * s;
+		c2 = p2 + d2 * t;
+	}
+
+	/*
+	Keeps the part of the polygon (or line, for 2 points) behind the plane -
+	each plane can add at most one point, so 4 points clipped by 4 planes
+	never needs more than MaxClippedPoints.
+	*/
+	int ClipToPlane(const Vector3* in, int count, const Vector3& planePoint, const Vector3& planeNormal, Vector3* out) {
+		int outCount = 0;
+		if (count == 1) {
+			if (Vector::Dot(in[0] - planePoint, planeNormal) <= 0.0f) {
+				out[outCount++] = in[0];
+			}
+			return outCount;
+		}
+		int edgeCount = count == 2 ? 1 : count;
+
+		for (int i = 0; i < edgeCount; ++i) {
+			const Vector3& p = in[i];
+			const Vector3& q = in[(i + 1) % count];
+			float dp = Vector::Dot(p - planePoint, planeNormal);
+			float dq = Vector::Dot(q - planePoint, planeNormal);
+
+			if (dp <= 0.0f) {
+				out[outCount++] = p;
+			}
+			if ((dp < 0.0f && dq > 0.0f) || (dp > 0.0f && dq < 0.0f)) {
+				out[outCount++] = p + (q - p) * (dp / (dp - dq));
+			}
+		}
+		if (count == 2 && Vector::Dot(in[1] - planePoint, planeNormal) <= 0.0f) {
+			out[outCount++] = in[1];
+		}
+		return outCount;
+	}
+}
+
+ConvexCollision::SupportPoint ConvexCollision::MinkowskiSupport(const ConvexShape& a, const ConvexShape& b, const Vector3& dir, bool core) {
+	SupportPoint p;
+	p.a = core ? a.CoreSupport(dir)  : a.Support(dir);
+	p.b = core ? b.CoreSupport(-dir) : b.Support(-dir);
+	p.v = p.a - p.b;
+	return p;
+}
+
+bool ConvexCollision::SeparatedOnAxis(const ConvexShape& a, const ConvexShape& b, const Vector3& axis) {
+	float maxA = Vector::Dot(a.Support(axis), axis);
+	float minB = Vector::Dot(b.Support(-axis), axis);
+	return minB > maxA;
+}
+
+/*
+Runs GJK over the difference between the shapes (or just their cores), from
+the starting direction v. Returns false as soon as the shapes are shown to be
+further apart than margin - v then points from B towards A. Otherwise, v ends
+up as the closest point on the difference to the origin, with the simplex
+holding the points (and weights) that make it up, and is zero if the shapes
+overlap.
+
+In exact arithmetic v gets shorter every iteration, but in floats it can
+settle on the closest point and then swap between two simplices that are
+both about as close - so GJK stops as soon as an iteration fails to get
+any closer, and goes back to the best simplex it has seen.
+*/
+bool ConvexCollision::GJK(const ConvexShape& a, const ConvexShape& b, bool core, float margin, Vector3& v, Simplex& simplex) {
+	if (Vector::LengthSquared(v) == 0.0f) {
+		v = Vector3(1, 0, 0);
+	}
+	simplex.count = 0;
+
+	Simplex best;
+	Vector3 bestV;
+	float	bestVV = FLT_MAX;
+
+	for (int i = 0; i < GJKMaxIterations; ++i) {
+		SupportPoint w = MinkowskiSupport(a, b, -v, core);
+
+		float vv = Vector::Dot(v, v);
+		float vw = Vector::Dot(v, w.v);
+
+		//Nothing in the difference is closer to the origin along v than w
+		if (vw > 0.0f && vw * vw > vv * margin * margin) {
+			return false;
+		}
+		if (simplex.count > 0 && vv - vw <= vv * GJKTolerance) {
+			break;
+		}
+		bool repeated = false;
+		for (int j = 0; j < simplex.count; ++j) {
+			repeated |= Vector::LengthSquared(simplex.points[j].v - w.v) == 0.0f;
+		}
+		if (repeated) {
+			break;
+		}
+		simplex.points[simplex.count++] = w;
+
+		if (!SolveSimplex(simplex, v) || Vector::LengthSquared(v) < CoreTolerance * CoreTolerance) {
+			v = Vector3();
+			return true;
+		}
+		float nextVV = Vector::LengthSquared(v);
+		if (nextVV >= bestVV) {
+			v		= bestV;
+			simplex	= best;
+			break;
+		}
+		bestVV	= nextVV;
+		bestV	= v;
+		best	= simplex;
+	}
+	return Vector::LengthSquared(v) <= margin * margin;
+}
+
+/*
+Finds the closest point to the origin on the simplex, and cuts the simplex
+down to just the points needed to make it. Returns false if the simplex is
+a tetrahedron with the origin inside it.
+*/
+bool ConvexCollision::SolveSimplex(Simplex& simplex, Vector3& closest) {
+	SupportPoint* p = simplex.points;
+	float* w = simplex.weights;
+
+	switch (simplex.count) {
+		case 1: {
+			w[0] = 1.0f;
+		}break;
+		case 2: {
+			ClosestOnSegment(p[0].v, p[1].v, w);
+		}break;
+		case 3: {
+			ClosestOnTriangle(p[0].v, p[1].v, p[2].v, w);
+		}break;
+		case 4: {
+			static const int faces[4][4] = {
+				{ 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 }
+			};
+			float bestDistance	= FLT_MAX;
+			bool  outside		= false;
+			float best[4]		= { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (const int* f : faces) {
+				Vector3 normal		= Vector::Cross(p[f[1]].v - p[f[0]].v, p[f[2]].v - p[f[0]].v);
+				float	originSide	= -Vector::Dot(p[f[0]].v, normal);
+				float	pointSide	= Vector::Dot(p[f[3]].v - p[f[0]].v, normal);
+
+				//Only faces with the origin on their far side can hold the closest point
+				if (pointSide != 0.0f && originSide * pointSide >= 0.0f) {
+					continue;
+				}
+				outside = true;
+
+				float faceWeights[3];
+				Vector3 point	= ClosestOnTriangle(p[f[0]].v, p[f[1]].v, p[f[2]].v, faceWeights);
+				float distance	= Vector::LengthSquared(point);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best[f[0]] = faceWeights[0];
+					best[f[1]] = faceWeights[1];
+					best[f[2]] = faceWeights[2];
+					best[f[3]] = 0.0f;
+				}
+			}
+			if (!outside) {
+				return false;
+			}
+			for (int i = 0; i < 4; ++i) {
+				w[i] = best[i];
+			}
+		}break;
+	}
+
+	int kept = 0;
+	closest = Vector3();
+	for (int i = 0; i < simplex.count; ++i) {
+		if (w[i] > 0.0f) {
+			p[kept] = p[i];
+			w[kept] = w[i];
+			closest += p[kept].v * w[kept];
+			kept++;
+		}
+	}
+	simplex.count = kept;
+	return true;
+}
+
+/*
+EPA needs a tetrahedron to start from, but GJK can stop early on a triangle,
+line or point, if the origin lies right on it - so search outwards from it
+until there are 4 points that aren't all flat.
+*/
+bool ConvexCollision::FillTetrahedron(const ConvexShape& a, const ConvexShape& b, Simplex& simplex) {
+	const float minDistance = 1e-6f;
+
+	while (simplex.count < 4) {
+		Vector3 dirs[6];
+		int		dirCount = 0;
+		const Vector3& p0 = simplex.points[0].v;
+
+		if (simplex.count == 1) {
+			dirs[0] = Vector3(1, 0, 0); dirs[1] = Vector3(-1, 0, 0);
+			dirs[2] = Vector3(0, 1, 0); dirs[3] = Vector3(0, -1, 0);
+			dirs[4] = Vector3(0, 0, 1); dirs[5] = Vector3(0, 0, -1);
+			dirCount = 6;
+		}
+		else if (simplex.count == 2) {
+			Vector3 line = simplex.points[1].v - p0;
+			int axis = 0;
+			for (int i = 1; i < 3; ++i) {
+				if (std::abs(line[i]) < std::abs(line[axis])) {
+					axis = i;
+				}
+			}
+			Vector3 other;
+			other[axis] = 1.0f;
+			Vector3 e1 = Vector::Cross(line, other);
+			Vector3 e2 = Vector::Cross(line, e1);
+			dirs[0] = e1; dirs[1] = -e1; dirs[2] = e2; dirs[3] = -e2;
+			dirCount = 4;
+		}
+		else {
+			Vector3 normal = Vector::Cross(simplex.points[1].v - p0, simplex.points[2].v - p0);
+			dirs[0] = normal; dirs[1] = -normal;
+			dirCount = 2;
+		}
+
+		bool added = false;
+		for (int i = 0; i < dirCount && !added; ++i) {
+			SupportPoint w = MinkowskiSupport(a, b, dirs[i], false);
+			Vector3 offset = w.v - p0;
+
+			float distance = 0.0f;
+			if (simplex.count == 1) {
+				distance = Vector::Length(offset);
+			}
+			else if (simplex.count == 2) {
+				Vector3 line = simplex.points[1].v - p0;
+				distance = Vector::Length(Vector::Cross(offset, line)) / Vector::Length(line);
+			}
+			else {
+				distance = std::abs(Vector::Dot(offset, Vector::Normalise(dirs[0])));
+			}
+			if (distance > minDistance) {
+				simplex.points[simplex.count++] = w;
+				added = true;
+			}
+		}
+		if (!added) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+Grows the tetrahedron out towards the edge of the difference between the
+shapes, always pushing out the face nearest the origin, until that face is
+on the edge - how far it is from the origin is then how far the shapes
+overlap, and its normal the way to push them apart.
+*/
+bool ConvexCollision::EPA(const ConvexShape& a, const ConvexShape& b, const Simplex& simplex, Contact& contact) {
+	SupportPoint	vertices[EPAMaxVertices];
+	EPAFace			faces[EPAMaxFaces];
+	EPAEdge			edges[EPAMaxFaces * 3];
+	int vertexCount = 4;
+	int faceCount	= 0;
+
+	for (int i = 0; i < 4; ++i) {
+		vertices[i] = simplex.points[i];
+	}
+	//Wind the faces so their normals all point outwards
+	Vector3 normal = Vector::Cross(vertices[1].v - vertices[0].v, vertices[2].v - vertices[0].v);
+	if (Vector::Dot(normal, vertices[3].v - vertices[0].v) > 0.0f) {
+		std::swap(vertices[1], vertices[2]);
+	}
+
+	auto addFace = [&](int i, int j, int k) {
+		EPAFace& f = faces[faceCount++];
+		f.v[0] = i;
+		f.v[1] = j;
+		f.v[2] = k;
+
+		Vector3 n	= Vector::Cross(vertices[j].v - vertices[i].v, vertices[k].v - vertices[i].v);
+		float	len = Vector::Length(n);
+		f.normal	= len > 0.0f ? n / len : Vector3();
+		f.distance	= len > 0.0f ? Vector::Dot(f.normal, vertices[i].v) : FLT_MAX;
+	};
+	addFace(0, 1, 2);
+	addFace(0, 3, 1);
+	addFace(0, 2, 3);
+	addFace(1, 3, 2);
+
+	for (int iteration = 0; iteration < EPAMaxIterations; ++iteration) {
+		int closest = 0;
+		for (int i = 1; i < faceCount; ++i) {
+			if (faces[i].distance < faces[closest].distance) {
+				closest = i;
+			}
+		}
+		if (faces[closest].distance == FLT_MAX) {
+			return false;
+		}
+		const EPAFace& face = faces[closest];
+		SupportPoint w = MinkowskiSupport(a, b, face.normal, false);
+
+		if (Vector::Dot(w.v, face.normal) - face.distance < EPATolerance || vertexCount == EPAMaxVertices) {
+			break;
+		}
+		int newVertex = vertexCount;
+		vertices[vertexCount++] = w;
+
+		//Remove every face the new point can see, keeping the edges round the hole
+		int edgeCount = 0;
+		for (int i = faceCount - 1; i >= 0; --i) {
+			const EPAFace& f = faces[i];
+			if (Vector::Dot(f.normal, w.v - vertices[f.v[0]].v) <= 0.0f) {
+				continue;
+			}
+			for (int e = 0; e < 3; ++e) {
+				EPAEdge edge = { f.v[e], f.v[(e + 1) % 3] };
+				bool shared = false;
+				for (int j = 0; j < edgeCount; ++j) {
+					if (edges[j].a == edge.b && edges[j].b == edge.a) {
+						edges[j] = edges[--edgeCount];
+						shared = true;
+						break;
+					}
+				}
+				if (!shared) {
+					edges[edgeCount++] = edge;
+				}
+			}
+			faces[i] = faces[--faceCount];
+		}
+		if (faceCount + edgeCount > EPAMaxFaces) {
+			return false;
+		}
+		for (int i = 0; i < edgeCount; ++i) {
+			addFace(edges[i].a, edges[i].b, newVertex);
+		}
+	}
+
+	int closest = 0;
+	for (int i = 1; i < faceCount; ++i) {
+		if (faces[i].distance < faces[closest].distance) {
+			closest = i;
+		}
+	}
+	const EPAFace& face = faces[closest];
+	Vector3 point = face.normal * face.distance;
+	float weights[3];
+	Barycentric(point, vertices[face.v[0]].v, vertices[face.v[1]].v, vertices[face.v[2]].v, weights);
+
+	contact.normal		= face.normal;
+	contact.penetration = face.distance;
+	contact.pointA		= Vector3();
+	contact.pointB		= Vector3();
+	for (int i = 0; i < 3; ++i) {
+		contact.pointA += vertices[face.v[i]].a * weights[i];
+		contact.pointB += vertices[face.v[i]].b * weights[i];
+	}
+	return true;
+}
+
+bool ConvexCollision::GJKIntersection(const ConvexShape& a, const ConvexShape& b, Vector3& axis, Contact& contact) {
+	float margin = a.GetMargin() + b.GetMargin();
+
+	Simplex simplex;
+	Vector3 v = -axis;
+	if (!GJK(a, b, true, margin, v, simplex)) {
+		axis = -v;
+		return false;
+	}
+
+	float distance = Vector::Length(v);
+	if (distance > CoreTolerance) {
+		//Only the margins overlap, and the closest points on the cores say by how much
+		Vector3 coreA;
+		Vector3 coreB;
+		for (int i = 0; i < simplex.count; ++i) {
+			coreA += simplex.points[i].a * simplex.weights[i];
+			coreB += simplex.points[i].b * simplex.weights[i];
+		}
+		contact.normal		= -v / distance;
+		contact.penetration = margin - distance;
+		contact.pointA		= coreA + contact.normal * a.GetMargin();
+		contact.pointB		= coreB - contact.normal * b.GetMargin();
+		return true;
+	}
+
+	v = b.GetPosition() - a.GetPosition();
+	if (GJK(a, b, false, 0.0f, v, simplex) && FillTetrahedron(a, b, simplex) && EPA(a, b, simplex, contact)) {
+		return true;
+	}
+	//Degenerate shapes (like two exactly on top of each other) can defeat EPA,
+	//so just push them apart along the line between them
+	Vector3 normal = b.GetPosition() - a.GetPosition();
+	contact.normal		= Vector::LengthSquared(normal) > 0.0f ? Vector::Normalise(normal) : Vector3(0, 1, 0);
+	contact.pointA		= a.Support(contact.normal);
+	contact.pointB		= b.Support(-contact.normal);
+	contact.penetration = Vector::Dot(contact.pointA - contact.pointB, contact.normal);
+	return true;
+}
+
+bool ConvexCollision::Overlap(const ConvexShape& a, const ConvexShape& b) {
+	Simplex simplex;
+	Vector3 v = a.GetPosition() - b.GetPosition();
+	return GJK(a, b, true, a.GetMargin() + b.GetMargin(), v, simplex);
+}
+
+bool ConvexCollision::Distance(const ConvexShape& a, const ConvexShape& b, float maxDistance, float& distance, Vector3& normal) {
+	float margin = a.GetMargin() + b.GetMargin();
+
+	Simplex simplex;
+	Vector3 v = a.GetPosition() - b.GetPosition();
+	if (!GJK(a, b, true, margin + maxDistance, v, simplex)) {
+		return false;
+	}
+	float coreDistance = Vector::Length(v);
+	if (coreDistance > CoreTolerance) {
+		normal = -v / coreDistance;
+	}
+	else {
+		//The cores overlap, so only EPA can say which way they're touching
+		Vector3 axis = b.GetPosition() - a.GetPosition();
+		Contact contact;
+		GJKIntersection(a, b, axis, contact);
+		normal = contact.normal;
+	}
+	distance = std::max(0.0f, coreDistance - margin);
+	return true;
+}
+
+bool ConvexCollision::TimeOfImpact(const ConvexShape& a, const Vector3& motionA, const ConvexShape& b, const Vector3& motionB, float& toi, Vector3& normal) {
+	Vector3 motion	= motionA - motionB;
+	float	length	= Vector::Length(motion);
+	if (length == 0.0f) {
+		return false;
+	}
+	ConvexShape movedA = a;
+	ConvexShape movedB = b;
+	float t = 0.0f;
+
+	for (int i = 0; i < TOIMaxIterations; ++i) {
+		float distance;
+		if (!Distance(movedA, movedB, length * (1.0f - t), distance, normal)) {
+			return false;
+		}
+		//Nothing can close the gap faster than the motion along its normal
+		float closing = Vector::Dot(motion, normal);
+		if (distance <= TOITolerance) {
+			toi = t;
+			return i > 0 || closing > TOITolerance;
+		}
+		if (closing <= 0.0f) {
+			return false;
+		}
+		t += distance / closing;
+		if (t > 1.0f) {
+			return false;
+		}
+		movedA = a;
+		movedB = b;
+		movedA.Translate(motionA * t);
+		movedB.Translate(motionB * t);
+	}
+	toi = t;
+	return true;
+}
+
+/*
+The separating axis test for two boxes: they overlap only if their shadows
+overlap along each of the 15 axes (the 3 face normals of each box, and the 9
+crosses of an edge from each). Whichever axis they overlap least along is the
+way to push them apart.
+*/
+bool ConvexCollision::BoxIntersection(const ConvexShape& a, const ConvexShape& b, Vector3& axis, Contact& contact) {
+	const Vector3&	halfA	= a.GetHalfSizes();
+	const Vector3&	halfB	= b.GetHalfSizes();
+	Vector3			delta	= b.GetPosition() - a.GetPosition();
+
+	float dots[3][3];
+	float absDots[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			dots[i][j]		= Vector::Dot(a.GetAxis(i), b.GetAxis(j));
+			absDots[i][j]	= std::abs(dots[i][j]) + 1e-6f; //Stops near parallel edges giving a false separation
+		}
+	}
+
+	float	bestOverlap = FLT_MAX;
+	Vector3 bestAxis;
+	int		bestEdgeA	= -1;
+	int		bestEdgeB	= -1;
+
+	//Returns false if the axis separates the boxes
+	auto testAxis = [&](const Vector3& l, float radiusA, float radiusB, float relativeTolerance, float absoluteTolerance, int edgeA, int edgeB) {
+		float distance	= Vector::Dot(delta, l);
+		float overlap	= radiusA + radiusB - std::abs(distance);
+
+		if (overlap < 0.0f) {
+			axis = distance >= 0.0f ? l : -l;
+			return false;
+		}
+		if (overlap < bestOverlap * relativeTolerance - absoluteTolerance || bestOverlap == FLT_MAX) {
+			bestOverlap = overlap;
+			bestAxis	= distance >= 0.0f ? l : -l;
+			bestEdgeA	= edgeA;
+			bestEdgeB	= edgeB;
+		}
+		return true;
+	};
+
+	for (int i = 0; i < 3; ++i) {
+		float radiusB = halfB.x * absDots[i][0] + halfB.y * absDots[i][1] + halfB.z * absDots[i][2];
+		if (!testAxis(a.GetAxis(i), halfA[i], radiusB, 1.0f, 0.0f, -1, -1)) {
+			return false;
+		}
+	}
+	for (int j = 0; j < 3; ++j) {
+		float radiusA = halfA.x * absDots[0][j] + halfA.y * absDots[1][j] + halfA.z * absDots[2][j];
+		if (!testAxis(b.GetAxis(j), radiusA, halfB[j], FaceRelativeTolerance, FaceAbsoluteTolerance, -1, -1)) {
+			return false;
+		}
+	}
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			Vector3 l	= Vector::Cross(a.GetAxis(i), b.GetAxis(j));
+			float	len = Vector::Length(l);
+			if (len < 1e-5f) {
+				continue; //Parallel edges - already covered by the face axes
+			}
+			l = l / len;
+
+			float radiusA = 0.0f;
+			float radiusB = 0.0f;
+			for (int k = 0; k < 3; ++k) {
+				radiusA += halfA[k] * std::abs(Vector::Dot(a.GetAxis(k), l));
+				radiusB += halfB[k] * std::abs(Vector::Dot(b.GetAxis(k), l));
+			}
+			if (!testAxis(l, radiusA, radiusB, EdgeRelativeTolerance, EdgeAbsoluteTolerance, i, j)) {
+				return false;
+			}
+		}
+	}
+
+	contact.normal		= bestAxis;
+	contact.penetration = bestOverlap;
+
+	if (bestEdgeA < 0) {
+		contact.pointB = b.Support(-bestAxis);
+		contact.pointA = contact.pointB + bestAxis * bestOverlap;
+		return true;
+	}
+	//Two edges crossing - find the edge of each box nearest the other, and where they pass closest
+	Vector3 edgeA = a.GetPosition();
+	Vector3 edgeB = b.GetPosition();
+	for (int k = 0; k < 3; ++k) {
+		if (k != bestEdgeA) {
+			edgeA += a.GetAxis(k) * (Vector::Dot(a.GetAxis(k), bestAxis) >= 0.0f ? halfA[k] : -halfA[k]);
+		}
+		if (k != bestEdgeB) {
+			edgeB += b.GetAxis(k) * (Vector::Dot(b.GetAxis(k), bestAxis) <= 0.0f ? halfB[k] : -halfB[k]);
+		}
+	}
+	Vector3 alongA = a.GetAxis(bestEdgeA) * halfA[bestEdgeA];
+	Vector3 alongB = b.GetAxis(bestEdgeB) * halfB[bestEdgeB];
+	ClosestBetweenSegments(edgeA - alongA, edgeA + alongA, edgeB - alongB, edgeB + alongB, contact.pointA, contact.pointB);
+	return true;
+}
+
+void ConvexCollision::AddManifold(const ConvexShape& a, const ConvexShape& b, const Contact& contact, CollisionDetection::CollisionInfo& collisionInfo) {
+	Vector3 featureA[4];
+	Vector3 featureB[4];
+	Vector3 normalA;
+	Vector3 normalB;
+	int countA = a.GetFeature(contact.normal, featureA, normalA);
+	int countB = b.GetFeature(-contact.normal, featureB, normalB);
+
+	if (countA > 1 && countB > 1) {
+		float alignedA = Vector::Dot(normalA, contact.normal);
+		float alignedB = -Vector::Dot(normalB, contact.normal);
+
+		//Faces are clipped against in preference to sides, then whichever lines up best
+		bool referenceA = countA > countB || (countA == countB && alignedA >= alignedB);
+
+		const Vector3*	reference		= referenceA ? featureA : featureB;
+		int				referenceCount	= referenceA ? countA : countB;
+		const Vector3&	referenceNormal = referenceA ? normalA : normalB;
+
+		if ((referenceA ? alignedA : alignedB) > AlignedDot) {
+			Vector3 buffers[2][MaxClippedPoints];
+			int count = referenceA ? countB : countA;
+			for (int i = 0; i < count; ++i) {
+				buffers[0][i] = referenceA ? featureB[i] : featureA[i];
+			}
+			//Cut the incident feature down to the part inside the reference's sides
+			int current = 0;
+			for (int i = 0; i < referenceCount && count > 0; ++i) {
+				Vector3 sideNormal;
+				if (referenceCount == 2) {
+					sideNormal = reference[i] - reference[1 - i];
+				}
+				else {
+					const Vector3& next = reference[(i + 1) % referenceCount];
+					sideNormal = Vector::Cross(next - reference[i], referenceNormal);
+					if (Vector::Dot(reference[(i + 2) % referenceCount] - reference[i], sideNormal) > 0.0f) {
+						sideNormal = -sideNormal;
+					}
+				}
+				count = ClipToPlane(buffers[current], count, reference[i], sideNormal, buffers[1 - current]);
+				current = 1 - current;
+			}
+
+			Vector3 points[MaxClippedPoints];
+			float	depths[MaxClippedPoints];
+			int		pointCount = 0;
+			for (int i = 0; i < count; ++i) {
+				float depth = Vector::Dot(reference[0] - buffers[current][i], referenceNormal);
+				if (depth > 0.0f) {
+					points[pointCount] = buffers[current][i] + referenceNormal * (depth * 0.5f);
+					depths[pointCount] = depth;
+					pointCount++;
+				}
+			}
+
+			//Too many points - keep the deepest, then whichever spread the manifold out most
+			int chosen[CollisionDetection::CollisionInfo::MaxContactPoints];
+			int chosenCount = 0;
+			if (pointCount <= CollisionDetection::CollisionInfo::MaxContactPoints) {
+				for (int i = 0; i < pointCount; ++i) {
+					chosen[chosenCount++] = i;
+				}
+			}
+			else {
+				int deepest = 0;
+				for (int i = 1; i < pointCount; ++i) {
+					if (depths[i] > depths[deepest]) {
+						deepest = i;
+					}
+				}
+				chosen[chosenCount++] = deepest;
+				while (chosenCount < CollisionDetection::CollisionInfo::MaxContactPoints) {
+					int		best		= -1;
+					float	bestScore	= -1.0f;
+					for (int i = 0; i < pointCount; ++i) {
+						float score = FLT_MAX;
+						for (int j = 0; j < chosenCount; ++j) {
+							score = std::min(score, Vector::LengthSquared(points[i] - points[chosen[j]]));
+						}
+						if (score > bestScore) {
+							bestScore	= score;
+							best		= i;
+						}
+					}
+					chosen[chosenCount++] = best;
+				}
+			}
+
+			for (int i = 0; i < chosenCount; ++i) {
+				const Vector3& p = points[chosen[i]];
+				collisionInfo.AddContactPoint(p - a.GetPosition(), p - b.GetPosition(), contact.normal, depths[chosen[i]]);
+			}
+			if (chosenCount > 0) {
+				return;
+			}
+		}
+	}
+	Vector3 point = (contact.pointA + contact.pointB) * 0.5f;
+	collisionInfo.AddContactPoint(point - a.GetPosition(), point - b.GetPosition(), contact.normal, contact.penetration);
+}
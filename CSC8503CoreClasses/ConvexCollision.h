@@ -0,0 +1,90 @@
+#pragma once
+#include "ConvexShape.h"
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Narrow phase tests that work on any pair of ConvexShapes.
+
+		GJK walks a simplex over the Minkowski difference of the two shapes'
+		cores, towards the origin, finding the closest points between them.
+		If the cores are further apart than the shapes' margins, they're not
+		touching; if they're closer, the margins overlap by the difference.
+		Only when the cores themselves overlap is EPA needed, to expand the
+		simplex GJK ended on out to the edge of the Minkowski difference, and
+		find how far the shapes have to move apart.
+
+		Box pairs instead use the separating axis test over their 15 possible
+		axes, which is cheaper, and always lands on the face or edge pair that
+		gives the best contact manifold.
+
+		Either way, a miss returns an axis that separates the shapes - trying
+		it first next frame (SeparatedOnAxis) usually finds the pair still
+		apart without running anything else.
+		*/
+		class ConvexCollision {
+		public:
+			struct Contact {
+				Vector3 normal;		//From A to B
+				float	penetration;
+				Vector3 pointA;		//Deepest point of each shape inside the other
+				Vector3 pointB;
+			};
+
+			//Axis is used as the starting direction, and is set to a separating axis (from A to B) on a miss
+			static bool GJKIntersection(const ConvexShape& a, const ConvexShape& b, Vector3& axis, Contact& contact);
+			static bool BoxIntersection(const ConvexShape& a, const ConvexShape& b, Vector3& axis, Contact& contact);
+
+			static bool SeparatedOnAxis(const ConvexShape& a, const ConvexShape& b, const Vector3& axis);
+
+			//Just whether the shapes touch - no contact, so never needs EPA
+			static bool Overlap(const ConvexShape& a, const ConvexShape& b);
+
+			//Gap between the shapes (0 if they touch) and the direction from A to B across it.
+			//Returns false without measuring it if it's any wider than maxDistance
+			static bool Distance(const ConvexShape& a, const ConvexShape& b, float maxDistance, float& distance, Vector3& normal);
+
+			/*
+			Conservative advancement: moves the shapes along their motions, each
+			time by as far as they could go before the gap between them closes,
+			until they touch. Toi is how far along the motion that happens, from
+			0 to 1, and normal the direction from A to B as they meet. Rotation
+			isn't swept - the shapes keep the orientation they were given.
+
+			Shapes already touching at the start only count as hitting if they're
+			still moving into each other - sliding along is left to the contacts.
+			*/
+			static bool TimeOfImpact(const ConvexShape& a, const Vector3& motionA, const ConvexShape& b, const Vector3& motionB, float& toi, Vector3& normal);
+
+			/*
+			Turns a single contact into a manifold, by clipping whichever flat
+			parts of the two shapes face each other against one another - a box
+			resting on its face gets its 4 corners, a capsule lying on its side
+			both ends. Anything else gets the contact's single point.
+			*/
+			static void AddManifold(const ConvexShape& a, const ConvexShape& b, const Contact& contact, CollisionDetection::CollisionInfo& collisionInfo);
+
+		protected:
+			struct SupportPoint {
+				Vector3 v;	//a - b
+				Vector3 a;
+				Vector3 b;
+			};
+
+			struct Simplex {
+				SupportPoint	points[4];
+				float			weights[4];	//Of the closest point to the origin
+				int				count = 0;
+			};
+
+			static SupportPoint MinkowskiSupport(const ConvexShape& a, const ConvexShape& b, const Vector3& dir, bool core);
+
+			static bool GJK(const ConvexShape& a, const ConvexShape& b, bool core, float margin, Vector3& v, Simplex& simplex);
+			static bool SolveSimplex(Simplex& simplex, Vector3& closest);
+
+			static bool FillTetrahedron(const ConvexShape& a, const ConvexShape& b, Simplex& simplex);
+			static bool EPA(const ConvexShape& a, const ConvexShape& b, const Simplex& simplex, Contact& contact);
+		};
+	}
+}
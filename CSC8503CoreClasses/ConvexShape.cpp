@@ -0,0 +1,111 @@
+#include "ConvexShape.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "CapsuleVolume.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//How nearly across dir a capsule has to lie for its whole side to count as facing it
+	const float SideTolerance = 0.1f;
+}
+
+ConvexShape::ConvexShape(const CollisionVolume& volume, const Transform& transform) {
+	position	= transform.GetPosition();
+	margin		= 0.0f;
+
+	axes[0] = Vector3(1, 0, 0);
+	axes[1] = Vector3(0, 1, 0);
+	axes[2] = Vector3(0, 0, 1);
+
+	//AABBs ignore the transform's orientation, so keep the world axes
+	if (volume.type != VolumeType::AABB) {
+		Matrix3 rotation = Quaternion::RotationMatrix<Matrix3>(transform.GetOrientation());
+		for (int i = 0; i < 3; ++i) {
+			axes[i] = rotation.GetColumn(i);
+		}
+	}
+
+	switch (volume.type) {
+		case VolumeType::AABB:
+			halfSizes = ((const AABBVolume&)volume).GetHalfDimensions();
+			break;
+		case VolumeType::OBB:
+			halfSizes = ((const OBBVolume&)volume).GetHalfDimensions();
+			break;
+		case VolumeType::Sphere:
+			margin = ((const SphereVolume&)volume).GetRadius();
+			break;
+		case VolumeType::Capsule: {
+			const CapsuleVolume& capsule = (const CapsuleVolume&)volume;
+			margin		= capsule.GetRadius();
+			halfSizes.y = std::max(0.0f, capsule.GetHalfHeight() - capsule.GetRadius());
+		}break;
+		default:
+			break;
+	}
+}
+
+Vector3 ConvexShape::CoreSupport(const Vector3& dir) const {
+	Vector3 point = position;
+	for (int i = 0; i < 3; ++i) {
+		point += axes[i] * (Vector::Dot(axes[i], dir) >= 0.0f ? halfSizes[i] : -halfSizes[i]);
+	}
+	return point;
+}
+
+Vector3 ConvexShape::Support(const Vector3& dir) const {
+	if (margin == 0.0f) {
+		return CoreSupport(dir);
+	}
+	return CoreSupport(dir) + Vector::Normalise(dir) * margin;
+}
+
+Vector3 ConvexShape::GetExtent() const {
+	Vector3 extent;
+	for (int i = 0; i < 3; ++i) {
+		extent[i] = std::abs(axes[0][i]) * halfSizes[0] + std::abs(axes[1][i]) * halfSizes[1] + std::abs(axes[2][i]) * halfSizes[2] + margin;
+	}
+	return extent;
+}
+
+int ConvexShape::GetFeature(const Vector3& dir, Vector3* points, Vector3& normal) const {
+	Vector3 local(Vector::Dot(axes[0], dir), Vector::Dot(axes[1], dir), Vector::Dot(axes[2], dir));
+
+	if (IsBox()) {
+		int axis = 0;
+		for (int i = 1; i < 3; ++i) {
+			if (std::abs(local[i]) > std::abs(local[axis])) {
+				axis = i;
+			}
+		}
+		int u = (axis + 1) % 3;
+		int v = (axis + 2) % 3;
+
+		float side = local[axis] >= 0.0f ? 1.0f : -1.0f;
+		normal = axes[axis] * side;
+
+		Vector3 centre	= position + normal * halfSizes[axis];
+		Vector3 uOffset = axes[u] * halfSizes[u];
+		Vector3 vOffset = axes[v] * halfSizes[v];
+
+		points[0] = centre + uOffset + vOffset;
+		points[1] = centre - uOffset + vOffset;
+		points[2] = centre - uOffset - vOffset;
+		points[3] = centre + uOffset - vOffset;
+		return 4;
+	}
+
+	normal = Vector::Normalise(dir);
+
+	if (halfSizes.y > 0.0f && std::abs(Vector::Dot(axes[1], normal)) < SideTolerance) {
+		Vector3 offset = normal * margin;
+		points[0] = position + axes[1] * halfSizes.y + offset;
+		points[1] = position - axes[1] * halfSizes.y + offset;
+		return 2;
+	}
+	points[0] = Support(dir);
+	return 1;
+}
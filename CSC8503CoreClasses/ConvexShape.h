@@ -0,0 +1,76 @@
+#pragma once
+#include "CollisionVolume.h"
+#include "Transform.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A collision volume placed in the world, described by its support
+		function - the point on it furthest along any given direction - which
+		is all the generic convex tests (GJK, EPA) need to know about a shape.
+
+		Every volume is stored as a box 'core' swept out by a sphere 'margin':
+		boxes are a core with no margin, spheres are a margin round a point,
+		and capsules are a margin round a line (a box with only a height).
+		Keeping the core and margin apart lets GJK measure the distance between
+		cores exactly, and only fall back to EPA when the cores overlap.
+
+		A capsule's half height is taken to include its rounded ends, so the
+		line through its middle is its half height minus its radius, each way.
+		*/
+		class ConvexShape {
+		public:
+			ConvexShape(const CollisionVolume& volume, const Transform& transform);
+			~ConvexShape() = default;
+
+			//The point on the shape furthest along dir
+			Vector3 Support(const Vector3& dir) const;
+			//The point on the shape's core furthest along dir
+			Vector3 CoreSupport(const Vector3& dir) const;
+
+			/*
+			Fills points with the flat part of the surface facing dir - a face
+			(4 points, in order round it) for a box, or a side (2 points) for a
+			capsule lying across dir - and returns how many there are. Anything
+			else gives just the single furthest point. Normal is set to the
+			outward normal of whatever part was picked.
+			*/
+			int GetFeature(const Vector3& dir, Vector3* points, Vector3& normal) const;
+
+			bool IsBox() const {
+				return margin == 0.0f;
+			}
+
+			float GetMargin() const {
+				return margin;
+			}
+
+			const Vector3& GetPosition() const {
+				return position;
+			}
+
+			void Translate(const Vector3& offset) {
+				position += offset;
+			}
+
+			//The shape's local x, y and z axes, in world space
+			const Vector3& GetAxis(int axis) const {
+				return axes[axis];
+			}
+
+			const Vector3& GetHalfSizes() const {
+				return halfSizes;
+			}
+
+			//Half size of the world space box round the whole shape
+			Vector3 GetExtent() const;
+
+		protected:
+			Vector3 position;
+			Vector3 axes[3];
+			Vector3 halfSizes;	//Of the core
+			float	margin;
+		};
+	}
+}
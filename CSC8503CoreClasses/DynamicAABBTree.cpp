@@ -0,0 +1,2 @@
+#include "DynamicAABBTree.h"
+using namespace NCL;
@@ -0,0 +1,518 @@
+#pragma once
+#include <cfloat>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A dynamic bounding volume hierarchy of axis aligned boxes. Every object
+		gets a leaf (a 'proxy') whose box is grown by a margin, so that small
+		movements don't change the tree at all - only when an object escapes its
+		fattened box is its leaf taken out and reinserted. Leaves are placed using
+		a surface area cost, and the tree is kept balanced with AVL style rotations.
+
+		Unlike the QuadTree, this is meant to live across frames, so node storage
+		is a single pooled array with a free list rather than individual allocations.
+		*/
+		template<class T>
+		struct DynamicAABBTreeNode {
+			Vector3 min;
+			Vector3 max;
+			T		object;
+
+			int		parent;		//Reused as the 'next' link while on the free list
+			int		children[2];
+			int		height;		//0 for leaves, -1 for free nodes
+
+			bool IsLeaf() const {
+				return children[0] == -1;
+			}
+		};
+
+		template<class T>
+		class DynamicAABBTree {
+		public:
+			static const int NullNode = -1;
+
+			DynamicAABBTree(float fatMargin = 0.5f) {
+				margin		= fatMargin;
+				root		= NullNode;
+				freeList	= NullNode;
+				proxyCount	= 0;
+			}
+			~DynamicAABBTree() = default;
+
+			void Clear() {
+				nodes.clear();
+				root		= NullNode;
+				freeList	= NullNode;
+				proxyCount	= 0;
+			}
+
+			int Insert(T object, const Vector3& pos, const Vector3& halfSize) {
+				int proxy = AllocateNode();
+				Vector3 fat = halfSize + Vector3(margin, margin, margin);
+
+				nodes[proxy].min	= pos - fat;
+				nodes[proxy].max	= pos + fat;
+				nodes[proxy].object = object;
+				nodes[proxy].height = 0;
+
+				InsertLeaf(proxy);
+				proxyCount++;
+				return proxy;
+			}
+
+			void Remove(int proxy) {
+				RemoveLeaf(proxy);
+				FreeNode(proxy);
+				proxyCount--;
+			}
+
+			//Returns true if the object moved out of its fat box, and so was reinserted
+			bool Move(int proxy, const Vector3& pos, const Vector3& halfSize) {
+				Vector3 tightMin = pos - halfSize;
+				Vector3 tightMax = pos + halfSize;
+
+				const DynamicAABBTreeNode<T>& n = nodes[proxy];
+				if (n.min.x <= tightMin.x && n.min.y <= tightMin.y && n.min.z <= tightMin.z &&
+					n.max.x >= tightMax.x && n.max.y >= tightMax.y && n.max.z >= tightMax.z) {
+					return false;
+				}
+				RemoveLeaf(proxy);
+
+				Vector3 fat = Vector3(margin, margin, margin);
+				nodes[proxy].min = tightMin - fat;
+				nodes[proxy].max = tightMax + fat;
+
+				InsertLeaf(proxy);
+				return true;
+			}
+
+			bool IsValidProxy(int proxy) const {
+				return proxy >= 0 && proxy < (int)nodes.size() && nodes[proxy].height == 0;
+			}
+
+			T GetProxyObject(int proxy) const {
+				return nodes[proxy].object;
+			}
+
+			const Vector3& GetFatMin(int proxy) const {
+				return nodes[proxy].min;
+			}
+
+			const Vector3& GetFatMax(int proxy) const {
+				return nodes[proxy].max;
+			}
+
+			//Size of the node pool - proxy IDs are always less than this
+			int GetCapacity() const {
+				return (int)nodes.size();
+			}
+
+			int GetProxyCount() const {
+				return proxyCount;
+			}
+
+			//Leaves plus the branches joining them
+			int GetNodeCount() const {
+				return proxyCount > 0 ? proxyCount * 2 - 1 : 0;
+			}
+
+			int GetHeight() const {
+				return root == NullNode ? 0 : nodes[root].height;
+			}
+
+			/*
+			Calls func(object, proxy) for every leaf whose fat box overlaps the
+			given box. Returning false from func stops the query early.
+			*/
+			template<typename F>
+			void Query(const Vector3& boxMin, const Vector3& boxMax, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				int stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = root;
+
+				while (count > 0) {
+					int index = stack[--count];
+					const DynamicAABBTreeNode<T>& n = nodes[index];
+
+					if (n.max.x < boxMin.x || n.min.x > boxMax.x ||
+						n.max.y < boxMin.y || n.min.y > boxMax.y ||
+						n.max.z < boxMin.z || n.min.z > boxMax.z) {
+						continue;
+					}
+					if (n.IsLeaf()) {
+						if (!func(n.object, index)) {
+							return;
+						}
+					}
+					else {
+						stack[count++] = n.children[0];
+						stack[count++] = n.children[1];
+					}
+				}
+			}
+
+			/*
+			Walks the leaves whose fat boxes (grown by extent, to sweep a box
+			along the ray instead of a point) the ray passes through, nearest
+			first. func(object, proxy) returns how far along the ray to carry on
+			looking - anything it has hit cuts the ray short, and returning less
+			than 0 stops the query. Dir doesn't have to be normalised, distances
+			are just measured in lengths of it.
+			*/
+			template<typename F>
+			void RayQuery(const Vector3& origin, const Vector3& dir, float maxDistance, const Vector3& extent, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				Vector3 invDir = InverseDirection(dir);
+
+				RayEntry stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = { root, RayDistance(origin, invDir, nodes[root].min - extent, nodes[root].max + extent, maxDistance) };
+
+				while (count > 0) {
+					RayEntry e = stack[--count];
+					if (e.distance >= maxDistance) {
+						continue;
+					}
+					const DynamicAABBTreeNode<T>& n = nodes[e.node];
+					if (n.IsLeaf()) {
+						float d = func(n.object, e.node);
+						if (d < 0.0f) {
+							return;
+						}
+						maxDistance = std::min(maxDistance, d);
+						continue;
+					}
+					RayEntry closer		= { n.children[0], RayDistance(origin, invDir, nodes[n.children[0]].min - extent, nodes[n.children[0]].max + extent, maxDistance) };
+					RayEntry further	= { n.children[1], RayDistance(origin, invDir, nodes[n.children[1]].min - extent, nodes[n.children[1]].max + extent, maxDistance) };
+					if (further.distance < closer.distance) {
+						std::swap(closer, further);
+					}
+					//Nearest goes on last, so comes off first
+					if (further.distance < maxDistance) {
+						stack[count++] = further;
+					}
+					if (closer.distance < maxDistance) {
+						stack[count++] = closer;
+					}
+				}
+			}
+
+			/*
+			Walks the leaves whose fat boxes come within maxDistance of point,
+			nearest box first. func(object, proxy) returns how far away to carry
+			on looking - so a k nearest search can shrink it to its k-th best.
+			*/
+			template<typename F>
+			void NearestQuery(const Vector3& point, float maxDistance, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				RayEntry stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = { root, BoxDistance(point, nodes[root].min, nodes[root].max) };
+
+				while (count > 0) {
+					RayEntry e = stack[--count];
+					if (e.distance > maxDistance) {
+						continue;
+					}
+					const DynamicAABBTreeNode<T>& n = nodes[e.node];
+					if (n.IsLeaf()) {
+						maxDistance = std::min(maxDistance, func(n.object, e.node));
+						continue;
+					}
+					RayEntry closer		= { n.children[0], BoxDistance(point, nodes[n.children[0]].min, nodes[n.children[0]].max) };
+					RayEntry further	= { n.children[1], BoxDistance(point, nodes[n.children[1]].min, nodes[n.children[1]].max) };
+					if (further.distance < closer.distance) {
+						std::swap(closer, further);
+					}
+					if (further.distance <= maxDistance) {
+						stack[count++] = further;
+					}
+					if (closer.distance <= maxDistance) {
+						stack[count++] = closer;
+					}
+				}
+			}
+
+			/*
+			Walks every node that test(min, max) accepts, calling func(object,
+			proxy) for each leaf it reaches. Of two children, the one further
+			back along dir is visited first. This is for queries that want to do
+			their own box tests - like a whole packet of rays at once.
+			*/
+			template<typename Test, typename F>
+			void Traverse(const Vector3& dir, Test&& test, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				int stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = root;
+
+				while (count > 0) {
+					const DynamicAABBTreeNode<T>& n = nodes[stack[--count]];
+					if (!test(n.min, n.max)) {
+						continue;
+					}
+					if (n.IsLeaf()) {
+						func(n.object, (int)(&n - nodes.data()));
+						continue;
+					}
+					const DynamicAABBTreeNode<T>& c0 = nodes[n.children[0]];
+					const DynamicAABBTreeNode<T>& c1 = nodes[n.children[1]];
+					bool firstNearer = Vector::Dot(c0.min + c0.max - c1.min - c1.max, dir) < 0.0f;
+
+					stack[count++] = n.children[firstNearer ? 1 : 0];
+					stack[count++] = n.children[firstNearer ? 0 : 1];
+				}
+			}
+
+		protected:
+			static const int MaxStackDepth = 256;
+
+			struct RayEntry {
+				int		node;
+				float	distance;
+			};
+
+			static Vector3 InverseDirection(const Vector3& dir) {
+				return Vector3(dir.x != 0.0f ? 1.0f / dir.x : FLT_MAX,
+							   dir.y != 0.0f ? 1.0f / dir.y : FLT_MAX,
+							   dir.z != 0.0f ? 1.0f / dir.z : FLT_MAX);
+			}
+
+			//How far the point is from the box - 0 if it's inside it
+			static float BoxDistance(const Vector3& point, const Vector3& min, const Vector3& max) {
+				Vector3 outside(std::max(0.0f, std::max(min.x - point.x, point.x - max.x)),
+								std::max(0.0f, std::max(min.y - point.y, point.y - max.y)),
+								std::max(0.0f, std::max(min.z - point.z, point.z - max.z)));
+				return Vector::Length(outside);
+			}
+
+			//How far along the ray it enters the box, or FLT_MAX if it misses it before maxDistance
+			static float RayDistance(const Vector3& origin, const Vector3& invDir, const Vector3& min, const Vector3& max, float maxDistance) {
+				float tNear = 0.0f;
+				float tFar	= maxDistance;
+				for (int i = 0; i < 3; ++i) {
+					float t0 = (min[i] - origin[i]) * invDir[i];
+					float t1 = (max[i] - origin[i]) * invDir[i];
+					tNear	= std::max(tNear, std::min(t0, t1));
+					tFar	= std::min(tFar, std::max(t0, t1));
+				}
+				return tNear <= tFar ? tNear : FLT_MAX;
+			}
+
+			static float SurfaceArea(const Vector3& min, const Vector3& max) {
+				Vector3 d = max - min;
+				return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+			}
+
+			static Vector3 Min(const Vector3& a, const Vector3& b) {
+				return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+			}
+
+			static Vector3 Max(const Vector3& a, const Vector3& b) {
+				return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+			}
+
+			int AllocateNode() {
+				int id;
+				if (freeList == NullNode) {
+					id = (int)nodes.size();
+					nodes.emplace_back();
+				}
+				else {
+					id			= freeList;
+					freeList	= nodes[id].parent;
+				}
+				DynamicAABBTreeNode<T>& n = nodes[id];
+				n.parent		= NullNode;
+				n.children[0]	= NullNode;
+				n.children[1]	= NullNode;
+				n.height		= 0;
+				n.object		= T();
+				return id;
+			}
+
+			void FreeNode(int id) {
+				nodes[id].parent = freeList;
+				nodes[id].height = -1;
+				freeList = id;
+			}
+
+			void Refit(int index) {
+				DynamicAABBTreeNode<T>& n = nodes[index];
+				const DynamicAABBTreeNode<T>& c0 = nodes[n.children[0]];
+				const DynamicAABBTreeNode<T>& c1 = nodes[n.children[1]];
+
+				n.height	= 1 + std::max(c0.height, c1.height);
+				n.min		= Min(c0.min, c1.min);
+				n.max		= Max(c0.max, c1.max);
+			}
+
+			void InsertLeaf(int leaf) {
+				if (root == NullNode) {
+					root = leaf;
+					nodes[root].parent = NullNode;
+					return;
+				}
+				Vector3 leafMin = nodes[leaf].min;
+				Vector3 leafMax = nodes[leaf].max;
+
+				//Walk down the tree picking whichever child is cheapest to grow
+				int index = root;
+				while (!nodes[index].IsLeaf()) {
+					const DynamicAABBTreeNode<T>& n = nodes[index];
+
+					float area			= SurfaceArea(n.min, n.max);
+					float combinedArea	= SurfaceArea(Min(n.min, leafMin), Max(n.max, leafMax));
+
+					float cost				= 2.0f * combinedArea;
+					float inheritanceCost	= 2.0f * (combinedArea - area);
+
+					float childCost[2];
+					for (int i = 0; i < 2; ++i) {
+						const DynamicAABBTreeNode<T>& c = nodes[n.children[i]];
+						float grown = SurfaceArea(Min(c.min, leafMin), Max(c.max, leafMax));
+						if (c.IsLeaf()) {
+							childCost[i] = grown + inheritanceCost;
+						}
+						else {
+							childCost[i] = (grown - SurfaceArea(c.min, c.max)) + inheritanceCost;
+						}
+					}
+					if (cost < childCost[0] && cost < childCost[1]) {
+						break;
+					}
+					index = childCost[0] < childCost[1] ? n.children[0] : n.children[1];
+				}
+				int sibling		= index;
+				int oldParent	= nodes[sibling].parent;
+				int newParent	= AllocateNode(); //May reallocate the node array!
+
+				nodes[newParent].parent			= oldParent;
+				nodes[newParent].children[0]	= sibling;
+				nodes[newParent].children[1]	= leaf;
+				nodes[sibling].parent			= newParent;
+				nodes[leaf].parent				= newParent;
+
+				if (oldParent != NullNode) {
+					int slot = nodes[oldParent].children[0] == sibling ? 0 : 1;
+					nodes[oldParent].children[slot] = newParent;
+				}
+				else {
+					root = newParent;
+				}
+				Refit(newParent);
+
+				index = nodes[newParent].parent;
+				while (index != NullNode) {
+					index = Balance(index);
+					Refit(index);
+					index = nodes[index].parent;
+				}
+			}
+
+			void RemoveLeaf(int leaf) {
+				if (leaf == root) {
+					root = NullNode;
+					return;
+				}
+				int parent		= nodes[leaf].parent;
+				int grandParent = nodes[parent].parent;
+				int sibling		= nodes[parent].children[0] == leaf ? nodes[parent].children[1] : nodes[parent].children[0];
+
+				if (grandParent != NullNode) {
+					int slot = nodes[grandParent].children[0] == parent ? 0 : 1;
+					nodes[grandParent].children[slot]	= sibling;
+					nodes[sibling].parent				= grandParent;
+					FreeNode(parent);
+
+					int index = grandParent;
+					while (index != NullNode) {
+						index = Balance(index);
+						Refit(index);
+						index = nodes[index].parent;
+					}
+				}
+				else {
+					root = sibling;
+					nodes[sibling].parent = NullNode;
+					FreeNode(parent);
+				}
+				nodes[leaf].parent = NullNode;
+			}
+
+			/*
+			If one child of node A is more than one level taller than the other,
+			rotate the taller child (C) up into A's place, and give A whichever of
+			C's children keeps the tree shallowest. Returns the new subtree root.
+			*/
+			int Balance(int iA) {
+				if (nodes[iA].IsLeaf() || nodes[iA].height < 2) {
+					return iA;
+				}
+				int iB = nodes[iA].children[0];
+				int iC = nodes[iA].children[1];
+
+				int balance = nodes[iC].height - nodes[iB].height;
+
+				if (balance > 1) {
+					return Rotate(iA, iC, 1);
+				}
+				if (balance < -1) {
+					return Rotate(iA, iB, 0);
+				}
+				return iA;
+			}
+
+			//Promotes child iUp (sitting in slot upSlot of iA) to replace iA
+			int Rotate(int iA, int iUp, int upSlot) {
+				int iOther	= nodes[iA].children[1 - upSlot];
+				int iF		= nodes[iUp].children[0];
+				int iG		= nodes[iUp].children[1];
+
+				nodes[iUp].children[0]	= iA;
+				nodes[iUp].parent		= nodes[iA].parent;
+				nodes[iA].parent		= iUp;
+
+				int upParent = nodes[iUp].parent;
+				if (upParent != NullNode) {
+					int slot = nodes[upParent].children[0] == iA ? 0 : 1;
+					nodes[upParent].children[slot] = iUp;
+				}
+				else {
+					root = iUp;
+				}
+				//Keep the taller grandchild up with iUp, and hand the other to iA
+				int keep	= nodes[iF].height > nodes[iG].height ? iF : iG;
+				int give	= keep == iF ? iG : iF;
+
+				nodes[iUp].children[1]		= keep;
+				nodes[iA].children[upSlot]	= give;
+				nodes[iA].children[1 - upSlot] = iOther;
+				nodes[give].parent			= iA;
+
+				Refit(iA);
+				Refit(iUp);
+				return iUp;
+			}
+
+			std::vector<DynamicAABBTreeNode<T>> nodes;
+
+			float	margin;
+			int		root;
+			int		freeList;
+			int		proxyCount;
+		};
+	}
+}
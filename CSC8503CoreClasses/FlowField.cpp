@@ -0,0 +1,186 @@
+#include "FlowField.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//The same order NavigationGrid uses - clockwise from -z, with the diagonals odd
+	const int dirX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	const int dirZ[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+	const float DiagonalCost	= 1.41421356f;
+	const float Unreachable		= std::numeric_limits<float>::infinity();
+
+	//Past this, the offset starts eating into the precision of the distances, so the field is built from scratch instead
+	const float MaxOffset = 4096.0f;
+}
+
+FlowField::FlowField(const NavigationGrid& g) : grid(g) {
+	offset			= 0.0f;
+	goalNode		= -1;
+	gridChanges		= 0;
+	nodesVisited	= 0;
+	lastIncremental	= false;
+}
+
+bool FlowField::SetGoal(const Vector3& goal) {
+	int x, z;
+	if (!grid.GetNode(goal, x, z)) {
+		return false;
+	}
+	int node = (z * grid.GetWidth()) + x;
+
+	//A goal inside a wall can't be stepped into, so nothing would be left able to reach it
+	bool patchable = goalNode >= 0 && gridChanges == grid.GetChangeCount() && grid.Walkable(x, z);
+	if (patchable && node == goalNode) {
+		nodesVisited	= 0;
+		lastIncremental	= true;
+		return true;
+	}
+	float moved = patchable ? Distance(node) : Unreachable;
+	if (moved == Unreachable || offset + moved > MaxOffset) {
+		goalNode = node;
+		Rebuild();
+		return true;
+	}
+	int oldGoal = goalNode;
+
+	offset		+= moved;
+	goalNode	= node;
+	nodesVisited = 0;
+	frontier.clear();
+	Reach(node, -1, -offset);
+	Propagate();
+
+	//Nothing gets closer to the old goal, so it's the one node left pointing nowhere
+	PointAtNeighbour(oldGoal);
+	lastIncremental = true;
+	return true;
+}
+
+void FlowField::Rebuild() {
+	distances.assign(grid.GetWidth() * grid.GetHeight(), Unreachable);
+	nextStep.assign(grid.GetWidth() * grid.GetHeight(), -1);
+
+	offset			= 0.0f;
+	gridChanges		= grid.GetChangeCount();
+	nodesVisited	= 0;
+	lastIncremental	= false;
+
+	if (goalNode < 0) {
+		return;
+	}
+	frontier.clear();
+	Reach(goalNode, -1, 0.0f);
+	Propagate();
+}
+
+float FlowField::GetDistance(int x, int z) const {
+	if (goalNode < 0 || x < 0 || x >= grid.GetWidth() || z < 0 || z >= grid.GetHeight()) {
+		return -1.0f;
+	}
+	float distance = Distance((z * grid.GetWidth()) + x);
+	return distance == Unreachable ? -1.0f : distance;
+}
+
+bool FlowField::GetNextStep(const Vector3& position, Vector3& outStep) const {
+	int x, z;
+	if (goalNode < 0 || !grid.GetNode(position, x, z)) {
+		return false;
+	}
+	int dir = nextStep[(z * grid.GetWidth()) + x];
+	if (dir < 0) {
+		return false;
+	}
+	outStep = grid.allNodes[((z + dirZ[dir]) * grid.GetWidth()) + x + dirX[dir]].position;
+	return true;
+}
+
+//Dir is the way back to the node it was reached from, and the distance is less the offset, like the stored ones
+void FlowField::Reach(int node, int dir, float distance) {
+	distances[node]	= distance;
+	nextStep[node]	= (signed char)dir;
+	frontier.emplace_back(distance, node);
+}
+
+/*
+Spreads out from whatever's on the frontier, lowering any node it can get
+to more cheaply than it already could. Without diagonal movement every step
+costs the same, so the frontier can just be worked through in the order
+nodes were added to it - otherwise it's kept as a heap, nearest first.
+It all works on the stored distances, without the offset, so that nodes
+compare exactly with what's on the frontier.
+*/
+void FlowField::Propagate() {
+	bool diagonal	= grid.GetDiagonalMovement();
+	int dirStep		= diagonal ? 1 : 2;
+	int width		= grid.GetWidth();
+	int height		= grid.GetHeight();
+
+	auto Expand = [&](int node, float distance) {
+		nodesVisited++;
+		int x = node % width;
+		int z = node / width;
+		for (int dir = 0; dir < 8; dir += dirStep) {
+			int nx = x + dirX[dir];
+			int nz = z + dirZ[dir];
+			if (nx < 0 || nx >= width || nz < 0 || nz >= height) {
+				continue;
+			}
+			//Agents step the other way, from the neighbour to here
+			if (!grid.CanStep(nx, nz, -dirX[dir], -dirZ[dir])) {
+				continue;
+			}
+			int neighbour	= (nz * width) + nx;
+			float reached	= distance + ((dir & 1) ? DiagonalCost : 1.0f);
+			if (reached < distances[neighbour]) {
+				Reach(neighbour, (dir + 4) % 8, reached);
+				if (diagonal) {
+					std::push_heap(frontier.begin(), frontier.end(), std::greater<std::pair<float, int>>());
+				}
+			}
+		}
+	};
+
+	if (!diagonal) {
+		for (size_t i = 0; i < frontier.size(); ++i) {
+			Expand(frontier[i].second, frontier[i].first);
+		}
+		frontier.clear();
+		return;
+	}
+	while (!frontier.empty()) {
+		std::pop_heap(frontier.begin(), frontier.end(), std::greater<std::pair<float, int>>());
+		auto [distance, node] = frontier.back();
+		frontier.pop_back();
+		if (distance > distances[node]) {
+			continue; //was lowered again after this was added
+		}
+		Expand(node, distance);
+	}
+}
+
+void FlowField::PointAtNeighbour(int node) {
+	int width	= grid.GetWidth();
+	int x		= node % width;
+	int z		= node / width;
+	int dirStep	= grid.GetDiagonalMovement() ? 1 : 2;
+
+	float best	= Unreachable;
+	int bestDir	= -1;
+	for (int dir = 0; dir < 8; dir += dirStep) {
+		if (!grid.CanStep(x, z, dirX[dir], dirZ[dir])) {
+			continue;
+		}
+		float distance = Distance(((z + dirZ[dir]) * width) + x + dirX[dir]) + ((dir & 1) ? DiagonalCost : 1.0f);
+		if (distance < best) {
+			best	= distance;
+			bestDir	= dir;
+		}
+	}
+	nextStep[node] = (signed char)bestDir;
+}
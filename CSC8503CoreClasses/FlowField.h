@@ -0,0 +1,77 @@
+#pragma once
+#include "NavigationGrid.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A distance field over a NavigationGrid (a 'Dijkstra map'), holding how
+		far every node is from one goal, and which way to step from it to get
+		closer. It costs about the same as a single search to work out, but
+		after that, any number of agents heading for the same goal can each
+		read their next step in constant time, rather than searching for
+		their own path.
+
+		When the goal moves, the old field is patched rather than thrown
+		away. A node's new distance can be no more than its old one plus the
+		distance between the old goal and the new, so every node starts off
+		at that (by adding it to an offset shared by the whole field, rather
+		than to every node), and a search out from the new goal only visits
+		the nodes it gets closer to - for a goal that moved a node, roughly
+		those on the side it moved towards.
+
+		Changes made to the grid are noticed on the next SetGoal, which then
+		builds the field from scratch.
+		*/
+		class FlowField {
+		public:
+			FlowField(const NavigationGrid& grid);
+			~FlowField() = default;
+
+			//False if the goal is off the grid
+			bool	SetGoal(const Vector3& goal);
+
+			//Builds the field again from scratch, for the same goal
+			void	Rebuild();
+
+			bool HasGoal() const {
+				return goalNode >= 0;
+			}
+
+			//How far a node is from the goal, or -1 if it can't get there at all
+			float	GetDistance(int x, int z) const;
+
+			//Where to head next from a position - the node one step closer to the goal. False if it's already there, or can't get there
+			bool	GetNextStep(const Vector3& position, Vector3& nextStep) const;
+
+			//How many nodes the last SetGoal or Rebuild had to visit
+			int GetNodesVisited() const {
+				return nodesVisited;
+			}
+
+			bool LastUpdateWasIncremental() const {
+				return lastIncremental;
+			}
+
+		protected:
+			void	Propagate();
+			void	Reach(int node, int from, float distance);
+			void	PointAtNeighbour(int node);
+
+			float Distance(int node) const {
+				return distances[node] + offset;
+			}
+
+			const NavigationGrid& grid;
+
+			std::vector<float>			distances;	//Less the offset - unreachable nodes are infinite either way
+			std::vector<signed char>	nextStep;	//Direction to step in, or -1 at the goal and anywhere that can't reach it
+			std::vector<std::pair<float, int>> frontier;	//Distances less the offset, like the stored ones
+
+			float			offset;
+			int				goalNode;
+			unsigned int	gridChanges;	//The grid's change count when the field was built
+			int				nodesVisited;
+			bool			lastIncremental;
+		};
+	}
+}
@@ -1,5 +1,6 @@
 #include "GameObject.h"
 #include "CollisionDetection.h"
+#include "ConvexShape.h"
 #include "PhysicsObject.h"
 #include "RenderObject.h"
 #include "NetworkObject.h"
@@ -10,7 +11,11 @@ GameObject::GameObject(const std::string& objectName)
 {
 	name			= objectName;
 	worldID			= -1;
+	broadphaseProxy	= -1;
 	isActive		= true;
+	isTrigger		= false;
+	collisionLayer	= 1;
+	collisionMask	= ~0u;
 	boundingVolume	= nullptr;
 	physicsObject	= nullptr;
 	renderObject	= nullptr;
@@ -46,7 +51,13 @@ void GameObject::UpdateBroadphaseAABB() {
 		float r = ((SphereVolume&)*boundingVolume).GetRadius();
 		broadphaseAABB = Vector3(r, r, r);
 	}
-	else if (boundingVolume->type == VolumeType::OBB) {
-		broadphaseAABB = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
+	else if (boundingVolume->type == VolumeType::OBB || boundingVolume->type == VolumeType::Capsule) {
+		//Rotated shapes reach as far along each world axis as their support point does
+		ConvexShape shape(*boundingVolume, transform);
+		for (int i = 0; i < 3; ++i) {
+			Vector3 axis;
+			axis[i] = 1.0f;
+			broadphaseAABB[i] = Vector::Dot(shape.Support(axis) - shape.GetPosition(), axis);
+		}
 	}
 }
\ No newline at end of file
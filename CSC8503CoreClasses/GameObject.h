@@ -81,6 +81,16 @@ namespace NCL::CSC8503 {
 
 		void UpdateBroadphaseAABB();
 
+		void SetBroadphaseProxy(int proxy)
+		{
+			broadphaseProxy = proxy;
+		}
+
+		int		GetBroadphaseProxy() const
+		{
+			return broadphaseProxy;
+		}
+
 		void SetWorldID(int newID) 
 		{
 			worldID = newID;
@@ -91,6 +101,48 @@ namespace NCL::CSC8503 {
 			return worldID;
 		}
 
+		/*
+		Each object is on one or more collision layers (as bits), and has a
+		mask of the layers it can collide with. A pair is only tested if each
+		object's layer is in the other's mask - by default, everything is on
+		layer 1 and collides with everything.
+		*/
+		void SetCollisionLayer(unsigned int layer)
+		{
+			collisionLayer = layer;
+		}
+
+		unsigned int GetCollisionLayer() const
+		{
+			return collisionLayer;
+		}
+
+		void SetCollisionMask(unsigned int mask)
+		{
+			collisionMask = mask;
+		}
+
+		unsigned int GetCollisionMask() const
+		{
+			return collisionMask;
+		}
+
+		bool CanCollideWith(const GameObject* other) const
+		{
+			return (collisionLayer & other->collisionMask) && (other->collisionLayer & collisionMask);
+		}
+
+		//Triggers still get OnCollisionBegin / OnCollisionEnd, but never push or get pushed
+		void SetTrigger(bool state)
+		{
+			isTrigger = state;
+		}
+
+		bool IsTrigger() const
+		{
+			return isTrigger;
+		}
+
 	protected:
 		Transform			transform;
 
@@ -100,10 +152,14 @@ namespace NCL::CSC8503 {
 		NetworkObject*		networkObject;
 
 		bool				isActive;
+		bool				isTrigger;
 		int					worldID;
+		unsigned int		collisionLayer;
+		unsigned int		collisionMask;
 		std::string			name;
 
 		Vector3				broadphaseAABB;
+		int					broadphaseProxy;
 	};
 }
 
@@ -1,8 +1,14 @@
 #include "GameWorld.h"
 #include "GameObject.h"
 #include "Constraint.h"
+#include "PhysicsObject.h"
 #include "CollisionDetection.h"
 #include "Camera.h"
+#include "PhysicsSystem.h"
+#include "ConvexCollision.h"
+#include "SphereVolume.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
 
 
 #include <random>
@@ -19,6 +25,10 @@ GameWorld::GameWorld()	{
 	shuffleObjects		= false;
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+	staticStateCounter	= 0;
+	physics				= nullptr;
+	seeded				= false;
+	randomState			= 0;
 }
 
 GameWorld::~GameWorld()	{
@@ -26,15 +36,20 @@ GameWorld::~GameWorld()	{
 
 void GameWorld::Clear() {
 	gameObjects.clear();
+	staticObjects.clear();
 	constraints.clear();
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+	staticStateCounter	= 0;
 }
 
 void GameWorld::ClearAndErase() {
 	for (auto& i : gameObjects) {
 		delete i;
 	}
+	for (auto& i : staticObjects) {
+		delete i;
+	}
 	for (auto& i : constraints) {
 		delete i;
 	}
@@ -47,12 +62,28 @@ void GameWorld::AddGameObject(GameObject* o) {
 	worldStateCounter++;
 }
 
+void GameWorld::AddStaticObject(GameObject* o) {
+	staticObjects.emplace_back(o);
+	o->SetWorldID(worldIDCounter++);
+	staticStateCounter++;
+}
+
 void GameWorld::RemoveGameObject(GameObject* o, bool andDelete) {
-	gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
+	auto staticEnd = std::remove(staticObjects.begin(), staticObjects.end(), o);
+	if (staticEnd != staticObjects.end()) {
+		staticObjects.erase(staticEnd, staticObjects.end());
+		staticStateCounter++;
+	}
+	else {
+		gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
+		worldStateCounter++;
+	}
+	if (physics) {
+		physics->RemoveObject(o);
+	}
 	if (andDelete) {
 		delete o;
 	}
-	worldStateCounter++;
 }
 
 void GameWorld::GetObjectIterators(
@@ -63,17 +94,28 @@ void GameWorld::GetObjectIterators(
 	last	= gameObjects.end();
 }
 
+void GameWorld::GetStaticObjectIterators(
+	GameObjectIterator& first,
+	GameObjectIterator& last) const {
+
+	first	= staticObjects.begin();
+	last	= staticObjects.end();
+}
+
 void GameWorld::OperateOnContents(GameObjectFunc f) {
 	for (GameObject* g : gameObjects) {
 		f(g);
 	}
+	for (GameObject* g : staticObjects) {
+		f(g);
+	}
 }
 
 void GameWorld::UpdateWorld(float dt) {
-	auto rng = std::default_random_engine{};
-
-	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-	std::default_random_engine e(seed);
+	if (!seeded) {
+		randomState = (unsigned int)std::chrono::system_clock::now().time_since_epoch().count();
+	}
+	std::minstd_rand e(randomState);
 
 	if (shuffleObjects) {
 		std::shuffle(gameObjects.begin(), gameObjects.end(), e);
@@ -82,31 +124,38 @@ void GameWorld::UpdateWorld(float dt) {
 	if (shuffleConstraints) {
 		std::shuffle(constraints.begin(), constraints.end(), e);
 	}
+	randomState = (unsigned int)e();
 }
 
-bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis) const {
+bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis, unsigned int layerMask) const {
+	if (physics) {
+		return physics->Raycast(r, closestCollision, closestObject, ignoreThis, layerMask);
+	}
 	//The simplest raycast just goes through each object and sees if there's a collision
 	RayCollision collision;
 
-	for (auto& i : gameObjects) {
-		if (!i->GetBoundingVolume()) { //objects might not be collideable etc...
-			continue;
-		}
-		if (i == ignoreThis) {
-			continue;
-		}
-		RayCollision thisCollision;
-		if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
-				
-			if (!closestObject) {	
-				closestCollision		= collision;
-				closestCollision.node = i;
-				return true;
+	//Static objects can be hit by rays just the same as any other
+	for (const std::vector<GameObject*>* objects : { &gameObjects, &staticObjects }) {
+		for (GameObject* i : *objects) {
+			if (!i->GetBoundingVolume()) { //objects might not be collideable etc...
+				continue;
+			}
+			if (i == ignoreThis || !(i->GetCollisionLayer() & layerMask)) {
+				continue;
 			}
-			else {
-				if (thisCollision.rayDistance < collision.rayDistance) {
-					thisCollision.node = i;
-					collision = thisCollision;
+			RayCollision thisCollision;
+			if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
+				
+				if (!closestObject) {	
+					closestCollision		= thisCollision;
+					closestCollision.node = i;
+					return true;
+				}
+				else {
+					if (thisCollision.rayDistance < collision.rayDistance) {
+						thisCollision.node = i;
+						collision = thisCollision;
+					}
 				}
 			}
 		}
@@ -119,17 +168,106 @@ bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObje
 	return false;
 }
 
+int GameWorld::Overlap(const CollisionVolume& volume, const Transform& transform, GameObject** results, int maxResults, unsigned int layerMask) const {
+	if (physics) {
+		return physics->Overlap(volume, transform, results, maxResults, layerMask);
+	}
+	ConvexShape shape(volume, transform);
+	int found = 0;
+
+	for (const std::vector<GameObject*>* objects : { &gameObjects, &staticObjects }) {
+		for (GameObject* i : *objects) {
+			if (found == maxResults) {
+				return found;
+			}
+			if (!i->GetBoundingVolume() || !(i->GetCollisionLayer() & layerMask)) {
+				continue;
+			}
+			if (ConvexCollision::Overlap(shape, ConvexShape(*i->GetBoundingVolume(), i->GetTransform()))) {
+				results[found++] = i;
+			}
+		}
+	}
+	return found;
+}
+
+int GameWorld::OverlapSphere(const Vector3& centre, float radius, GameObject** results, int maxResults, unsigned int layerMask) const {
+	SphereVolume	volume(radius);
+	Transform		transform;
+	transform.SetPosition(centre);
+	return Overlap(volume, transform, results, maxResults, layerMask);
+}
+
+int GameWorld::OverlapBox(const Vector3& centre, const Vector3& halfSizes, GameObject** results, int maxResults, unsigned int layerMask) const {
+	AABBVolume	volume(halfSizes);
+	Transform	transform;
+	transform.SetPosition(centre);
+	return Overlap(volume, transform, results, maxResults, layerMask);
+}
+
+int GameWorld::OverlapBox(const Vector3& centre, const Vector3& halfSizes, const Quaternion& orientation, GameObject** results, int maxResults, unsigned int layerMask) const {
+	OBBVolume	volume(halfSizes);
+	Transform	transform;
+	transform.SetPosition(centre).SetOrientation(orientation);
+	return Overlap(volume, transform, results, maxResults, layerMask);
+}
+
+int GameWorld::InsertNearest(const Vector3& point, GameObject* o, GameObject** results, int found, int maxResults, float& maxDistance) {
+	float distance = Vector::Length(o->GetTransform().GetPosition() - point);
+	if (distance > maxDistance || maxResults <= 0) {
+		return found;
+	}
+	int i = std::min(found, maxResults - 1);
+	for (; i > 0 && Vector::Length(results[i - 1]->GetTransform().GetPosition() - point) > distance; --i) {
+		results[i] = results[i - 1];
+	}
+	results[i] = o;
+	found = std::min(found + 1, maxResults);
+
+	if (found == maxResults) {
+		maxDistance = Vector::Length(results[found - 1]->GetTransform().GetPosition() - point);
+	}
+	return found;
+}
+
+int GameWorld::FindNearest(const Vector3& point, GameObject** results, int maxResults, float maxDistance, unsigned int layerMask) const {
+	if (physics) {
+		return physics->FindNearest(point, results, maxResults, maxDistance, layerMask);
+	}
+	int found = 0;
+
+	for (const std::vector<GameObject*>* objects : { &gameObjects, &staticObjects }) {
+		for (GameObject* i : *objects) {
+			if (i->GetBoundingVolume() && (i->GetCollisionLayer() & layerMask)) {
+				found = InsertNearest(point, i, results, found, maxResults, maxDistance);
+			}
+		}
+	}
+	return found;
+}
+
 
 /*
 Constraint Tutorial Stuff
 */
 
+//Objects that are asleep won't notice a constraint coming or going unless woken
+static void WakeConstrainedObjects(const Constraint* c) {
+	for (GameObject* o : { c->GetObjectA(), c->GetObjectB() }) {
+		if (o && o->GetPhysicsObject() && o->GetPhysicsObject()->GetInverseMass() > 0.0f) {
+			o->GetPhysicsObject()->SetAwake(true);
+		}
+	}
+}
+
 void GameWorld::AddConstraint(Constraint* c) {
 	constraints.emplace_back(c);
+	WakeConstrainedObjects(c);
 }
 
 void GameWorld::RemoveConstraint(Constraint* c, bool andDelete) {
 	constraints.erase(std::remove(constraints.begin(), constraints.end(), c), constraints.end());
+	WakeConstrainedObjects(c);
 	if (andDelete) {
 		delete c;
 	}
@@ -1,17 +1,22 @@
 #pragma once
+#include <cfloat>
 #include "./Camera.h"
 
 namespace NCL {
 		namespace Maths {
 			class Ray;
 			struct RayCollision;
+			class Quaternion;
 		}
 		class Camera;
 		class PerspectiveCamera;
+		class CollisionVolume;
 
 	namespace CSC8503 {
 		class GameObject;
 		class Constraint;
+		class PhysicsSystem;
+		class Transform;
 
 		typedef std::function<void(GameObject*)> GameObjectFunc;
 		typedef std::vector<GameObject*>::const_iterator GameObjectIterator;
@@ -28,6 +33,15 @@ namespace NCL {
 			void AddGameObject(GameObject* o);
 			void RemoveGameObject(GameObject* o, bool andDelete = false);
 
+			/*
+			Static objects must never move, and are kept apart from the other
+			objects - physics collides against them using a tree that's built
+			once (after a level is loaded), and skips them everywhere else.
+			They can be removed like any other object, but that (and adding
+			more) means the tree has to be rebuilt.
+			*/
+			void AddStaticObject(GameObject* o);
+
 			void AddConstraint(Constraint* c);
 			void RemoveConstraint(Constraint* c, bool andDelete = false);
 
@@ -46,7 +60,56 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
-			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, GameObject* ignore = nullptr) const;
+			//Shuffles are seeded from the clock every update, unless given a seed here -
+			//after which they follow a fixed sequence, so the same seed gives the same orders
+			void SetRandomSeed(unsigned int seed) 
+			{
+				randomState = seed;
+				seeded		= true;
+			}
+
+			//Where the shuffle sequence has got to, so it can be saved and picked up again
+			unsigned int GetRandomState() const 
+			{
+				return randomState;
+			}
+
+			void SetRandomState(unsigned int state) 
+			{
+				randomState = state;
+			}
+
+			//Only objects on a collision layer in layerMask can be hit
+			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, GameObject* ignore = nullptr, unsigned int layerMask = ~0u) const;
+
+			/*
+			Overlap queries fill results with up to maxResults objects touching
+			the volume (placed by the transform) and return how many they found.
+			FindNearest fills it with the (up to) maxResults objects positioned
+			closest to point, nearest first. Neither allocates anything.
+			*/
+			int Overlap(const CollisionVolume& volume, const Transform& transform, GameObject** results, int maxResults, unsigned int layerMask = ~0u) const;
+			int OverlapSphere(const Vector3& centre, float radius, GameObject** results, int maxResults, unsigned int layerMask = ~0u) const;
+			int OverlapBox(const Vector3& centre, const Vector3& halfSizes, GameObject** results, int maxResults, unsigned int layerMask = ~0u) const;
+			int OverlapBox(const Vector3& centre, const Vector3& halfSizes, const Quaternion& orientation, GameObject** results, int maxResults, unsigned int layerMask = ~0u) const;
+
+			int FindNearest(const Vector3& point, GameObject** results, int maxResults, float maxDistance = FLT_MAX, unsigned int layerMask = ~0u) const;
+
+			//Adds o to the found results, kept sorted nearest first, if it's within maxDistance of
+			//point - dropping the furthest once there's no room, and shrinking maxDistance to match
+			static int InsertNearest(const Vector3& point, GameObject* o, GameObject** results, int found, int maxResults, float& maxDistance);
+
+			//Set by the PhysicsSystem looking after this world - queries then go
+			//through its trees, instead of testing every object in turn
+			void SetPhysicsSystem(PhysicsSystem* p) 
+			{
+				physics = p;
+			}
+
+			PhysicsSystem* GetPhysicsSystem() const 
+			{
+				return physics;
+			}
 
 			virtual void UpdateWorld(float dt);
 
@@ -56,6 +119,10 @@ namespace NCL {
 				GameObjectIterator& first,
 				GameObjectIterator& last) const;
 
+			void GetStaticObjectIterators(
+				GameObjectIterator& first,
+				GameObjectIterator& last) const;
+
 			void GetConstraintIterators(
 				std::vector<Constraint*>::const_iterator& first,
 				std::vector<Constraint*>::const_iterator& last) const;
@@ -65,6 +132,12 @@ namespace NCL {
 				return worldStateCounter;
 			}
 
+			//Changes only when static objects are added or removed
+			int GetStaticStateID() const 
+			{
+				return staticStateCounter;
+			}
+
 			void SetSunPosition(const Vector3& pos) 
 			{
 				sunPosition = pos;
@@ -87,14 +160,19 @@ namespace NCL {
 
 		protected:
 			std::vector<GameObject*> gameObjects;
+			std::vector<GameObject*> staticObjects;
 			std::vector<Constraint*> constraints;
 
 			PerspectiveCamera mainCamera;
+			PhysicsSystem*	physics;
 
 			bool	shuffleConstraints;
 			bool	shuffleObjects;
+			bool	seeded;
+			unsigned int randomState;
 			int		worldIDCounter;
 			int		worldStateCounter;
+			int		staticStateCounter;
 
 			Vector3 sunPosition;
 			Vector3 sunColour;
@@ -0,0 +1,478 @@
+#include "GridClusterGraph.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//The same order NavigationGrid uses - clockwise from -z, with the diagonals odd
+	const int dirX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	const int dirZ[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+	//Runs of open border at least this long get an entrance at each end, rather than one in the middle
+	const int LongEntrance = 6;
+}
+
+HierarchicalPath::HierarchicalPath() {
+	graph	= nullptr;
+	nextLeg	= 0;
+	broken	= false;
+}
+
+void HierarchicalPath::Clear() {
+	graph	= nullptr;
+	nextLeg	= 0;
+	broken	= false;
+	route.clear();
+	startLeg.clear();
+	endLeg.clear();
+	current.Clear();
+}
+
+bool HierarchicalPath::PopWaypoint(Vector3& waypoint) {
+	while (!current.PopWaypoint(waypoint)) {
+		if (broken || nextLeg >= (int)route.size() - 1) {
+			return false;
+		}
+		RefineNextLeg();
+	}
+	return true;
+}
+
+void HierarchicalPath::RefineNextLeg() {
+	int last = (int)route.size() - 2;
+
+	std::vector<int> cachedLeg;
+	const std::vector<int>* leg = &cachedLeg;
+	if (nextLeg == 0) {
+		leg = &startLeg;
+	}
+	else if (nextLeg == last) {
+		leg = &endLeg;
+	}
+	else if (!graph->GetCachedLeg(route[nextLeg], route[nextLeg + 1], cachedLeg)) {
+		broken = true;
+		return;
+	}
+	nextLeg++;
+
+	for (auto i = leg->rbegin(); i != leg->rend(); ++i) {
+		current.PushWaypoint(graph->grid.allNodes[*i].position);
+	}
+}
+
+GridClusterGraph::GridClusterGraph(const NavigationGrid& g, int size) : grid(g) {
+	gridWidth		= grid.GetWidth();
+	gridHeight		= grid.GetHeight();
+	clusterSize		= std::max(2, size);
+	clustersWide	= (gridWidth + clusterSize - 1) / clusterSize;
+	clustersHigh	= (gridHeight + clusterSize - 1) / clusterSize;
+
+	clusters.resize(clustersWide * clustersHigh);
+	for (int cz = 0; cz < clustersHigh; ++cz) {
+		for (int cx = 0; cx < clustersWide; ++cx) {
+			Cluster& cluster = clusters[(cz * clustersWide) + cx];
+			cluster.minX	= cx * clusterSize;
+			cluster.minZ	= cz * clusterSize;
+			cluster.maxX	= std::min(gridWidth, cluster.minX + clusterSize) - 1;
+			cluster.maxZ	= std::min(gridHeight, cluster.minZ + clusterSize) - 1;
+			cluster.dirty	= false;
+			cluster.firstID	= 0;
+		}
+	}
+	entranceOf.assign(gridWidth * gridHeight, -1);
+
+	dirtyCount			= 0;
+	lastRebuildCount	= 0;
+	MarkAllDirty();
+}
+
+void GridClusterGraph::MarkAllDirty() {
+	for (Cluster& c : clusters) {
+		c.dirty = true;
+	}
+	dirtyCount = (int)clusters.size();
+}
+
+//A node on a cluster's edge also decides where the entrances on that border go, on both sides of it
+void GridClusterGraph::NodeChanged(int x, int z) {
+	auto MarkDirty = [&](int nx, int nz) {
+		if (nx < 0 || nx >= gridWidth || nz < 0 || nz >= gridHeight) {
+			return;
+		}
+		Cluster& c = clusters[ClusterOf((nz * gridWidth) + nx)];
+		if (!c.dirty) {
+			c.dirty = true;
+			dirtyCount++;
+		}
+	};
+	MarkDirty(x, z);
+	for (int dir = 0; dir < 8; dir += 2) {
+		MarkDirty(x + dirX[dir], z + dirZ[dir]);
+	}
+}
+
+void GridClusterGraph::Update() {
+	lastRebuildCount = 0;
+	if (dirtyCount == 0) {
+		return;
+	}
+	for (int i = 0; i < (int)clusters.size(); ++i) {
+		if (clusters[i].dirty) {
+			BuildCluster(i);
+			lastRebuildCount++;
+		}
+	}
+	dirtyCount = 0;
+
+	//Numbered cluster by cluster, so a cluster's entrances sit together
+	entranceNodes.clear();
+	entranceClusters.clear();
+	for (int i = 0; i < (int)clusters.size(); ++i) {
+		clusters[i].firstID = (int)entranceNodes.size();
+		entranceNodes.insert(entranceNodes.end(), clusters[i].entrances.begin(), clusters[i].entrances.end());
+		entranceClusters.insert(entranceClusters.end(), clusters[i].entrances.size(), i);
+	}
+}
+
+/*
+Steps along one border of the cluster, from the given node, looking for
+runs where both it and the node just outside (out x and z away) are floor.
+The cluster on the other side walks the same border, in the same order,
+so they both place their entrances opposite each other.
+*/
+void GridClusterGraph::AddBorderEntrances(Cluster& cluster, int x, int z, int stepX, int stepZ, int count, int outX, int outZ) {
+	if (x + outX < 0 || x + outX >= gridWidth || z + outZ < 0 || z + outZ >= gridHeight) {
+		return; //edge of the grid, nothing on the other side
+	}
+	int runStart = -1;
+	for (int i = 0; i <= count; ++i) {
+		int px		= x + (stepX * i);
+		int pz		= z + (stepZ * i);
+		bool open	= i < count && grid.Walkable(px, pz) && grid.Walkable(px + outX, pz + outZ);
+
+		if (open && runStart < 0) {
+			runStart = i;
+		}
+		else if (!open && runStart >= 0) {
+			int runEnd = i - 1;
+			if (runEnd - runStart + 1 >= LongEntrance) {
+				cluster.entrances.push_back(((z + (stepZ * runStart)) * gridWidth) + x + (stepX * runStart));
+				cluster.entrances.push_back(((z + (stepZ * runEnd)) * gridWidth) + x + (stepX * runEnd));
+			}
+			else {
+				int mid = (runStart + runEnd) / 2;
+				cluster.entrances.push_back(((z + (stepZ * mid)) * gridWidth) + x + (stepX * mid));
+			}
+			runStart = -1;
+		}
+	}
+}
+
+/*
+Finds the cluster's entrances, then searches out from each one across the
+cluster, keeping the cost and path to every entrance after it that it can
+reach. Each path is only stored once, with an edge going each way.
+*/
+void GridClusterGraph::BuildCluster(int index) {
+	Cluster& cluster = clusters[index];
+	for (int e : cluster.entrances) {
+		entranceOf[e] = -1;
+	}
+	cluster.entrances.clear();
+	cluster.firstEdge.clear();
+	cluster.edges.clear();
+	cluster.paths.clear();
+
+	int width	= cluster.maxX - cluster.minX + 1;
+	int height	= cluster.maxZ - cluster.minZ + 1;
+	AddBorderEntrances(cluster, cluster.minX, cluster.minZ, 1, 0, width, 0, -1);
+	AddBorderEntrances(cluster, cluster.minX, cluster.maxZ, 1, 0, width, 0, 1);
+	AddBorderEntrances(cluster, cluster.minX, cluster.minZ, 0, 1, height, -1, 0);
+	AddBorderEntrances(cluster, cluster.maxX, cluster.minZ, 0, 1, height, 1, 0);
+
+	//A corner node can be an entrance for two borders at once
+	std::sort(cluster.entrances.begin(), cluster.entrances.end());
+	cluster.entrances.erase(std::unique(cluster.entrances.begin(), cluster.entrances.end()), cluster.entrances.end());
+
+	int entranceCount = (int)cluster.entrances.size();
+	for (int i = 0; i < entranceCount; ++i) {
+		entranceOf[cluster.entrances[i]] = i;
+	}
+
+	std::vector<std::vector<Edge>> edges(entranceCount);
+	for (int i = 0; i < entranceCount - 1; ++i) {
+		SearchCluster(buildContext, cluster, cluster.entrances[i], -1);
+
+		for (int j = i + 1; j < entranceCount; ++j) {
+			const GridSearchContext::NodeState& state = buildContext.nodes[cluster.entrances[j]];
+			if (state.search != buildContext.search) {
+				continue; //couldn't get there without leaving the cluster
+			}
+			int pathStart = (int)cluster.paths.size();
+			for (int n = cluster.entrances[j]; n >= 0; n = buildContext.nodes[n].parent) {
+				cluster.paths.push_back(n);
+			}
+			std::reverse(cluster.paths.begin() + pathStart, cluster.paths.end());
+			int pathLength = (int)cluster.paths.size() - pathStart;
+
+			edges[i].push_back({ j, state.g, pathStart, pathLength, false });
+			edges[j].push_back({ i, state.g, pathStart, pathLength, true });
+		}
+	}
+
+	cluster.firstEdge.reserve(entranceCount + 1);
+	for (int i = 0; i < entranceCount; ++i) {
+		cluster.firstEdge.push_back((int)cluster.edges.size());
+		cluster.edges.insert(cluster.edges.end(), edges[i].begin(), edges[i].end());
+	}
+	cluster.firstEdge.push_back((int)cluster.edges.size());
+	cluster.dirty = false;
+}
+
+/*
+Searches outwards from a node without leaving its cluster. With an end
+node, it's an A* search that stops there, otherwise it carries on until
+everything in the cluster it can reach has been reached.
+*/
+bool GridClusterGraph::SearchCluster(GridSearchContext& context, const Cluster& cluster, int fromNode, int toNode) const {
+	context.BeginSearch(gridWidth * gridHeight);
+
+	GridSearchContext::NodeState& start = context.nodes[fromNode];
+	start.g			= 0.0f;
+	start.parent	= -1;
+	start.search	= context.search;
+	context.Push(fromNode, grid.Heuristic(fromNode, toNode), 0.0f);
+
+	int dirStep = grid.GetDiagonalMovement() ? 1 : 2;
+
+	while (!context.open.empty()) {
+		int current = context.Pop();
+		context.nodesExpanded++;
+		if (current == toNode) {
+			return true;
+		}
+		int x = current % gridWidth;
+		int z = current / gridWidth;
+		for (int dir = 0; dir < 8; dir += dirStep) {
+			int nx = x + dirX[dir];
+			int nz = z + dirZ[dir];
+			if (nx < cluster.minX || nx > cluster.maxX || nz < cluster.minZ || nz > cluster.maxZ) {
+				continue;
+			}
+			if (grid.CanStep(x, z, dirX[dir], dirZ[dir])) {
+				grid.AddSuccessor(context, current, (nz * gridWidth) + nx, toNode);
+			}
+		}
+	}
+	return toNode < 0;
+}
+
+//The nodes after 'from', up to and including 'to' - either a step over a border, or a search within one cluster
+bool GridClusterGraph::FindLocalLeg(GridSearchContext& context, int fromNode, int toNode, std::vector<int>& leg) const {
+	leg.clear();
+	int cluster = ClusterOf(fromNode);
+	if (cluster != ClusterOf(toNode)) {
+		leg.push_back(toNode);
+		return true;
+	}
+	if (!SearchCluster(context, clusters[cluster], fromNode, toNode)) {
+		return false;
+	}
+	for (int n = toNode; n != fromNode; n = context.nodes[n].parent) {
+		leg.push_back(n);
+	}
+	std::reverse(leg.begin(), leg.end());
+	return true;
+}
+
+//Same as FindLocalLeg, but between two entrances, so it can be read straight from the cluster's cached paths
+bool GridClusterGraph::GetCachedLeg(int fromNode, int toNode, std::vector<int>& leg) const {
+	leg.clear();
+	int clusterIndex = ClusterOf(fromNode);
+	if (clusterIndex != ClusterOf(toNode)) {
+		leg.push_back(toNode);
+		return true;
+	}
+	const Cluster& cluster = clusters[clusterIndex];
+	int from	= entranceOf[fromNode];
+	int to		= entranceOf[toNode];
+	if (from < 0 || to < 0 || cluster.dirty) {
+		return false;
+	}
+	for (int e = cluster.firstEdge[from]; e < cluster.firstEdge[from + 1]; ++e) {
+		const Edge& edge = cluster.edges[e];
+		if (edge.to != to) {
+			continue;
+		}
+		const int* path = &cluster.paths[edge.pathStart];
+		for (int i = 1; i < edge.pathLength; ++i) {
+			leg.push_back(edge.reversed ? path[edge.pathLength - 1 - i] : path[i]);
+		}
+		return true;
+	}
+	return false;
+}
+
+/*
+Joins the start and end onto the graph, by searching their clusters for
+the cost to each entrance, then runs A* over the entrances - from each,
+its cached edges to the rest of its cluster, and single steps over the
+border to entrances next to it. Only the first and last legs are filled
+in now; they're the only ones that aren't cached.
+
+The A* works on entrance numbers rather than grid nodes, with the start
+and end numbered after the last entrance if they aren't entrances
+themselves, so its state is all close together.
+*/
+bool GridClusterGraph::FindPath(int startNode, int endNode, HierarchicalPath& outPath, GridSearchContext& context) const {
+	outPath.Clear();
+	outPath.graph = this;
+
+	if (startNode == endNode) {
+		outPath.route.push_back(startNode);
+		outPath.current.PushWaypoint(grid.allNodes[startNode].position);
+		context.nodesExpanded = 0;
+		return true;
+	}
+	if (!grid.Walkable(endNode % gridWidth, endNode / gridWidth)) {
+		return false;
+	}
+	int expanded = 0;
+
+	int startCluster		= ClusterOf(startNode);
+	int endCluster			= ClusterOf(endNode);
+	const Cluster& starts	= clusters[startCluster];
+	const Cluster& ends		= clusters[endCluster];
+
+	std::vector<float> endCosts(ends.entrances.size(), -1.0f);
+	SearchCluster(context, ends, endNode, -1);
+	for (size_t i = 0; i < ends.entrances.size(); ++i) {
+		const GridSearchContext::NodeState& state = context.nodes[ends.entrances[i]];
+		if (state.search == context.search) {
+			endCosts[i] = state.g;
+		}
+	}
+	expanded += context.nodesExpanded;
+
+	float directCost = -1.0f;
+	std::vector<float> startCosts(starts.entrances.size(), -1.0f);
+	SearchCluster(context, starts, startNode, -1);
+	for (size_t i = 0; i < starts.entrances.size(); ++i) {
+		const GridSearchContext::NodeState& state = context.nodes[starts.entrances[i]];
+		if (state.search == context.search) {
+			startCosts[i] = state.g;
+		}
+	}
+	if (startCluster == endCluster && context.nodes[endNode].search == context.search) {
+		directCost = context.nodes[endNode].g;
+	}
+	expanded += context.nodesExpanded;
+
+	int entranceCount	= (int)entranceNodes.size();
+	int startID			= entranceOf[startNode] >= 0 ? starts.firstID + entranceOf[startNode] : entranceCount;
+	int endID			= entranceOf[endNode] >= 0 ? ends.firstID + entranceOf[endNode] : entranceCount + 1;
+	auto NodeOf = [&](int id) {
+		return id == startID ? startNode : (id == endID ? endNode : entranceNodes[id]);
+	};
+
+	context.BeginSearch(entranceCount + 2);
+
+	GridSearchContext::NodeState& start = context.nodes[startID];
+	start.g			= 0.0f;
+	start.parent	= -1;
+	start.search	= context.search;
+	context.Push(startID, grid.Heuristic(startNode, endNode), 0.0f);
+
+	bool found = false;
+	while (!context.open.empty()) {
+		int current = context.Pop();
+		context.nodesExpanded++;
+		if (current == endID) {
+			found = true;
+			break;
+		}
+		float g = context.nodes[current].g;
+
+		if (current == startID) {
+			for (int i = 0; i < (int)starts.entrances.size(); ++i) {
+				if (startCosts[i] >= 0.0f && starts.firstID + i != startID) {
+					AddSuccessor(context, current, starts.firstID + i, starts.entrances[i], g + startCosts[i], endNode);
+				}
+			}
+			if (directCost >= 0.0f) {
+				AddSuccessor(context, current, endID, endNode, g + directCost, endNode);
+			}
+			if (current == entranceCount) {
+				continue; //not an entrance, so nothing more to go on to
+			}
+		}
+		int node				= entranceNodes[current];
+		int clusterIndex		= entranceClusters[current];
+		const Cluster& cluster	= clusters[clusterIndex];
+		int entrance			= current - cluster.firstID;
+
+		if (current != startID) {
+			for (int e = cluster.firstEdge[entrance]; e < cluster.firstEdge[entrance + 1]; ++e) {
+				const Edge& edge = cluster.edges[e];
+				AddSuccessor(context, current, cluster.firstID + edge.to, cluster.entrances[edge.to], g + edge.cost, endNode);
+			}
+		}
+		int x = node % gridWidth;
+		int z = node / gridWidth;
+		for (int dir = 0; dir < 8; dir += 2) {
+			int nx = x + dirX[dir];
+			int nz = z + dirZ[dir];
+			if (!grid.Walkable(nx, nz)) {
+				continue;
+			}
+			int neighbour	= (nz * gridWidth) + nx;
+			int across		= ClusterOf(neighbour);
+			if (entranceOf[neighbour] >= 0 && across != clusterIndex) {
+				AddSuccessor(context, current, clusters[across].firstID + entranceOf[neighbour], neighbour, g + 1.0f, endNode);
+			}
+		}
+		if (clusterIndex == endCluster && endCosts[entrance] >= 0.0f) {
+			AddSuccessor(context, current, endID, endNode, g + endCosts[entrance], endNode);
+		}
+	}
+	expanded += context.nodesExpanded;
+
+	if (found) {
+		for (int id = endID; id >= 0; id = context.nodes[id].parent) {
+			outPath.route.push_back(NodeOf(id));
+		}
+		std::reverse(outPath.route.begin(), outPath.route.end());
+
+		int legs = (int)outPath.route.size() - 1;
+		FindLocalLeg(context, outPath.route[0], outPath.route[1], outPath.startLeg);
+		if (legs > 1) {
+			FindLocalLeg(context, outPath.route[legs - 1], outPath.route[legs], outPath.endLeg);
+		}
+		outPath.current.PushWaypoint(grid.allNodes[startNode].position);
+		expanded += context.nodesExpanded;
+	}
+	context.nodesExpanded = expanded;
+	return found;
+}
+
+//As NavigationGrid::AddSuccessor, but for entrance numbers, which can be any distance apart
+void GridClusterGraph::AddSuccessor(GridSearchContext& context, int current, int successor, int successorNode, float g, int endNode) const {
+	GridSearchContext::NodeState& state = context.nodes[successor];
+	bool inOpen = state.search == context.search;
+	if (inOpen && (state.heapIndex == GridSearchContext::Closed || g >= state.g)) {
+		return;
+	}
+	state.g			= g;
+	state.parent	= current;
+	state.search	= context.search;
+
+	float f = g + grid.Heuristic(successorNode, endNode);
+	if (inOpen) {
+		context.Update(successor, f, g);
+	}
+	else {
+		context.Push(successor, f, g);
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include "NavigationGrid.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class GridClusterGraph;
+
+		/*
+		A path found by a GridClusterGraph search. To begin with it's only the
+		list of entrance nodes the path goes through - the nodes in between
+		each pair are filled in from the graph's cached paths as the path is
+		walked, one leg at a time, so an agent that repaths before getting
+		far never pays for the rest.
+
+		The legs are read from the graph when they're reached, so edits made
+		to the grid after the search can leave the rest of the path out of
+		date. If a leg can no longer be found, the path just ends there, and
+		IsBroken says so.
+		*/
+		class HierarchicalPath {
+		public:
+			HierarchicalPath();
+			~HierarchicalPath() = default;
+
+			void	Clear();
+			bool	PopWaypoint(Vector3& waypoint);
+
+			//Nodes the search went through - the start, each entrance, and the end
+			int GetRouteLength() const {
+				return (int)route.size();
+			}
+
+			//How many legs between them have been filled in so far
+			int GetLegsRefined() const {
+				return nextLeg;
+			}
+
+			bool IsBroken() const {
+				return broken;
+			}
+
+		protected:
+			friend class GridClusterGraph;
+			friend class NavigationGrid;
+
+			void	RefineNextLeg();
+
+			const GridClusterGraph* graph;
+
+			std::vector<int>	route;
+			std::vector<int>	startLeg;	//Worked out during the search, as they're not cached anywhere
+			std::vector<int>	endLeg;
+			NavigationPath		current;	//Waypoints not handed out yet, from the leg being walked
+			int					nextLeg;
+			bool				broken;
+		};
+
+		/*
+		Hierarchical pathfinding (HPA*) over a NavigationGrid. The grid is cut
+		into square clusters, and wherever floor runs across the border
+		between two clusters, a node either side of it becomes an entrance -
+		one from the middle of a short run, or one from each end of a long
+		one. Within each cluster, the shortest path between every pair of its
+		entrances is found once, and cached.
+
+		A search then only has to find its way from entrance to entrance,
+		using the cached costs, with a small search inside the start and end
+		clusters to join them on - a few thousand nodes where a full grid
+		search might expand a million. Paths found this way are usually a few
+		percent longer than the shortest, though a short one that has to go
+		out of its way to an entrance can be a good deal longer.
+
+		Changing a node only affects the cluster it's in, plus the one on
+		the other side of a border it lies on, so only those are rebuilt,
+		by the next Update.
+		*/
+		class GridClusterGraph {
+		public:
+			GridClusterGraph(const NavigationGrid& grid, int clusterSize);
+			~GridClusterGraph() = default;
+
+			//Marks the clusters a change to this node could affect, to be rebuilt by the next Update
+			void	NodeChanged(int x, int z);
+			void	MarkAllDirty();
+
+			void	Update();
+
+			bool IsValid() const {
+				return dirtyCount == 0;
+			}
+
+			//Only reads the graph, so any number of these can run at once, as long as nothing's being rebuilt
+			bool	FindPath(int startNode, int endNode, HierarchicalPath& outPath, GridSearchContext& context) const;
+
+			int GetClusterSize() const {
+				return clusterSize;
+			}
+
+			int GetClusterCount() const {
+				return (int)clusters.size();
+			}
+
+			int GetEntranceCount() const {
+				return (int)entranceNodes.size();
+			}
+
+			//How many clusters the last Update had to rebuild
+			int GetLastRebuildCount() const {
+				return lastRebuildCount;
+			}
+
+		protected:
+			friend class HierarchicalPath;
+
+			struct Edge {
+				int		to;			//Which of the cluster's entrances
+				float	cost;
+				int		pathStart;	//Where its nodes are in the cluster's paths, from one entrance to the other
+				int		pathLength;
+				bool	reversed;	//If the cached path runs the other way
+			};
+
+			struct Cluster {
+				int minX;
+				int minZ;
+				int maxX;	//Inclusive
+				int maxZ;
+
+				std::vector<int>	entrances;	//Grid nodes, in order
+				std::vector<int>	firstEdge;	//Each entrance's edges start here, with one extra at the end
+				std::vector<Edge>	edges;
+				std::vector<int>	paths;
+				int					firstID;	//What the first entrance is numbered in the whole graph
+				bool				dirty;
+			};
+
+			int ClusterOf(int node) const {
+				int x = node % gridWidth;
+				int z = node / gridWidth;
+				return ((z / clusterSize) * clustersWide) + (x / clusterSize);
+			}
+
+			void	BuildCluster(int index);
+			void	AddBorderEntrances(Cluster& cluster, int x, int z, int stepX, int stepZ, int count, int outX, int outZ);
+
+			bool	SearchCluster(GridSearchContext& context, const Cluster& cluster, int fromNode, int toNode) const;
+			bool	FindLocalLeg(GridSearchContext& context, int fromNode, int toNode, std::vector<int>& leg) const;
+			bool	GetCachedLeg(int fromNode, int toNode, std::vector<int>& leg) const;
+			void	AddSuccessor(GridSearchContext& context, int current, int successor, int successorNode, float g, int endNode) const;
+
+			const NavigationGrid& grid;
+
+			int gridWidth;
+			int gridHeight;
+			int clusterSize;
+			int clustersWide;
+			int clustersHigh;
+
+			std::vector<Cluster>	clusters;
+			std::vector<int>		entranceOf;	//Per grid node, its place in its cluster's entrances, or -1
+			std::vector<int>		entranceNodes;		//Grid node and cluster of each entrance, by its number
+			std::vector<int>		entranceClusters;
+			int						dirtyCount;
+			int						lastRebuildCount;
+
+			GridSearchContext		buildContext;
+		};
+	}
+}
@@ -0,0 +1,97 @@
+#include "IslandGraph.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+void IslandGraph::Reset(int bodyCount) {
+	parents.resize(bodyCount);
+	for (int i = 0; i < bodyCount; ++i) {
+		parents[i] = i;
+	}
+	linked.assign(bodyCount, false);
+	bodyIslands.assign(bodyCount, -1);
+	islands.clear();
+}
+
+//Union-find with path halving - every lookup flattens the tree a little more
+int IslandGraph::Find(int body) {
+	while (parents[body] != body) {
+		parents[body] = parents[parents[body]];
+		body = parents[body];
+	}
+	return body;
+}
+
+void IslandGraph::Link(int bodyA, int bodyB, bool staticA, bool staticB) {
+	bool dynamicA = bodyA >= 0 && !staticA;
+	bool dynamicB = bodyB >= 0 && !staticB;
+
+	if (dynamicA) {
+		linked[bodyA] = true;
+	}
+	if (dynamicB) {
+		linked[bodyB] = true;
+	}
+	if (!dynamicA || !dynamicB) {
+		return;
+	}
+	int rootA = Find(bodyA);
+	int rootB = Find(bodyB);
+	if (rootA == rootB) {
+		return;
+	}
+	//Lowest index as the root keeps the trees the same however the links arrive
+	if (rootA < rootB) {
+		parents[rootB] = rootA;
+	}
+	else {
+		parents[rootA] = rootB;
+	}
+}
+
+void IslandGraph::Build(const std::vector<int>& itemBodies) {
+	islands.clear();
+
+	int bodyCount = (int)parents.size();
+	for (int i = 0; i < bodyCount; ++i) {
+		if (!linked[i]) {
+			continue;
+		}
+		int root = Find(i);
+		if (root == i) {
+			bodyIslands[i] = (int)islands.size();
+			islands.push_back({ 0, 0 });
+		}
+		else {
+			//Roots are always the lowest index, so already have their island
+			bodyIslands[i] = bodyIslands[root];
+		}
+	}
+
+	int itemCount = (int)itemBodies.size();
+	itemIslands.resize(itemCount);
+	for (int i = 0; i < itemCount; ++i) {
+		int island = itemBodies[i] >= 0 ? bodyIslands[itemBodies[i]] : -1;
+		itemIslands[i] = island;
+		if (island >= 0) {
+			islands[island].itemCount++;
+		}
+	}
+
+	int offset = 0;
+	for (Island& island : islands) {
+		island.firstItem = offset;
+		offset += island.itemCount;
+		island.itemCount = 0;
+	}
+
+	sortedItems.resize(offset);
+	for (int i = 0; i < itemCount; ++i) {
+		int island = itemIslands[i];
+		if (island >= 0) {
+			Island& is = islands[island];
+			sortedItems[is.firstItem + is.itemCount] = i;
+			is.itemCount++;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Splits the bodies in the world up into islands - groups of bodies that
+		are touching, or joined by a constraint, either directly or through a
+		chain of other bodies. Nothing done to one island can affect any other,
+		so they can be solved independently of each other (and in parallel).
+
+		Bodies are identified by their index in the RigidBodyStore. Static
+		bodies (those with infinite mass) never join islands together, as
+		nothing that happens in one island can move them.
+
+		Usage is to Reset, Link every pair of bodies that interact, then Build,
+		passing in a dynamic body from each of the 'items' (contacts, constraints)
+		that made those links, to sort the items into islands. Items keep the
+		order they were given in within each island, and islands are numbered by
+		their lowest body index, so the result only depends on the input, not on
+		how it is later processed.
+		*/
+		class IslandGraph {
+		public:
+			struct Island {
+				int firstItem;
+				int itemCount;
+			};
+
+			IslandGraph() = default;
+			~IslandGraph() = default;
+
+			void Reset(int bodyCount);
+
+			//Either body may be -1 (or static), in which case nothing is joined
+			void Link(int bodyA, int bodyB, bool staticA, bool staticB);
+
+			//Items with no dynamic body (-1) end up in no island
+			void Build(const std::vector<int>& itemBodies);
+
+			int GetIslandCount() const {
+				return (int)islands.size();
+			}
+
+			const Island& GetIsland(int index) const {
+				return islands[index];
+			}
+
+			//The items of an island are GetItem(first) to GetItem(first + count - 1)
+			int GetItem(int index) const {
+				return sortedItems[index];
+			}
+
+			//Which island a body is in, or -1 if it's static or touching nothing
+			int GetBodyIsland(int body) const {
+				return bodyIslands[body];
+			}
+
+		protected:
+			int Find(int body);
+
+			std::vector<int>	parents;
+			std::vector<bool>	linked;
+			std::vector<int>	bodyIslands;
+			std::vector<int>	itemIslands;
+			std::vector<int>	sortedItems;
+			std::vector<Island>	islands;
+		};
+	}
+}
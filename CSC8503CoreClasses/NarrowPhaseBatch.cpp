@@ -0,0 +1,297 @@
+#include "NarrowPhaseBatch.h"
+#include "GameObject.h"
+#include "SIMDLanes.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+NarrowPhaseBatch::NarrowPhaseBatch() {
+}
+
+void NarrowPhaseBatch::Clear() {
+	for (int i = 0; i < BatchTypeCount; ++i) {
+		batches[i].Clear();
+	}
+	contacts.clear();
+}
+
+/*
+Sorts the pair into the right batch - as with ObjectIntersection, the AABB
+always ends up as object A in an AABB / sphere pair.
+*/
+bool NarrowPhaseBatch::Add(GameObject* a, GameObject* b) {
+	const CollisionVolume* volA = a->GetBoundingVolume();
+	const CollisionVolume* volB = b->GetBoundingVolume();
+
+	if (!volA || !volB) {
+		return false;
+	}
+	Vector3 posA = a->GetTransform().GetPosition();
+	Vector3 posB = b->GetTransform().GetPosition();
+
+	VolumeType pairType = (VolumeType)((int)volA->type | (int)volB->type);
+
+	if (pairType == VolumeType::Sphere) {
+		batches[SphereSphere].Add(
+			a, posA, Vector3(((const SphereVolume*)volA)->GetRadius(), 0, 0),
+			b, posB, Vector3(((const SphereVolume*)volB)->GetRadius(), 0, 0));
+		return true;
+	}
+	if (pairType == VolumeType::AABB) {
+		batches[AABBAABB].Add(
+			a, posA, ((const AABBVolume*)volA)->GetHalfDimensions(),
+			b, posB, ((const AABBVolume*)volB)->GetHalfDimensions());
+		return true;
+	}
+	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
+		batches[AABBSphere].Add(
+			a, posA, ((const AABBVolume*)volA)->GetHalfDimensions(),
+			b, posB, Vector3(((const SphereVolume*)volB)->GetRadius(), 0, 0));
+		return true;
+	}
+	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
+		batches[AABBSphere].Add(
+			b, posB, ((const AABBVolume*)volB)->GetHalfDimensions(),
+			a, posA, Vector3(((const SphereVolume*)volA)->GetRadius(), 0, 0));
+		return true;
+	}
+	return false;
+}
+
+//A whole number of 8 wide registers, so chunk edges always fall on a lane boundary
+const int ChunkSize = 256;
+
+void NarrowPhaseBatch::Run(JobSystem* jobs) {
+	contacts.clear();
+	chunks.clear();
+
+	for (int i = 0; i < BatchTypeCount; ++i) {
+		int count = batches[i].Pad(LaneWidth);
+		for (int first = 0; first < count; first += ChunkSize) {
+			chunks.push_back({ (BatchType)i, first, std::min(count, first + ChunkSize) });
+		}
+	}
+
+	if (!jobs || chunks.size() < 2) {
+		for (const Chunk& c : chunks) {
+			RunChunk(c, contacts);
+		}
+		return;
+	}
+
+	if (chunkContacts.size() < chunks.size()) {
+		chunkContacts.resize(chunks.size());
+	}
+	jobs->ParallelFor((int)chunks.size(), 1,
+		[&](int first, int last) {
+			for (int i = first; i < last; ++i) {
+				chunkContacts[i].clear();
+				RunChunk(chunks[i], chunkContacts[i]);
+			}
+		});
+
+	for (int i = 0; i < (int)chunks.size(); ++i) {
+		contacts.insert(contacts.end(), chunkContacts[i].begin(), chunkContacts[i].end());
+	}
+}
+
+void NarrowPhaseBatch::RunChunk(const Chunk& chunk, ContactList& out) {
+	const PairBatch& batch = batches[chunk.type];
+	switch (chunk.type) {
+		case SphereSphere:	SphereSphereKernel(batch, chunk.first, chunk.last, out);	break;
+		case AABBAABB:		AABBAABBKernel(batch, chunk.first, chunk.last, out);		break;
+		case AABBSphere:	AABBSphereKernel(batch, chunk.first, chunk.last, out);		break;
+		default:			break;	//BatchTypeCount is only a size, no chunk ever has it
+	}
+}
+
+void NarrowPhaseBatch::AddContact(ContactList& out, const PairBatch& batch, int index, const Vector3& normal,
+								  float penetration, const Vector3& localA, const Vector3& localB) {
+	CollisionDetection::CollisionInfo& info = out.emplace_back();
+	info.a = batch.objectsA[index];
+	info.b = batch.objectsB[index];
+	info.AddContactPoint(localA, localB, normal, penetration);
+}
+
+/*
+Each kernel mirrors its counterpart in CollisionDetection, just across a whole
+register of pairs at a time. Only once the mask says at least one pair in the
+register is touching are the results written out and turned into contacts.
+*/
+void NarrowPhaseBatch::SphereSphereKernel(const PairBatch& batch, int first, int last, ContactList& out) {
+	const std::vector<float>* c = batch.channels;
+
+	float nx[LaneWidth], ny[LaneWidth], nz[LaneWidth], pen[LaneWidth];
+
+	for (int i = first; i < last; i += LaneWidth) {
+		Lane dx = LaneSub(LaneLoad(&c[PairBatch::PosBX][i]), LaneLoad(&c[PairBatch::PosAX][i]));
+		Lane dy = LaneSub(LaneLoad(&c[PairBatch::PosBY][i]), LaneLoad(&c[PairBatch::PosAY][i]));
+		Lane dz = LaneSub(LaneLoad(&c[PairBatch::PosBZ][i]), LaneLoad(&c[PairBatch::PosAZ][i]));
+
+		Lane radii	= LaneAdd(LaneLoad(&c[PairBatch::SizeAX][i]), LaneLoad(&c[PairBatch::SizeBX][i]));
+		Lane length = LaneSqrt(LaneAdd(LaneAdd(LaneMul(dx, dx), LaneMul(dy, dy)), LaneMul(dz, dz)));
+
+		int hits = LaneBits(LaneLess(length, radii));
+		if (!hits) {
+			continue;
+		}
+		Lane r = LaneSafeReciprocal(length);
+		LaneStore(nx, LaneMul(dx, r));
+		LaneStore(ny, LaneMul(dy, r));
+		LaneStore(nz, LaneMul(dz, r));
+		LaneStore(pen, LaneSub(radii, length));
+
+		for (int j = 0; j < LaneWidth; ++j) {
+			if (hits & (1 << j)) {
+				Vector3 normal(nx[j], ny[j], nz[j]);
+				AddContact(out, batch, i + j, normal, pen[j],
+					normal * c[PairBatch::SizeAX][i + j], -normal * c[PairBatch::SizeBX][i + j]);
+			}
+		}
+	}
+}
+
+void NarrowPhaseBatch::AABBAABBKernel(const PairBatch& batch, int first, int last, ContactList& out) {
+	static const Vector3 faces[6] = {
+		Vector3(-1, 0, 0), Vector3(1, 0, 0),
+		Vector3(0, -1, 0), Vector3(0, 1, 0),
+		Vector3(0, 0, -1), Vector3(0, 0, 1)
+	};
+	const std::vector<float>* c = batch.channels;
+
+	float axis[LaneWidth], pen[LaneWidth];
+
+	for (int i = first; i < last; i += LaneWidth) {
+		LaneMask overlap;
+		Lane distances[6];
+		for (int a = 0; a < 3; ++a) {
+			Lane posA	= LaneLoad(&c[PairBatch::PosAX + a][i]);
+			Lane posB	= LaneLoad(&c[PairBatch::PosBX + a][i]);
+			Lane sizeA	= LaneLoad(&c[PairBatch::SizeAX + a][i]);
+			Lane sizeB	= LaneLoad(&c[PairBatch::SizeBX + a][i]);
+
+			LaneMask axisOverlap = LaneLess(LaneAbs(LaneSub(posB, posA)), LaneAdd(sizeA, sizeB));
+			overlap = (a == 0) ? axisOverlap : LaneAnd(overlap, axisOverlap);
+
+			distances[a * 2]		= LaneSub(LaneAdd(posB, sizeB), LaneSub(posA, sizeA));
+			distances[a * 2 + 1]	= LaneSub(LaneAdd(posA, sizeA), LaneSub(posB, sizeB));
+		}
+		int hits = LaneBits(overlap);
+		if (!hits) {
+			continue;
+		}
+		//The first, smallest distance wins, so ties go the same way as AABBIntersection
+		Lane best		= distances[0];
+		Lane bestAxis	= LaneSplat(0.0f);
+		for (int f = 1; f < 6; ++f) {
+			LaneMask closer = LaneLess(distances[f], best);
+			best		= LaneSelect(best, distances[f], closer);
+			bestAxis	= LaneSelect(bestAxis, LaneSplat((float)f), closer);
+		}
+		LaneStore(axis, bestAxis);
+		LaneStore(pen, best);
+
+		for (int j = 0; j < LaneWidth; ++j) {
+			if (hits & (1 << j)) {
+				int index	= i + j;
+				int face	= (int)axis[j];
+
+				CollisionDetection::CollisionInfo& info = out.emplace_back();
+				info.a = batch.objectsA[index];
+				info.b = batch.objectsB[index];
+				CollisionDetection::AddAABBContactFace(
+					Vector3(c[PairBatch::PosAX][index], c[PairBatch::PosAY][index], c[PairBatch::PosAZ][index]),
+					Vector3(c[PairBatch::SizeAX][index], c[PairBatch::SizeAY][index], c[PairBatch::SizeAZ][index]),
+					Vector3(c[PairBatch::PosBX][index], c[PairBatch::PosBY][index], c[PairBatch::PosBZ][index]),
+					Vector3(c[PairBatch::SizeBX][index], c[PairBatch::SizeBY][index], c[PairBatch::SizeBZ][index]),
+					face / 2, faces[face], pen[j], info);
+			}
+		}
+	}
+}
+
+void NarrowPhaseBatch::AABBSphereKernel(const PairBatch& batch, int first, int last, ContactList& out) {
+	const std::vector<float>* c = batch.channels;
+
+	float nx[LaneWidth], ny[LaneWidth], nz[LaneWidth], pen[LaneWidth];
+
+	for (int i = first; i < last; i += LaneWidth) {
+		Lane local[3];
+		for (int a = 0; a < 3; ++a) {
+			Lane delta		= LaneSub(LaneLoad(&c[PairBatch::PosBX + a][i]), LaneLoad(&c[PairBatch::PosAX + a][i]));
+			Lane boxSize	= LaneLoad(&c[PairBatch::SizeAX + a][i]);
+			Lane closest	= LaneMin(LaneMax(delta, LaneSub(LaneSplat(0.0f), boxSize)), boxSize);
+			local[a] = LaneSub(delta, closest);
+		}
+		Lane radius		= LaneLoad(&c[PairBatch::SizeBX][i]);
+		Lane distance	= LaneSqrt(LaneAdd(LaneAdd(LaneMul(local[0], local[0]), LaneMul(local[1], local[1])), LaneMul(local[2], local[2])));
+
+		int hits = LaneBits(LaneLess(distance, radius));
+		if (!hits) {
+			continue;
+		}
+		Lane r = LaneSafeReciprocal(distance);
+		LaneStore(nx, LaneMul(local[0], r));
+		LaneStore(ny, LaneMul(local[1], r));
+		LaneStore(nz, LaneMul(local[2], r));
+		LaneStore(pen, LaneSub(radius, distance));
+
+		for (int j = 0; j < LaneWidth; ++j) {
+			if (hits & (1 << j)) {
+				Vector3 normal(nx[j], ny[j], nz[j]);
+				AddContact(out, batch, i + j, normal, pen[j],
+					Vector3(), -normal * c[PairBatch::SizeBX][i + j]);
+			}
+		}
+	}
+}
+
+void NarrowPhaseBatch::PairBatch::Add(GameObject* a, const Vector3& posA, const Vector3& sizeA,
+									  GameObject* b, const Vector3& posB, const Vector3& sizeB) {
+	if (count == (int)objectsA.size()) {
+		Grow();
+	}
+	channels[PosAX][count]	= posA.x;
+	channels[PosAY][count]	= posA.y;
+	channels[PosAZ][count]	= posA.z;
+	channels[SizeAX][count] = sizeA.x;
+	channels[SizeAY][count] = sizeA.y;
+	channels[SizeAZ][count] = sizeA.z;
+
+	channels[PosBX][count]	= posB.x;
+	channels[PosBY][count]	= posB.y;
+	channels[PosBZ][count]	= posB.z;
+	channels[SizeBX][count] = sizeB.x;
+	channels[SizeBY][count] = sizeB.y;
+	channels[SizeBZ][count] = sizeB.z;
+
+	objectsA[count] = a;
+	objectsB[count] = b;
+	count++;
+}
+
+/*
+The arrays only ever grow, and are kept a multiple of 8 floats long (plus one
+register's worth), so there's always room to pad out the final register.
+*/
+void NarrowPhaseBatch::PairBatch::Grow() {
+	int capacity = std::max(64, (int)objectsA.size() * 2);
+	for (int i = 0; i < ChannelCount; ++i) {
+		channels[i].resize(capacity + 8);
+	}
+	objectsA.resize(capacity);
+	objectsB.resize(capacity);
+}
+
+/*
+Padding pairs have zero size, and sit so far apart that none of the kernels
+can ever report them as touching, so they never reach the contact list.
+*/
+int NarrowPhaseBatch::PairBatch::Pad(int laneWidth) {
+	int padded = ((count + laneWidth - 1) / laneWidth) * laneWidth;
+	for (int i = 0; i < ChannelCount; ++i) {
+		float value = (i >= PosBX && i <= PosBZ) ? 1e30f : 0.0f;
+		std::fill(channels[i].begin() + count, channels[i].begin() + padded, value);
+	}
+	return padded;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "CollisionDetection.h"
+#include "JobSystem.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Runs the narrow phase for the common shape pairs (sphere / sphere,
+		AABB / AABB and AABB / sphere) in bulk. Candidate pairs are sorted into
+		one batch per pair type, with the positions and sizes of both objects
+		packed into arrays of floats, and each batch is then tested 4 (SSE) or
+		8 (AVX2) pairs at a time. Every pair found to be touching is written
+		to a single contiguous list of contacts.
+
+		Pairs of any other type are rejected by Add, and should go through
+		CollisionDetection::ObjectIntersection as before.
+
+		Given a JobSystem, the batches are cut into fixed size chunks that are
+		tested in parallel, and the chunks' contacts then joined back together
+		in order - so the contact list comes out the same on any thread count.
+		*/
+		class NarrowPhaseBatch {
+		public:
+			enum BatchType {
+				SphereSphere,
+				AABBAABB,
+				AABBSphere,
+				BatchTypeCount
+			};
+
+			NarrowPhaseBatch();
+			~NarrowPhaseBatch() = default;
+
+			void Clear();
+
+			//Returns false if the pair isn't one of the batched types
+			bool Add(GameObject* a, GameObject* b);
+
+			//Tests every pair added since the last Clear, filling the contact list
+			void Run(JobSystem* jobs = nullptr);
+
+			int GetContactCount() const {
+				return (int)contacts.size();
+			}
+
+			const CollisionDetection::CollisionInfo& GetContact(int index) const {
+				return contacts[index];
+			}
+
+		protected:
+			/*
+			A single pair type's worth of candidate pairs. For spheres, only the
+			first size channel is used, and holds the radius.
+			*/
+			struct PairBatch {
+				enum Channel {
+					PosAX, PosAY, PosAZ,
+					SizeAX, SizeAY, SizeAZ,
+					PosBX, PosBY, PosBZ,
+					SizeBX, SizeBY, SizeBZ,
+					ChannelCount
+				};
+				std::vector<float>			channels[ChannelCount];
+				std::vector<GameObject*>	objectsA;
+				std::vector<GameObject*>	objectsB;
+				int							count = 0;
+
+				void Clear() {
+					count = 0;
+				}
+				void Add(GameObject* a, const Vector3& posA, const Vector3& sizeA,
+						 GameObject* b, const Vector3& posB, const Vector3& sizeB);
+				//Fills the arrays up to a whole number of SIMD lanes with pairs that can't
+				//collide, and returns how many pairs the kernel should then run over
+				int Pad(int laneWidth);
+
+				int Size() const {
+					return count;
+				}
+			protected:
+				void Grow();
+			};
+
+			typedef std::vector<CollisionDetection::CollisionInfo> ContactList;
+
+			//A range of pairs from one batch - the unit of work handed out to threads
+			struct Chunk {
+				BatchType	type;
+				int			first;
+				int			last;
+			};
+
+			void RunChunk(const Chunk& chunk, ContactList& out);
+
+			void SphereSphereKernel(const PairBatch& batch, int first, int last, ContactList& out);
+			void AABBAABBKernel(const PairBatch& batch, int first, int last, ContactList& out);
+			void AABBSphereKernel(const PairBatch& batch, int first, int last, ContactList& out);
+
+			void AddContact(ContactList& out, const PairBatch& batch, int index, const Vector3& normal,
+							float penetration, const Vector3& localA, const Vector3& localB);
+
+			PairBatch	batches[BatchTypeCount];
+			ContactList	contacts;
+
+			std::vector<Chunk>			chunks;
+			std::vector<ContactList>	chunkContacts;
+		};
+	}
+}
@@ -1,4 +1,5 @@
 #include "NavigationGrid.h"
+#include "GridClusterGraph.h"
 #include "Assets.h"
 
 #include <fstream>
@@ -14,11 +15,34 @@ const int BOTTOM_NODE	= 3;
 const char WALL_NODE	= 'x';
 const char FLOOR_NODE	= '.';
 
+namespace {
+	//Clockwise from -z, so a direction's neighbours are either side of it, and the diagonals are the odd ones
+	const int dirX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	const int dirZ[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+	const float DiagonalCost = 1.41421356f;
+
+	int Sign(int v) {
+		return (v > 0) - (v < 0);
+	}
+
+	int DirectionOf(int dx, int dz) {
+		const int dirs[9] = { 7, 0, 1, 6, -1, 2, 5, 4, 3 };
+		return dirs[((dz + 1) * 3) + dx + 1];
+	}
+}
+
 NavigationGrid::NavigationGrid()	{
 	nodeSize	= 0;
 	gridWidth	= 0;
 	gridHeight	= 0;
 	allNodes	= nullptr;
+
+	jumpDistancesValid	= false;
+	clusterGraph		= nullptr;
+	changeCount			= 0;
+	searchMode			= SearchMode::AStar;
+	diagonalMovement	= false;
 }
 
 NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
@@ -39,138 +63,589 @@ NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
 			n.position = Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
 		}
 	}
-	
-	//now to build the connectivity between the nodes
+	BuildConnections();
+}
+
+NavigationGrid::NavigationGrid(int width, int height, int size, const std::vector<char>& types) : NavigationGrid() {
+	nodeSize	= size;
+	gridWidth	= width;
+	gridHeight	= height;
+
+	allNodes = new GridNode[gridWidth * gridHeight];
+
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
-			GridNode&n = allNodes[(gridWidth * y) + x];		
+			GridNode&n = allNodes[(gridWidth * y) + x];
+			n.type = types[(gridWidth * y) + x];
+			n.position = Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
+		}
+	}
+	BuildConnections();
+}
 
-			if (y > 0) { //get the above node
-				n.connected[0] = &allNodes[(gridWidth * (y - 1)) + x];
-			}
-			if (y < gridHeight - 1) { //get the below node
-				n.connected[1] = &allNodes[(gridWidth * (y + 1)) + x];
-			}
-			if (x > 0) { //get left node
-				n.connected[2] = &allNodes[(gridWidth * (y)) + (x - 1)];
-			}
-			if (x < gridWidth - 1) { //get right node
-				n.connected[3] = &allNodes[(gridWidth * (y)) + (x + 1)];
+NavigationGrid::~NavigationGrid()	{
+	delete clusterGraph;
+	delete[] allNodes;
+}
+
+void NavigationGrid::BuildConnections() {
+	walkable.resize(gridWidth * gridHeight);
+	for (int y = 0; y < gridHeight; ++y) {
+		for (int x = 0; x < gridWidth; ++x) {
+			walkable[(gridWidth * y) + x] = allNodes[(gridWidth * y) + x].type != WALL_NODE;
+			ConnectNode(x, y);
+		}	
+	}
+	jumpDistancesValid = false;
+}
+
+void NavigationGrid::ConnectNode(int x, int y) {
+	GridNode&n = allNodes[(gridWidth * y) + x];
+
+	for (int i = 0; i < 4; ++i) {
+		n.connected[i]	= nullptr;
+		n.costs[i]		= 0;
+	}
+	if (y > 0) { //get the above node
+		n.connected[0] = &allNodes[(gridWidth * (y - 1)) + x];
+	}
+	if (y < gridHeight - 1) { //get the below node
+		n.connected[1] = &allNodes[(gridWidth * (y + 1)) + x];
+	}
+	if (x > 0) { //get left node
+		n.connected[2] = &allNodes[(gridWidth * (y)) + (x - 1)];
+	}
+	if (x < gridWidth - 1) { //get right node
+		n.connected[3] = &allNodes[(gridWidth * (y)) + (x + 1)];
+	}
+	for (int i = 0; i < 4; ++i) {
+		if (n.connected[i]) {
+			if (n.connected[i]->type == WALL_NODE) {
+				n.connected[i] = nullptr; //actually a wall, disconnect!
 			}
-			for (int i = 0; i < 4; ++i) {
-				if (n.connected[i]) {
-					if (n.connected[i]->type == '.') {
-						n.costs[i]		= 1;
-					}
-					if (n.connected[i]->type == 'x') {
-						n.connected[i] = nullptr; //actually a wall, disconnect!
-					}
-				}
+			else {
+				n.costs[i] = 1;
 			}
-		}	
+		}
 	}
 }
 
-NavigationGrid::~NavigationGrid()	{
-	delete[] allNodes;
+bool NavigationGrid::IsWalkable(int x, int z) const {
+	return Walkable(x, z);
+}
+
+bool NavigationGrid::GetNode(const Vector3& position, int& x, int& z) const {
+	x = ((int)position.x / nodeSize);
+	z = ((int)position.z / nodeSize);
+
+	return x >= 0 && x < gridWidth && z >= 0 && z < gridHeight;
+}
+
+void NavigationGrid::SetNodeType(int x, int z, char type) {
+	if (x < 0 || x > gridWidth - 1 || z < 0 || z > gridHeight - 1) {
+		return;
+	}
+	allNodes[(z * gridWidth) + x].type	= type;
+	walkable[(z * gridWidth) + x]		= type != WALL_NODE;
+
+	//Only this node and the ones either side of it can have gained or lost a connection
+	for (int i = 0; i < 8; i += 2) {
+		if (x + dirX[i] >= 0 && x + dirX[i] < gridWidth && z + dirZ[i] >= 0 && z + dirZ[i] < gridHeight) {
+			ConnectNode(x + dirX[i], z + dirZ[i]);
+		}
+	}
+	ConnectNode(x, z);
+	jumpDistancesValid = false;
+	changeCount++;
+	if (clusterGraph) {
+		clusterGraph->NodeChanged(x, z);
+	}
+}
+
+void NavigationGrid::SetSearchMode(SearchMode mode) {
+	searchMode = mode;
+	if (searchMode == SearchMode::JumpPointPlus && !jumpDistancesValid) {
+		UpdateJumpDistances();
+	}
+	if (searchMode == SearchMode::Hierarchical) {
+		UpdateClusterGraph();
+	}
+}
+
+//The jump distances depend on which way things can move, so have to be worked out again
+void NavigationGrid::SetDiagonalMovement(bool state) {
+	if (diagonalMovement == state) {
+		return;
+	}
+	diagonalMovement	= state;
+	jumpDistancesValid	= false;
+	changeCount++;
+	if (clusterGraph) {
+		clusterGraph->MarkAllDirty();
+	}
+	if (searchMode == SearchMode::JumpPointPlus) {
+		UpdateJumpDistances();
+	}
+	if (searchMode == SearchMode::Hierarchical) {
+		UpdateClusterGraph();
+	}
+}
+
+void NavigationGrid::BuildClusterGraph(int clusterSize) {
+	delete clusterGraph;
+	clusterGraph = new GridClusterGraph(*this, clusterSize);
+	clusterGraph->Update();
+}
+
+//With no graph yet, builds one with the default cluster size
+void NavigationGrid::UpdateClusterGraph() {
+	if (!clusterGraph) {
+		BuildClusterGraph();
+		return;
+	}
+	clusterGraph->Update();
+}
+
+bool NavigationGrid::ClusterGraphValid() const {
+	return clusterGraph && clusterGraph->IsValid();
 }
 
 bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
-	//need to work out which node 'from' sits in, and 'to' sits in
-	int fromX = ((int)from.x / nodeSize);
-	int fromZ = ((int)from.z / nodeSize);
+	if (searchMode == SearchMode::JumpPointPlus && !jumpDistancesValid) {
+		UpdateJumpDistances();
+	}
+	if (searchMode == SearchMode::Hierarchical && !ClusterGraphValid()) {
+		UpdateClusterGraph();
+	}
+	return FindPath(from, to, outPath, searchContext);
+}
 
-	int toX = ((int)to.x / nodeSize);
-	int toZ = ((int)to.z / nodeSize);
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, HierarchicalPath& outPath, GridSearchContext& context) const {
+	outPath.Clear();
 
-	if (fromX < 0 || fromX > gridWidth - 1 ||
-		fromZ < 0 || fromZ > gridHeight - 1) {
+	int fromX, fromZ, toX, toZ;
+	if (!GetNode(from, fromX, fromZ) || !GetNode(to, toX, toZ)) {
 		return false; //outside of map region!
 	}
+	//A start inside a wall can step out over a border where there's no entrance, which the graph knows nothing about
+	if (ClusterGraphValid() && Walkable(fromX, fromZ)) {
+		return clusterGraph->FindPath((fromZ * gridWidth) + fromX, (toZ * gridWidth) + toX, outPath, context);
+	}
+	NavigationPath fullPath;
+	bool found = FindPath(from, to, fullPath, context, SearchMode::JumpPoint);
 
-	if (toX < 0 || toX > gridWidth - 1 ||
-		toZ < 0 || toZ > gridHeight - 1) {
-		return false; //outside of map region!
+	//Backwards into the path's waypoints, so they still come out start first
+	std::vector<Vector3> waypoints;
+	Vector3 waypoint;
+	while (fullPath.PopWaypoint(waypoint)) {
+		waypoints.push_back(waypoint);
 	}
+	for (auto i = waypoints.rbegin(); i != waypoints.rend(); ++i) {
+		outPath.current.PushWaypoint(*i);
+	}
+	return found;
+}
 
-	GridNode* startNode = &allNodes[(fromZ * gridWidth) + fromX];
-	GridNode* endNode	= &allNodes[(toZ * gridWidth) + toX];
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, GridSearchContext& context) const {
+	SearchMode mode = searchMode;
+	if ((mode == SearchMode::JumpPointPlus && !jumpDistancesValid) ||
+		(mode == SearchMode::Hierarchical && !ClusterGraphValid())) {
+		mode = SearchMode::JumpPoint;
+	}
+	if (mode != SearchMode::Hierarchical) {
+		return FindPath(from, to, outPath, context, mode);
+	}
+	HierarchicalPath path;
+	if (!FindPath(from, to, path, context)) {
+		return false;
+	}
+	//Filled in all at once, end first, as that's how a NavigationPath hands them back
+	std::vector<Vector3> waypoints;
+	Vector3 waypoint;
+	while (path.PopWaypoint(waypoint)) {
+		waypoints.push_back(waypoint);
+	}
+	for (auto i = waypoints.rbegin(); i != waypoints.rend(); ++i) {
+		outPath.PushWaypoint(*i);
+	}
+	return true;
+}
 
-	std::vector<GridNode*>  openList;
-	std::vector<GridNode*>  closedList;
+/*
+A* over the grid's nodes, or over just its jump points. Nodes come off the
+open heap cheapest first, and with a heuristic that never overestimates
+what's left - the steps there'd be with no walls in the way - the first
+time a node comes off the heap is by its shortest route, so it's closed
+then, and never looked at again.
+*/
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, GridSearchContext& context, SearchMode mode) const {
+	//need to work out which node 'from' sits in, and 'to' sits in
+	int fromX, fromZ, toX, toZ;
+	if (!GetNode(from, fromX, fromZ) || !GetNode(to, toX, toZ)) {
+		return false; //outside of map region!
+	}
 
-	openList.push_back(startNode);
+	int startNode	= (fromZ * gridWidth) + fromX;
+	int endNode		= (toZ * gridWidth) + toX;
 
-	startNode->f = 0;
-	startNode->g = 0;
-	startNode->parent = nullptr;
+	context.BeginSearch(gridWidth * gridHeight);
 
-	GridNode* currentBestNode = nullptr;
+	GridSearchContext::NodeState& start = context.nodes[startNode];
+	start.g			= 0.0f;
+	start.parent	= -1;
+	start.search	= context.search;
+	context.Push(startNode, Heuristic(startNode, endNode), 0.0f);
 
-	while (!openList.empty()) {
-		currentBestNode = RemoveBestNode(openList);
+	int dirStep = diagonalMovement ? 1 : 2;
 
-		if (currentBestNode == endNode) {			//we've found the path!
-			GridNode* node = endNode;
-			while (node != nullptr) {
-				outPath.PushWaypoint(node->position);
-				node = node->parent;
-			}
+	while (!context.open.empty()) {
+		int current = context.Pop();
+		context.nodesExpanded++;
+
+		if (current == endNode) {			//we've found the path!
+			BuildPath(context, endNode, outPath);
 			return true;
 		}
-		else {
-			for (int i = 0; i < 4; ++i) {
-				GridNode* neighbour = currentBestNode->connected[i];
-				if (!neighbour) { //might not be connected...
-					continue;
-				}	
-				bool inClosed	= NodeInList(neighbour, closedList);
-				if (inClosed) {
-					continue; //already discarded this neighbour...
+
+		int x = current % gridWidth;
+		int z = current / gridWidth;
+
+		if (mode == SearchMode::AStar) {
+			for (int dir = 0; dir < 8; dir += dirStep) {
+				if (CanStep(x, z, dirX[dir], dirZ[dir])) {
+					AddSuccessor(context, current, current + (dirZ[dir] * gridWidth) + dirX[dir], endNode);
 				}
+			}
+			continue;
+		}
+		int dirs[8];
+		int dirCount = GetJumpDirections(current, context.nodes[current].parent, dirs);
+		for (int i = 0; i < dirCount; ++i) {
+			int jumpPoint = mode == SearchMode::JumpPoint ?
+				Jump(x, z, dirX[dirs[i]], dirZ[dirs[i]], endNode) :
+				JumpPlus(x, z, dirs[i], endNode);
+
+			if (jumpPoint >= 0) {
+				AddSuccessor(context, current, jumpPoint, endNode);
+			}
+		}
+	}
+	return false; //open list emptied out with no path!
+}
+
+//Successors are always in a straight line or on a diagonal from the current node
+void NavigationGrid::AddSuccessor(GridSearchContext& context, int current, int successor, int endNode) const {
+	int dx = std::abs((successor % gridWidth) - (current % gridWidth));
+	int dz = std::abs((successor / gridWidth) - (current / gridWidth));
+	float g = context.nodes[current].g + std::max(dx, dz) + (DiagonalCost - 1.0f) * std::min(dx, dz);
+
+	GridSearchContext::NodeState& state = context.nodes[successor];
+	bool inOpen = state.search == context.search;
+	if (inOpen && (state.heapIndex == GridSearchContext::Closed || g >= state.g)) {
+		return; //already got here at least as cheaply...
+	}
+	state.g			= g;
+	state.parent	= current;
+	state.search	= context.search;
+
+	float f = g + Heuristic(successor, endNode);
+	if (inOpen) {//a better route to a node already on the open list
+		context.Update(successor, f, g);
+	}
+	else {
+		context.Push(successor, f, g);
+	}
+}
+
+//Walks back from the end, filling in any nodes that were jumped over
+void NavigationGrid::BuildPath(const GridSearchContext& context, int endNode, NavigationPath& outPath) const {
+	int node = endNode;
+	while (true) {
+		outPath.PushWaypoint(allNodes[node].position);
+
+		int parent = context.nodes[node].parent;
+		if (parent < 0) {
+			break;
+		}
+		int step = (Sign((parent / gridWidth) - (node / gridWidth)) * gridWidth) + Sign((parent % gridWidth) - (node % gridWidth));
+		for (int n = node + step; n != parent; n += step) {
+			outPath.PushWaypoint(allNodes[n].position);
+		}
+		node = parent;
+	}
+}
+
+//Steps left to the end node, if there were no walls - never more than it'll actually take. With no end node, it's a plain Dijkstra search
+float NavigationGrid::Heuristic(int node, int endNode) const {
+	if (endNode < 0) {
+		return 0.0f;
+	}
+	int dx = std::abs((node % gridWidth) - (endNode % gridWidth));
+	int dz = std::abs((node / gridWidth) - (endNode / gridWidth));
+	if (diagonalMovement) {
+		return std::max(dx, dz) + (DiagonalCost - 1.0f) * std::min(dx, dz);
+	}
+	return (float)(dx + dz);
+}
+
+//Diagonal steps can't cut the corner of a wall
+bool NavigationGrid::CanStep(int x, int z, int dx, int dz) const {
+	if (!Walkable(x + dx, z + dz)) {
+		return false;
+	}
+	return dx == 0 || dz == 0 || (Walkable(x + dx, z) && Walkable(x, z + dz));
+}
+
+/*
+Moving in a straight line, a node is a jump point if a wall beside the
+node behind it ends here - the shortest way round that wall might turn
+the corner here, and no other route would reach the far side as cheaply.
+*/
+bool NavigationGrid::HasForcedNeighbour(int x, int z, int dx, int dz) const {
+	if (dx != 0) {
+		return	(Walkable(x, z - 1) && !Walkable(x - dx, z - 1)) ||
+				(Walkable(x, z + 1) && !Walkable(x - dx, z + 1));
+	}
+	return	(Walkable(x - 1, z) && !Walkable(x - 1, z - dz)) ||
+			(Walkable(x + 1, z) && !Walkable(x + 1, z - dz));
+}
+
+/*
+Steps along from the given node until reaching the end, a jump point, or
+a wall (in which case there's nothing worth stopping for that way, and -1
+is returned). Diagonals stop wherever a straight line off them would reach
+something. Without diagonal movement, columns do the same job, stopping
+wherever a row off them would - so the search only ever goes along a row
+once there's a reason to.
+*/
+int NavigationGrid::Jump(int x, int z, int dx, int dz, int endNode) const {
+	while (CanStep(x, z, dx, dz)) {
+		x += dx;
+		z += dz;
+		int node = (z * gridWidth) + x;
+		if (node == endNode) {
+			return node;
+		}
+		if (dx != 0 && dz != 0) {
+			if (Jump(x, z, dx, 0, endNode) >= 0 || Jump(x, z, 0, dz, endNode) >= 0) {
+				return node;
+			}
+		}
+		else if (HasForcedNeighbour(x, z, dx, dz)) {
+			return node;
+		}
+		else if (!diagonalMovement && dz != 0 && (Jump(x, z, 1, 0, endNode) >= 0 || Jump(x, z, -1, 0, endNode) >= 0)) {
+			return node;
+		}
+	}
+	return -1;
+}
 
-				float h = Heuristic(neighbour, endNode);				
-				float g = currentBestNode->g + currentBestNode->costs[i];
-				float f = h + g;
+/*
+Jump, but reading how far it is to the next jump point (or wall) from the
+precomputed distances. They don't know where the end is, so if it's within
+reach, it's stopped at instead - or if it's off to the side, the search
+stops level with it, so the straight lines from there can find it.
+*/
+int NavigationGrid::JumpPlus(int x, int z, int dir, int endNode) const {
+	int node		= (z * gridWidth) + x;
+	int distance	= jumpDistances[(node * 8) + dir];
+	int reach		= std::abs(distance);
 
-				bool inOpen		= NodeInList(neighbour, openList);
+	int dx		= dirX[dir];
+	int dz		= dirZ[dir];
+	int toEndX	= ((endNode % gridWidth) - x) * dx;	//How far along this direction the end is
+	int toEndZ	= ((endNode / gridWidth) - z) * dz;
 
-				if (!inOpen) { //first time we've seen this neighbour
-					openList.emplace_back(neighbour);
+	if (dx != 0 && dz != 0) {
+		int steps = std::min(toEndX, toEndZ);
+		if (steps > 0 && steps <= reach) {
+			return node + (steps * ((dz * gridWidth) + dx));
+		}
+	}
+	else {
+		int along	= dx != 0 ? toEndX : toEndZ;
+		int across	= dx != 0 ? (endNode / gridWidth) - z : (endNode % gridWidth) - x;
+		if (along > 0 && along <= reach && (across == 0 || (!diagonalMovement && dz != 0))) {
+			return node + (along * ((dz * gridWidth) + dx));
+		}
+	}
+	return distance > 0 ? node + (distance * ((dz * gridWidth) + dx)) : -1;
+}
+
+/*
+Which ways the search carries on from a jump point, given the way it
+was reached. Straight on, plus the turns a wall might have made worth
+taking - anything else could have been reached at least as cheaply
+without going through this node. The start goes every way.
+*/
+int NavigationGrid::GetJumpDirections(int node, int parent, int* dirs) const {
+	int count = 0;
+	int step = diagonalMovement ? 1 : 2;
+	if (parent < 0) {
+		for (int i = 0; i < 8; i += step) {
+			dirs[count++] = i;
+		}
+		return count;
+	}
+	int dx	= Sign((node % gridWidth) - (parent % gridWidth));
+	int dz	= Sign((node / gridWidth) - (parent / gridWidth));
+	int dir = DirectionOf(dx, dz);
+
+	int spread = diagonalMovement ? (dx != 0 && dz != 0 ? 1 : 2) : 2;
+	for (int i = -spread; i <= spread; i += step) {
+		dirs[count++] = (dir + i + 8) % 8;
+	}
+	return count;
+}
+
+/*
+For every node and direction, how many steps it is to the next jump point
+(positive), or if a wall comes first, how many steps there are before it
+(zero or negative). Each is worked out from the node one step along, so
+each direction is filled in starting from the far side of the grid. The
+straight directions come first, as the others stop wherever they'd find
+something.
+*/
+void NavigationGrid::UpdateJumpDistances() {
+	jumpDistances.assign(gridWidth * gridHeight * 8, 0);
+
+	auto FillDirection = [&](int dir) {
+		int dx = dirX[dir];
+		int dz = dirZ[dir];
+		for (int zi = 0; zi < gridHeight; ++zi) {
+			int z = dz > 0 ? gridHeight - 1 - zi : zi;
+			for (int xi = 0; xi < gridWidth; ++xi) {
+				int x = dx > 0 ? gridWidth - 1 - xi : xi;
+
+				short& distance = jumpDistances[(((z * gridWidth) + x) * 8) + dir];
+				if (!CanStep(x, z, dx, dz)) {
+					distance = 0;
+					continue;
 				}
-				if (!inOpen || f < neighbour->f) {//might be a better route to this neighbour
-					neighbour->parent = currentBestNode;
-					neighbour->f = f;
-					neighbour->g = g;
+				int next = ((z + dz) * gridWidth) + x + dx;
+
+				bool stop;
+				if (dx != 0 && dz != 0) {
+					stop = jumpDistances[(next * 8) + DirectionOf(dx, 0)] > 0 || jumpDistances[(next * 8) + DirectionOf(0, dz)] > 0;
+				}
+				else {
+					stop = HasForcedNeighbour(x + dx, z + dz, dx, dz);
+					if (!diagonalMovement && dz != 0) {
+						stop = stop || jumpDistances[(next * 8) + 2] > 0 || jumpDistances[(next * 8) + 6] > 0;
+					}
+				}
+				if (stop) {
+					distance = 1;
+				}
+				else {
+					short nextDistance = jumpDistances[(next * 8) + dir];
+					distance = nextDistance > 0 ? nextDistance + 1 : nextDistance - 1;
 				}
 			}
-			closedList.emplace_back(currentBestNode);
+		}
+	};
+
+	FillDirection(2);
+	FillDirection(6);
+	FillDirection(0);
+	FillDirection(4);
+	if (diagonalMovement) {
+		for (int dir = 1; dir < 8; dir += 2) {
+			FillDirection(dir);
 		}
 	}
-	return false; //open list emptied out with no path!
+	jumpDistancesValid = true;
 }
 
-bool NavigationGrid::NodeInList(GridNode* n, std::vector<GridNode*>& list) const {
-	std::vector<GridNode*>::iterator i = std::find(list.begin(), list.end(), n);
-	return i == list.end() ? false : true;
+GridSearchContext::GridSearchContext() {
+	search			= 0;
+	nodesExpanded	= 0;
 }
 
-GridNode*  NavigationGrid::RemoveBestNode(std::vector<GridNode*>& list) const {
-	std::vector<GridNode*>::iterator bestI = list.begin();
+void GridSearchContext::BeginSearch(int nodeCount) {
+	if ((int)nodes.size() < nodeCount) {
+		nodes.resize(nodeCount, NodeState{ 0.0f, -1, Closed, 0 });
+	}
+	//Once the stamps wrap round, old ones could look current again, so wipe them all
+	if (++search == 0) {
+		for (NodeState& n : nodes) {
+			n.search = 0;
+		}
+		search = 1;
+	}
+	open.clear();
+	nodesExpanded = 0;
+}
 
-	GridNode* bestNode = *list.begin();
+//Cheapest first, and of nodes that cost the same, the one furthest along - it's probably nearer the end
+bool GridSearchContext::Before(const OpenNode& a, const OpenNode& b) const {
+	if (a.f != b.f) {
+		return a.f < b.f;
+	}
+	return a.g > b.g;
+}
 
-	for (auto i = list.begin(); i != list.end(); ++i) {
-		if ((*i)->f < bestNode->f) {
-			bestNode	= (*i);
-			bestI		= i;
-		}
+void GridSearchContext::Push(int node, float f, float g) {
+	open.push_back({ f, g, node });
+	nodes[node].heapIndex = (int)open.size() - 1;
+	SiftUp((int)open.size() - 1);
+}
+
+//Only ever makes a node cheaper, so it can only need to move up
+void GridSearchContext::Update(int node, float f, float g) {
+	int index = nodes[node].heapIndex;
+	open[index].f = f;
+	open[index].g = g;
+	SiftUp(index);
+}
+
+int GridSearchContext::Pop() {
+	int node = open[0].node;
+	nodes[node].heapIndex = Closed;
+
+	open[0] = open.back();
+	open.pop_back();
+	if (!open.empty()) {
+		nodes[open[0].node].heapIndex = 0;
+		SiftDown(0);
 	}
-	list.erase(bestI);
+	return node;
+}
 
-	return bestNode;
+void GridSearchContext::SiftUp(int index) {
+	OpenNode entry = open[index];
+	while (index > 0) {
+		int parent = (index - 1) / 2;
+		if (!Before(entry, open[parent])) {
+			break;
+		}
+		open[index] = open[parent];
+		nodes[open[index].node].heapIndex = index;
+		index = parent;
+	}
+	open[index] = entry;
+	nodes[entry.node].heapIndex = index;
 }
 
-float NavigationGrid::Heuristic(GridNode* hNode, GridNode* endNode) const {
-	return Vector::Length(hNode->position - endNode->position);
-}
\ No newline at end of file
+void GridSearchContext::SiftDown(int index) {
+	OpenNode entry	= open[index];
+	int count		= (int)open.size();
+	while (true) {
+		int child = index * 2 + 1;
+		if (child >= count) {
+			break;
+		}
+		if (child + 1 < count && Before(open[child + 1], open[child])) {
+			child++;
+		}
+		if (!Before(open[child], entry)) {
+			break;
+		}
+		open[index] = open[child];
+		nodes[open[index].node].heapIndex = index;
+		index = child;
+	}
+	open[index] = entry;
+	nodes[entry.node].heapIndex = index;
+}
@@ -1,19 +1,18 @@
 #pragma once
 #include "NavigationMap.h"
 #include <string>
+#include <vector>
 namespace NCL {
 	namespace CSC8503 {
-		struct GridNode {
-			GridNode* parent;
+		class GridClusterGraph;
+		class HierarchicalPath;
 
+		struct GridNode {
 			GridNode* connected[4];
 			int		  costs[4];
 
 			Vector3		position;
 
-			float f;
-			float g;
-
 			int type;
 
 			GridNode() {
@@ -21,32 +20,220 @@ namespace NCL {
 					connected[i] = nullptr;
 					costs[i] = 0;
 				}
-				f = 0;
-				g = 0;
 				type = 0;
-				parent = nullptr;
 			}
 			~GridNode() {	}
 		};
 
+		/*
+		Everything a search of a NavigationGrid writes as it goes - each node's
+		cost so far and where it was reached from, and the open list, kept as
+		a binary heap that knows where each node sits in it, so a node found
+		by a cheaper route can be moved up rather than added again.
+
+		Nothing is cleared between searches. Each node's state is stamped
+		with the search that wrote it, and anything with an older stamp is
+		treated as untouched, so starting a search costs nothing however big
+		the grid is. Keeping a context around, one per thread, means searches
+		don't allocate anything once it has grown to fit the grid.
+		*/
+		class GridSearchContext {
+		public:
+			GridSearchContext();
+			~GridSearchContext() = default;
+
+			//How many nodes the last search took off the open list
+			int GetNodesExpanded() const {
+				return nodesExpanded;
+			}
+
+		protected:
+			friend class NavigationGrid;
+			friend class GridClusterGraph;
+
+			static const int Closed = -1;
+
+			struct NodeState {
+				float			g;
+				int				parent;
+				int				heapIndex;	//Where the node is in the open heap, or Closed
+				unsigned int	search;		//Which search the rest of this belongs to
+			};
+
+			struct OpenNode {
+				float	f;
+				float	g;
+				int		node;
+			};
+
+			void	BeginSearch(int nodeCount);
+
+			void	Push(int node, float f, float g);
+			void	Update(int node, float f, float g);
+			int		Pop();
+
+			bool	Before(const OpenNode& a, const OpenNode& b) const;
+			void	SiftUp(int index);
+			void	SiftDown(int index);
+
+			std::vector<NodeState>	nodes;
+			std::vector<OpenNode>	open;
+			unsigned int			search;
+			int						nodesExpanded;
+		};
+
+		/*
+		A grid of square nodes, each either floor or wall, where every step
+		between floor nodes costs the same.
+
+		Paths can be found with plain A*, or with Jump Point Search, which
+		makes use of every step costing the same: of all the equally short
+		ways across an open area, it only ever follows one, skipping straight
+		along rows and columns until something about the walls means a turn
+		might be needed there (a 'jump point'). Only the jump points go on the
+		open list, so on open ground or down long corridors it expands far
+		fewer nodes than A* does. JPS+ goes further, working out once how far
+		each node is from the next jump point or wall in every direction, so
+		a search doesn't even have to scan along the rows.
+
+		All of them find equally short paths, and give back every node along
+		the way, not just the jump points.
+
+		For long paths across big grids, a GridClusterGraph can be built over
+		the grid, for hierarchical searches - see GridClusterGraph.h. Those
+		paths can be a little longer than the shortest.
+
+		Movement is between the 4 nodes either side, or with diagonal movement
+		on, the 8 round it - but a diagonal step is never allowed to cut the
+		corner of a wall, so both the nodes either side of it must be floor.
+		*/
 		class NavigationGrid : public NavigationMap	{
 		public:
+			enum class SearchMode {
+				AStar,
+				JumpPoint,
+				JumpPointPlus,
+				Hierarchical
+			};
+
 			NavigationGrid();
 			NavigationGrid(const std::string&filename);
+			//Types are given row by row, width * height of them - 'x' for a wall, '.' for floor
+			NavigationGrid(int width, int height, int nodeSize, const std::vector<char>& types);
 			~NavigationGrid();
 
+			//Searches using the grid's own context, so only one of these can run at a time
 			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
-				
+
+			//Only reads the grid, so any number of these can run at once, each with its own context.
+			//JPS+ or hierarchical searches made while what they rely on is out of date fall back to plain JPS
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, GridSearchContext& context) const;
+
+			//Searches the cluster graph, leaving the path to be filled in as it's walked, whatever the search mode.
+			//With no cluster graph, one that's out of date, or a start inside a wall, it's a plain JPS search, filled in all at once
+			bool FindPath(const Vector3& from, const Vector3& to, HierarchicalPath& outPath, GridSearchContext& context) const;
+
+			void SetSearchMode(SearchMode mode);
+
+			SearchMode GetSearchMode() const {
+				return searchMode;
+			}
+
+			void SetDiagonalMovement(bool state);
+
+			bool GetDiagonalMovement() const {
+				return diagonalMovement;
+			}
+
+			int GetWidth() const {
+				return gridWidth;
+			}
+
+			int GetHeight() const {
+				return gridHeight;
+			}
+
+			int GetNodeSize() const {
+				return nodeSize;
+			}
+
+			bool IsWalkable(int x, int z) const;
+
+			//Which node a position falls in - false if it's off the grid
+			bool GetNode(const Vector3& position, int& x, int& z) const;
+
+			/*
+			Changes a node to floor or wall. The JPS+ jump distances aren't
+			worked out again until the next non-const FindPath, or a call to
+			UpdateJumpDistances, so a whole batch of changes only costs one.
+			*/
+			void SetNodeType(int x, int z, char type);
+
+			void UpdateJumpDistances();
+
+			bool JumpDistancesValid() const {
+				return jumpDistancesValid;
+			}
+
+			//Replaces any cluster graph there already was - paths still being walked over the old one mustn't be used again
+			void BuildClusterGraph(int clusterSize = 16);
+
+			//Rebuilds the clusters changed since the last time - like the jump distances, this happens on its own in a non-const FindPath
+			void UpdateClusterGraph();
+
+			bool ClusterGraphValid() const;
+
+			const GridClusterGraph* GetClusterGraph() const {
+				return clusterGraph;
+			}
+
+			//Goes up whenever a node's type or the diagonal movement changes, so anything worked out from the grid can tell it's out of date
+			unsigned int GetChangeCount() const {
+				return changeCount;
+			}
+
 		protected:
-			bool		NodeInList(GridNode* n, std::vector<GridNode*>& list) const;
-			GridNode*	RemoveBestNode(std::vector<GridNode*>& list) const;
-			float		Heuristic(GridNode* hNode, GridNode* endNode) const;
+			friend class GridClusterGraph;
+			friend class HierarchicalPath;
+			friend class FlowField;
+
+			bool		FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, GridSearchContext& context, SearchMode mode) const;
+
+			void		BuildConnections();
+			void		ConnectNode(int x, int z);
+
+			float		Heuristic(int node, int endNode) const;
+
+			bool Walkable(int x, int z) const {
+				return x >= 0 && x < gridWidth && z >= 0 && z < gridHeight && walkable[(z * gridWidth) + x];
+			}
+
+			bool		HasForcedNeighbour(int x, int z, int dx, int dz) const;
+			bool		CanStep(int x, int z, int dx, int dz) const;
+			int			Jump(int x, int z, int dx, int dz, int endNode) const;
+			int			JumpPlus(int x, int z, int dir, int endNode) const;
+			int			GetJumpDirections(int node, int parent, int* dirs) const;
+
+			void		AddSuccessor(GridSearchContext& context, int current, int successor, int endNode) const;
+			void		BuildPath(const GridSearchContext& context, int endNode, NavigationPath& outPath) const;
+
 			int nodeSize;
 			int gridWidth;
 			int gridHeight;
 
 			GridNode* allNodes;
+
+			std::vector<char>	walkable;	//Flat copy of which nodes are floor, for scanning along quickly
+			std::vector<short>	jumpDistances;	//8 per node, one per direction - see UpdateJumpDistances
+			bool				jumpDistancesValid;
+
+			GridClusterGraph*	clusterGraph;
+			unsigned int		changeCount;
+
+			SearchMode	searchMode;
+			bool		diagonalMovement;
+
+			GridSearchContext searchContext;
 		};
 	}
 }
-
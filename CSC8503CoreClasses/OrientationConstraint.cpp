@@ -5,12 +5,22 @@ using namespace NCL;
 using namespace Maths;
 using namespace CSC8503;
 
-OrientationConstraint::OrientationConstraint(GameObject* a, GameObject* b)
+OrientationConstraint::OrientationConstraint(GameObject* a, GameObject* b) : Constraint(ConstraintType::Orientation)
 {
 	objectA = a;
 	objectB = b;
+	isHinge = false;
+
+	Quaternion orientationA = a->GetTransform().GetOrientation();
+	relativeOrientation = orientationA.Conjugate() * b->GetTransform().GetOrientation();
 }
 
-void OrientationConstraint::UpdateConstraint(float dt) {
+OrientationConstraint::OrientationConstraint(GameObject* a, GameObject* b, const Vector3& hingeAxis) : OrientationConstraint(a, b)
+{
+	isHinge		= true;
+	hingeAxisA	= Vector::Normalise(hingeAxis);
+	//The same axis, as it's pointing now, in B's space
+	Vector3 worldAxis = a->GetTransform().GetOrientation() * hingeAxisA;
+	hingeAxisB	= b->GetTransform().GetOrientation().Conjugate() * worldAxis;
+}
 
-}
\ No newline at end of file
@@ -2,22 +2,45 @@
 #include "Constraint.h"
 
 namespace NCL {
+	using namespace NCL::Maths;
 	namespace CSC8503 {
 		class GameObject;
 
+		/*
+		Stops two objects turning relative to each other - they keep whatever
+		orientations they had when the constraint was made. Given a hinge axis
+		(in A's local space), they can still turn about that axis, but no other.
+		Solved in bulk by the ConstraintSolver.
+		*/
 		class OrientationConstraint : public Constraint
 		{
+			friend class ConstraintSolver;
 		public:
 			OrientationConstraint(GameObject* a, GameObject* b);
+			OrientationConstraint(GameObject* a, GameObject* b, const Vector3& hingeAxis);
 			~OrientationConstraint() = default;
 
-			void UpdateConstraint(float dt) override;
+			GameObject* GetObjectA() const override {
+				return objectA;
+			}
+
+			GameObject* GetObjectB() const override {
+				return objectB;
+			}
+
+			bool IsHinge() const {
+				return isHinge;
+			}
 
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
 
-			float distance;
+			Quaternion	relativeOrientation;	//B's orientation in A's space
+			Vector3		hingeAxisA;				//The hinge axis in each object's space
+			Vector3		hingeAxisB;
+			bool		isHinge;
+			Vector3		impulse;	//Built up by the solver, and carried across steps to warm start it
 		};
 	}
 }
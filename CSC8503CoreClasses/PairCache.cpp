@@ -0,0 +1,120 @@
+#include "PairCache.h"
+#include "GameObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+PairCache::PairCache(int initialCapacity) {
+	int size = 16;
+	while (size < initialCapacity * 2) {
+		size *= 2;
+	}
+	slots.resize(size, -1);
+	mask = size - 1;
+}
+
+void PairCache::Clear() {
+	std::fill(slots.begin(), slots.end(), -1);
+	entries.clear();
+}
+
+uint64_t PairCache::MakeKey(const GameObject* a, const GameObject* b) {
+	uint32_t idA = (uint32_t)a->GetWorldID();
+	uint32_t idB = (uint32_t)b->GetWorldID();
+	if (idA > idB) {
+		std::swap(idA, idB);
+	}
+	return ((uint64_t)idA << 32) | idB;
+}
+
+//Returns the slot holding this key, or the empty slot it would go in
+int PairCache::FindSlot(uint64_t key) const {
+	int slot = SlotFor(key);
+	while (slots[slot] != -1 && entries[slots[slot]].key != key) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+PairCache::Entry& PairCache::Add(GameObject* a, GameObject* b) {
+	uint64_t key = MakeKey(a, b);
+	int slot = FindSlot(key);
+	if (slots[slot] != -1) {
+		return entries[slots[slot]];
+	}
+	if ((int)(entries.size() + 1) * 2 > (int)slots.size()) { //Keep the load factor under half
+		Grow();
+		slot = FindSlot(key);
+	}
+	slots[slot] = (int)entries.size();
+
+	Entry& e	= entries.emplace_back();
+	e.key		= key;
+	e.isNew		= true;
+	e.info.a	= a;
+	e.info.b	= b;
+	e.info.framesLeft = 0;
+	return e;
+}
+
+PairCache::Entry* PairCache::Find(const GameObject* a, const GameObject* b) {
+	int slot = FindSlot(MakeKey(a, b));
+	return slots[slot] == -1 ? nullptr : &entries[slots[slot]];
+}
+
+bool PairCache::Remove(const GameObject* a, const GameObject* b) {
+	int slot = FindSlot(MakeKey(a, b));
+	if (slots[slot] == -1) {
+		return false;
+	}
+	RemoveAt(slots[slot]);
+	return true;
+}
+
+int PairCache::RemoveAll(const GameObject* o) {
+	int removed = 0;
+	for (int i = 0; i < (int)entries.size();) {
+		if (entries[i].info.a == o || entries[i].info.b == o) {
+			RemoveAt(i); //Last entry moves into i, so don't step on
+			removed++;
+		}
+		else {
+			++i;
+		}
+	}
+	return removed;
+}
+
+void PairCache::RemoveAt(int index) {
+	int slot = FindSlot(entries[index].key);
+	slots[slot] = -1;
+
+	//Backward shift deletion - pull later entries of this probe run into the
+	//gap, so lookups never stop early at it, and no tombstones are needed
+	int next = (slot + 1) & mask;
+	while (slots[next] != -1) {
+		int ideal = SlotFor(entries[slots[next]].key);
+		//Move it if its ideal slot isn't cyclically within (slot, next]
+		if (((next - ideal) & mask) >= ((next - slot) & mask)) {
+			slots[slot] = slots[next];
+			slots[next] = -1;
+			slot = next;
+		}
+		next = (next + 1) & mask;
+	}
+
+	int last = (int)entries.size() - 1;
+	if (index != last) {
+		slots[FindSlot(entries[last].key)] = index;
+		entries[index] = entries[last];
+	}
+	entries.pop_back();
+}
+
+void PairCache::Grow() {
+	slots.assign(slots.size() * 2, -1);
+	mask = (int)slots.size() - 1;
+	for (int i = 0; i < (int)entries.size(); ++i) {
+		slots[FindSlot(entries[i].key)] = i;
+	}
+}
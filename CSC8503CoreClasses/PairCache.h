@@ -0,0 +1,71 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A flat hash table of object pairs, keyed on the world IDs of the two
+		objects (lowest first), so the order a pair is added in doesn't matter.
+
+		Entries are stored contiguously, so they can be iterated over like an
+		array, and removal swaps the last entry into the gap. The table itself
+		uses open addressing with linear probing, and only holds indices into
+		the entry array, so no allocations happen once it has grown to size.
+		*/
+		class PairCache {
+		public:
+			struct Entry {
+				CollisionDetection::CollisionInfo	info;
+				uint64_t							key;
+				bool								isNew;	//Set when first added, cleared by the owner
+			};
+
+			PairCache(int initialCapacity = 64);
+			~PairCache() = default;
+
+			void Clear();
+
+			//Returns the entry for this pair, creating it if it wasn't already there
+			Entry&	Add(GameObject* a, GameObject* b);
+			Entry*	Find(const GameObject* a, const GameObject* b);
+
+			bool	Remove(const GameObject* a, const GameObject* b);
+			//Removes every pair the object is in, and returns how many there were
+			int		RemoveAll(const GameObject* o);
+			//Note that this moves the last entry into this index!
+			void	RemoveAt(int index);
+
+			int Size() const {
+				return (int)entries.size();
+			}
+
+			Entry& operator[](int index) {
+				return entries[index];
+			}
+
+			const Entry& operator[](int index) const {
+				return entries[index];
+			}
+
+			//Entries only move when one is removed, so this stays valid until then
+			int IndexOf(const Entry& e) const {
+				return (int)(&e - entries.data());
+			}
+
+			static uint64_t MakeKey(const GameObject* a, const GameObject* b);
+
+		protected:
+			int		FindSlot(uint64_t key) const;
+			void	Grow();
+
+			int SlotFor(uint64_t key) const {
+				//Fibonacci hashing spreads sequential world IDs across the table
+				return (int)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+			}
+
+			std::vector<Entry>	entries;
+			std::vector<int>	slots;	//Index into entries, or -1 if empty
+			int					mask;
+		};
+	}
+}
@@ -0,0 +1,194 @@
+#include "PathfindingService.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+PathfindingService::PathfindingService(const NavigationGrid& g, int workerCount) : grid(g) {
+	running		= true;
+	nextRequest	= 0;
+	searching	= 0;
+	searchCount = 0;
+	mergedCount = 0;
+
+	for (int i = 0; i < workerCount; ++i) {
+		workers.emplace_back(&PathfindingService::WorkerLoop, this);
+	}
+}
+
+PathfindingService::~PathfindingService() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		running = false;
+	}
+	workAvailable.notify_all();
+
+	for (std::thread& t : workers) {
+		t.join();
+	}
+	for (Search* s : requested) {
+		delete s;
+	}
+	for (Search* s : queued) {
+		delete s;
+	}
+	for (Search* s : finished) {
+		delete s;
+	}
+}
+
+PathfindingService::RequestID PathfindingService::RequestPath(const Vector3& from, const Vector3& to, const PathCallback& callback) {
+	int fromX, fromZ, toX, toZ;
+	bool onGrid = grid.GetNode(from, fromX, fromZ) && grid.GetNode(to, toX, toZ);
+
+	std::lock_guard<std::mutex> guard(lock);
+	RequestID id = nextRequest++;
+	states[id] = RequestState::Pending;
+
+	long long key = -1;
+	if (onGrid) {
+		long long fromNode	= (long long)fromZ * grid.GetWidth() + fromX;
+		long long toNode	= (long long)toZ * grid.GetWidth() + toX;
+		key = fromNode * grid.GetWidth() * grid.GetHeight() + toNode;
+
+		auto i = active.find(key);
+		if (i != active.end()) {
+			i->second->requests.push_back({ id, callback });
+			mergedCount++;
+			return id;
+		}
+	}
+	//Searches that start or end off the grid just fail, but still go through the usual route to do so
+	Search* search	= new Search();
+	search->from	= from;
+	search->to		= to;
+	search->key		= key;
+	search->requests.push_back({ id, callback });
+	if (onGrid) {
+		active[key] = search;
+	}
+	requested.push_back(search);
+	return id;
+}
+
+void PathfindingService::Cancel(RequestID id) {
+	std::lock_guard<std::mutex> guard(lock);
+	states.erase(id);
+	results.erase(id);
+}
+
+void PathfindingService::Update() {
+	std::vector<Search*> done;
+	std::vector<Search*> starting;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		done.swap(finished);
+		starting.swap(requested);
+
+		//Results for polling are stored now, while the lock is held - callbacks wait until it's released
+		for (Search* s : done) {
+			for (const Request& r : s->requests) {
+				auto state = states.find(r.id);
+				if (state == states.end() || r.callback) {
+					continue;
+				}
+				state->second = s->found ? RequestState::Found : RequestState::Failed;
+				results[r.id] = { state->second, s->path };
+			}
+		}
+	}
+
+	for (Search* s : done) {
+		for (const Request& r : s->requests) {
+			if (!r.callback) {
+				continue;
+			}
+			bool cancelled;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				cancelled = states.erase(r.id) == 0;
+			}
+			if (!cancelled) {
+				r.callback(r.id, s->found, s->path);
+			}
+		}
+		delete s;
+	}
+
+	if (starting.empty()) {
+		return;
+	}
+	if (workers.empty()) {
+		for (Search* s : starting) {
+			s->found = grid.FindPath(s->from, s->to, s->path, updateContext);
+		}
+		std::lock_guard<std::mutex> guard(lock);
+		for (Search* s : starting) {
+			FinishSearch(s);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		queued.insert(queued.end(), starting.begin(), starting.end());
+	}
+	workAvailable.notify_all();
+}
+
+PathfindingService::RequestState PathfindingService::GetState(RequestID id) const {
+	std::lock_guard<std::mutex> guard(lock);
+	auto i = states.find(id);
+	return i == states.end() ? RequestState::Unknown : i->second;
+}
+
+bool PathfindingService::GetPath(RequestID id, NavigationPath& outPath, bool& found) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto i = results.find(id);
+	if (i == results.end()) {
+		return false;
+	}
+	found	= i->second.state == RequestState::Found;
+	outPath = std::move(i->second.path);
+	results.erase(i);
+	states.erase(id);
+	return true;
+}
+
+void PathfindingService::WaitForSearches() {
+	std::unique_lock<std::mutex> guard(lock);
+	searchesDone.wait(guard, [&]() { return queued.empty() && searching == 0; });
+}
+
+//Takes the search out of the active set, so later requests between the same nodes start a fresh one
+void PathfindingService::FinishSearch(Search* search) {
+	if (search->key >= 0) {
+		active.erase(search->key);
+	}
+	finished.push_back(search);
+	searchCount++;
+}
+
+void PathfindingService::WorkerLoop() {
+	GridSearchContext context;
+
+	while (true) {
+		Search* search = nullptr;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			workAvailable.wait(guard, [&]() { return !running || !queued.empty(); });
+			if (!running) {
+				break;
+			}
+			//Oldest first, so no request waits behind ones made after it
+			search = queued.front();
+			queued.pop_front();
+			searching++;
+		}
+		search->found = grid.FindPath(search->from, search->to, search->path, context);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			FinishSearch(search);
+			searching--;
+		}
+		searchesDone.notify_all();
+	}
+}
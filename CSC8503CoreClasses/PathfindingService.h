@@ -0,0 +1,128 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Runs NavigationGrid searches in the background, so agents can ask for
+		paths without the frame waiting on them.
+
+		Requests can be made from any thread, and are only queued until the
+		next Update, which hands them to the service's worker threads. Any
+		requests between the same start and end nodes are merged into one
+		search (as long as it hasn't finished yet), so a crowd all chasing the
+		player from the same corridor only costs one. Each worker keeps its own
+		search context, so once they've grown to fit the grid, searches don't
+		allocate anything.
+
+		Finished paths are handed back by the first Update after they're done,
+		on whichever thread calls it - either to the request's callback, or,
+		if it didn't have one, kept until GetPath collects them.
+
+		The workers are the service's own, rather than jobs on a JobSystem, so
+		a long search can never be picked up by a thread that's only waiting
+		for its own jobs to finish, and hold up the rest of the frame. With no
+		workers, searches are run during Update instead.
+
+		The grid mustn't change while there are searches still to finish -
+		WaitForSearches will wait for them.
+		*/
+		class PathfindingService {
+		public:
+			typedef int RequestID;
+			typedef std::function<void(RequestID id, bool found, const NavigationPath& path)> PathCallback;
+
+			enum class RequestState {
+				Unknown,	//Never made, already collected, or cancelled
+				Pending,
+				Found,
+				Failed
+			};
+
+			PathfindingService(const NavigationGrid& grid, int workerCount = 1);
+			~PathfindingService();
+
+			RequestID	RequestPath(const Vector3& from, const Vector3& to, const PathCallback& callback = nullptr);
+
+			//The request's result is thrown away when it arrives, and its callback never called
+			void		Cancel(RequestID id);
+
+			//Hands out finished paths, then starts searching for anything requested since the last Update
+			void		Update();
+
+			RequestState GetState(RequestID id) const;
+
+			//Once a request without a callback has finished, copies out its path and forgets it. Found or not, returns true once it's done
+			bool		GetPath(RequestID id, NavigationPath& outPath, bool& found);
+
+			//Blocks until every search started so far has finished - its results are still handed out by the next Update
+			void		WaitForSearches();
+
+			int GetWorkerCount() const {
+				return (int)workers.size();
+			}
+
+			//Searches actually run, and requests that shared another's search instead
+			int GetSearchCount() const {
+				return searchCount;
+			}
+
+			int GetMergedCount() const {
+				return mergedCount;
+			}
+
+		protected:
+			struct Request {
+				RequestID		id;
+				PathCallback	callback;
+			};
+
+			struct Search {
+				Vector3					from;
+				Vector3					to;
+				long long				key = -1;	//Of the start and end node, or -1 if either is off the grid
+				std::vector<Request>	requests;
+				bool					found = false;
+				NavigationPath			path;
+			};
+
+			struct Result {
+				RequestState	state;
+				NavigationPath	path;
+			};
+
+			void WorkerLoop();
+			void FinishSearch(Search* search);	//Needs the lock held
+
+			const NavigationGrid&	grid;
+
+			GridSearchContext		updateContext;	//For searching on the Update thread, with no workers
+
+			std::vector<std::thread>	workers;
+			bool						running;
+
+			mutable std::mutex			lock;
+			std::condition_variable		workAvailable;
+			std::condition_variable		searchesDone;
+
+			RequestID					nextRequest;
+			std::unordered_map<long long, Search*> active;	//Not finished yet, by start and end node
+			std::vector<Search*>		requested;	//Since the last Update
+			std::deque<Search*>			queued;		//Waiting for a worker
+			std::vector<Search*>		finished;	//Waiting for the next Update
+			int							searching;	//Taken by a worker, but not finished yet
+
+			std::unordered_map<RequestID, RequestState>	states;
+			std::unordered_map<RequestID, Result>		results;	//Finished, with no callback, but not collected yet
+
+			int searchCount;
+			int mergedCount;
+		};
+	}
+}
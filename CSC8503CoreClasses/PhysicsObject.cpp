@@ -1,6 +1,7 @@
 #include "PhysicsObject.h"
 #include "PhysicsSystem.h"
 #include "Transform.h"
+#include "RigidBodyStore.h"
 using namespace NCL;
 using namespace CSC8503;
 
@@ -12,20 +13,100 @@ PhysicsObject::PhysicsObject(Transform& parentTransform, const CollisionVolume*
 	inverseMass = 1.0f;
 	elasticity	= 0.8f;
 	friction	= 0.8f;
+	continuousCollision = false;
+
+	store		= nullptr;
+	storeIndex	= -1;
+}
+
+PhysicsObject::~PhysicsObject()
+{
+	if (store) {
+		store->Remove(storeIndex);
+	}
+}
+
+Vector3 PhysicsObject::GetLinearVelocity() const 
+{
+	return store ? store->GetVector(RigidBodyStore::LinearVelX, storeIndex) : linearVelocity;
+}
+
+Vector3 PhysicsObject::GetAngularVelocity() const 
+{
+	return store ? store->GetVector(RigidBodyStore::AngularVelX, storeIndex) : angularVelocity;
+}
+
+Vector3 PhysicsObject::GetTorque() const 
+{
+	return store ? store->GetVector(RigidBodyStore::TorqueX, storeIndex) : torque;
+}
+
+Vector3 PhysicsObject::GetForce() const 
+{
+	return store ? store->GetVector(RigidBodyStore::ForceX, storeIndex) : force;
+}
+
+void PhysicsObject::SetInverseMass(float invMass) 
+{
+	inverseMass = invMass;
+	if (store) {
+		store->Get(RigidBodyStore::InverseMass, storeIndex) = invMass;
+		WakeIfDynamic();
+	}
+}
+
+float PhysicsObject::GetInverseMass() const 
+{
+	return store ? store->Get(RigidBodyStore::InverseMass, storeIndex) : inverseMass;
 }
 
+void PhysicsObject::SetLinearVelocity(const Vector3& v) 
+{
+	linearVelocity = v;
+	if (store) {
+		store->SetAwake(storeIndex, true);
+		store->SetVector(RigidBodyStore::LinearVelX, storeIndex, v);
+	}
+}
+
+void PhysicsObject::SetAngularVelocity(const Vector3& v) 
+{
+	angularVelocity = v;
+	if (store) {
+		store->SetAwake(storeIndex, true);
+		store->SetVector(RigidBodyStore::AngularVelX, storeIndex, v);
+	}
+}
+
+Matrix3 PhysicsObject::GetInertiaTensor() const 
+{
+	return store ? store->GetInertiaTensor(storeIndex) : inverseInteriaTensor;
+}
+
+//Impulses can't move an infinitely heavy object, so shouldn't wake it either
 void PhysicsObject::ApplyAngularImpulse(const Vector3& force) 
 {
-	angularVelocity += inverseInteriaTensor * force;
+	if (GetInverseMass() == 0.0f) {
+		return;
+	}
+	SetAngularVelocity(GetAngularVelocity() + GetInertiaTensor() * force);
 }
 
 void PhysicsObject::ApplyLinearImpulse(const Vector3& force) 
 {
-	linearVelocity += force * inverseMass;
+	if (GetInverseMass() == 0.0f) {
+		return;
+	}
+	SetLinearVelocity(GetLinearVelocity() + force * GetInverseMass());
 }
 
 void PhysicsObject::AddForce(const Vector3& addedForce) 
 {
+	if (store) {
+		WakeIfDynamic();
+		store->SetVector(RigidBodyStore::ForceX, storeIndex, GetForce() + addedForce);
+		return;
+	}
 	force += addedForce;
 }
 
@@ -33,17 +114,46 @@ void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3&
 {
 	Vector3 localPos = position - transform.GetPosition();
 
-	force  += addedForce;
-	torque += Vector::Cross(localPos, addedForce);
+	AddForce(addedForce);
+	AddTorque(Vector::Cross(localPos, addedForce));
 }
 
 void PhysicsObject::AddTorque(const Vector3& addedTorque) 
 {
+	if (store) {
+		WakeIfDynamic();
+		store->SetVector(RigidBodyStore::TorqueX, storeIndex, GetTorque() + addedTorque);
+		return;
+	}
 	torque += addedTorque;
 }
 
+bool PhysicsObject::IsAwake() const 
+{
+	return store ? store->IsAwake(storeIndex) : true;
+}
+
+void PhysicsObject::SetAwake(bool awake) 
+{
+	if (store) {
+		store->SetAwake(storeIndex, awake);
+	}
+}
+
+void PhysicsObject::WakeIfDynamic() 
+{
+	if (store && GetInverseMass() > 0.0f) {
+		store->SetAwake(storeIndex, true);
+	}
+}
+
 void PhysicsObject::ClearForces() 
 {
+	if (store) {
+		store->SetVector(RigidBodyStore::ForceX, storeIndex, Vector3());
+		store->SetVector(RigidBodyStore::TorqueX, storeIndex, Vector3());
+		return;
+	}
 	force	= Vector3();
 	torque	= Vector3();
 }
@@ -56,21 +166,35 @@ void PhysicsObject::InitCubeInertia()
 
 	Vector3 dimsSqr		= fullWidth * fullWidth;
 
-	inverseInertia.x = (12.0f * inverseMass) / (dimsSqr.y + dimsSqr.z);
-	inverseInertia.y = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.z);
-	inverseInertia.z = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.y);
+	float invMass = GetInverseMass();
+
+	inverseInertia.x = (12.0f * invMass) / (dimsSqr.y + dimsSqr.z);
+	inverseInertia.y = (12.0f * invMass) / (dimsSqr.x + dimsSqr.z);
+	inverseInertia.z = (12.0f * invMass) / (dimsSqr.x + dimsSqr.y);
+
+	if (store) {
+		store->SetVector(RigidBodyStore::InverseInertiaX, storeIndex, inverseInertia);
+	}
 }
 
 void PhysicsObject::InitSphereInertia() 
 {
 	float radius	= Vector::GetMaxElement(transform.GetScale());
-	float i			= 2.5f * inverseMass / (radius*radius);
+	float i			= 2.5f * GetInverseMass() / (radius*radius);
 
 	inverseInertia	= Vector3(i, i, i);
+
+	if (store) {
+		store->SetVector(RigidBodyStore::InverseInertiaX, storeIndex, inverseInertia);
+	}
 }
 
 void PhysicsObject::UpdateInertiaTensor() 
 {
+	if (store) {
+		store->UpdateInertiaTensor(storeIndex);
+		return;
+	}
 	Quaternion q = transform.GetOrientation();
 
 	Matrix3 invOrientation	= Quaternion::RotationMatrix<Matrix3>(q.Conjugate());
@@ -6,40 +6,49 @@ namespace NCL {
 	
 	namespace CSC8503 {
 		class Transform;
+		class RigidBodyStore;
 
+		/*
+		Once the PhysicsSystem has picked this object up, its state lives in the
+		system's RigidBodyStore, and these functions read and write it there.
+		*/
 		class PhysicsObject	{
+			friend class RigidBodyStore;
 		public:
 			PhysicsObject(Transform& parentTransform, const CollisionVolume* parentVolume);
-			~PhysicsObject() = default;
+			~PhysicsObject();
 
-			Vector3 GetLinearVelocity() const 
-			{
-				return linearVelocity;
-			}
+			Vector3 GetLinearVelocity() const;
+			Vector3 GetAngularVelocity() const;
+			Vector3 GetTorque() const;
+			Vector3 GetForce() const;
 
-			Vector3 GetAngularVelocity() const 
-			{
-				return angularVelocity;
-			}
+			void	SetInverseMass(float invMass);
+			float	GetInverseMass() const;
 
-			Vector3 GetTorque() const 
-			{
-				return torque;
+			//How much speed this object keeps after a bounce, and how well it grips,
+			//which the solver combines with those of whatever it is touching
+			void	SetElasticity(float e) {
+				elasticity = e;
 			}
-
-			Vector3 GetForce() const 
-			{
-				return force;
+			float	GetElasticity() const {
+				return elasticity;
 			}
 
-			void SetInverseMass(float invMass) 
-			{
-				inverseMass = invMass;
+			void	SetFriction(float f) {
+				friction = f;
+			}
+			float	GetFriction() const {
+				return friction;
 			}
 
-			float GetInverseMass() const 
-			{
-				return inverseMass;
+			//Fast bodies with this set are swept along their motion each step, so
+			//they can't pass through anything thin. Picked up as they're added to the world
+			void	SetContinuousCollision(bool state) {
+				continuousCollision = state;
+			}
+			bool	UsesContinuousCollision() const {
+				return continuousCollision;
 			}
 
 			void ApplyAngularImpulse(const Vector3& force);
@@ -54,24 +63,29 @@ namespace NCL {
 
 			void ClearForces();
 
-			void SetLinearVelocity(const Vector3& v) 
-			{
-				linearVelocity = v;
-			}
-
-			void SetAngularVelocity(const Vector3& v) 
-			{
-				angularVelocity = v;
-			}
+			void SetLinearVelocity(const Vector3& v);
+			void SetAngularVelocity(const Vector3& v);
 
 			void InitCubeInertia();
 			void InitSphereInertia();
 
 			void UpdateInertiaTensor();
 
-			Matrix3 GetInertiaTensor() const 
-			{
-				return inverseInteriaTensor;
+			Matrix3 GetInertiaTensor() const;
+
+			/*
+			Bodies that have been resting for a while are put to sleep by the
+			PhysicsSystem, and skipped until something disturbs them - pushing
+			them (forces, impulses, setting their velocity), moving them by hand,
+			or an awake object touching them. Static bodies are never woken up
+			by forces, as they'd have no effect on them anyway.
+			*/
+			bool IsAwake() const;
+			void SetAwake(bool awake);
+
+			//Where this object is in the RigidBodyStore it is bound to, or -1
+			int GetStoreIndex() const {
+				return storeIndex;
 			}
 
 		protected:
@@ -81,6 +95,7 @@ namespace NCL {
 			float inverseMass;
 			float elasticity;
 			float friction;
+			bool  continuousCollision;
 
 			//linear stuff
 			Vector3 linearVelocity;
@@ -91,6 +106,11 @@ namespace NCL {
 			Vector3 torque;
 			Vector3 inverseInertia;
 			Matrix3 inverseInteriaTensor;
+
+			void WakeIfDynamic();
+
+			RigidBodyStore* store;
+			int				storeIndex;
 		};
 	}
 }
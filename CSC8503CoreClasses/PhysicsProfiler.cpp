@@ -0,0 +1,172 @@
+#include "PhysicsProfiler.h"
+#include "Debug.h"
+#include <fstream>
+#include <iomanip>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const char* zoneNames[PhysicsProfiler::ZoneCount] = {
+		"Update", "Sync", "BroadPhase", "NarrowPhase", "Solver", "Integration", "Sleeping", "Callbacks"
+	};
+	const char* counterNames[PhysicsProfiler::CounterCount] = {
+		"Steps", "PairsTested", "Contacts", "Manifolds", "AwakeBodies", "Bodies", "TreeNodes", "Islands", "Constraints"
+	};
+
+	const int OverlayFrames = 60;
+
+	double Microseconds(const Timepoint& from, const Timepoint& to) {
+		return std::chrono::duration<double, std::micro>(to - from).count();
+	}
+}
+
+PhysicsProfiler::PhysicsProfiler() {
+	enabled		= true;
+	tracing		= false;
+	epoch		= std::chrono::high_resolution_clock::now();
+	frameStart	= epoch;
+	current		= FrameStats{};
+	history.resize(HistorySize);
+	nextFrame	= 0;
+	frameCount	= 0;
+}
+
+void PhysicsProfiler::BeginFrame() {
+	current		= FrameStats{};
+	frameStart	= std::chrono::high_resolution_clock::now();
+}
+
+void PhysicsProfiler::EndFrame() {
+	if (!enabled) {
+		return;
+	}
+	EndZone(Update, frameStart);
+
+	history[nextFrame]	= current;
+	nextFrame			= (nextFrame + 1) % HistorySize;
+	frameCount			= std::min(frameCount + 1, HistorySize);
+
+	if (tracing) {
+		TraceFrame frame;
+		frame.start = Microseconds(epoch, frameStart);
+		std::copy(current.counters, current.counters + CounterCount, frame.counters);
+		traceFrames.emplace_back(frame);
+	}
+}
+
+void PhysicsProfiler::EndZone(Zone z, const Timepoint& start) {
+	Timepoint end = std::chrono::high_resolution_clock::now();
+	double duration = Microseconds(start, end);
+
+	current.zoneTimes[z] += (float)(duration / 1000.0);
+	current.zoneCalls[z]++;
+
+	if (tracing && traceEvents.size() < MaxTraceEvents) {
+		traceEvents.push_back({ z, Microseconds(epoch, start), duration });
+	}
+}
+
+const PhysicsProfiler::FrameStats& PhysicsProfiler::GetFrame(int framesAgo) const {
+	int index = nextFrame - 1 - framesAgo;
+	while (index < 0) {
+		index += HistorySize;
+	}
+	return history[index];
+}
+
+PhysicsProfiler::FrameStats PhysicsProfiler::GetAverage(int frames) const {
+	FrameStats total{};
+	frames = std::min(frames, frameCount);
+	if (frames == 0) {
+		return total;
+	}
+	float zoneCalls[ZoneCount]	= {};
+	float counters[CounterCount]	= {};
+	for (int i = 0; i < frames; ++i) {
+		const FrameStats& f = GetFrame(i);
+		for (int z = 0; z < ZoneCount; ++z) {
+			total.zoneTimes[z]	+= f.zoneTimes[z];
+			zoneCalls[z]		+= (float)f.zoneCalls[z];
+		}
+		for (int c = 0; c < CounterCount; ++c) {
+			counters[c] += (float)f.counters[c];
+		}
+	}
+	for (int z = 0; z < ZoneCount; ++z) {
+		total.zoneTimes[z] /= frames;
+		total.zoneCalls[z] = (int)std::round(zoneCalls[z] / frames);
+	}
+	for (int c = 0; c < CounterCount; ++c) {
+		total.counters[c] = (int)std::round(counters[c] / frames);
+	}
+	return total;
+}
+
+void PhysicsProfiler::DrawOverlay(const Vector2& position, float lineHeight) const {
+	FrameStats average = GetAverage(OverlayFrames);
+	Vector2 linePos = position;
+
+	for (int z = 0; z < ZoneCount; ++z) {
+		std::stringstream line;
+		line << zoneNames[z] << ": " << std::fixed << std::setprecision(2) << average.zoneTimes[z] << "ms";
+		Debug::Print(line.str(), linePos, z == Update ? Debug::YELLOW : Debug::WHITE);
+		linePos.y += lineHeight;
+	}
+	for (int c = 0; c < CounterCount; ++c) {
+		Debug::Print(std::string(counterNames[c]) + ": " + std::to_string(average.counters[c]), linePos, Debug::CYAN);
+		linePos.y += lineHeight;
+	}
+	if (tracing) {
+		Debug::Print("Tracing (" + std::to_string(traceEvents.size()) + " events)", linePos, Debug::RED);
+	}
+}
+
+void PhysicsProfiler::SetTracing(bool state) {
+	if (state && !tracing) {
+		traceEvents.clear();
+		traceFrames.clear();
+	}
+	tracing = state;
+}
+
+/*
+Zones become complete ('X') events, which the viewer nests by time, and each
+frame's counters become counter ('C') events, drawn as graphs above them.
+*/
+bool PhysicsProfiler::ExportChromeTrace(const std::string& filename) const {
+	std::ofstream file(filename);
+	if (!file) {
+		return false;
+	}
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+
+	bool first = true;
+	for (const TraceEvent& e : traceEvents) {
+		file << (first ? "" : ",\n");
+		file << "{\"name\":\"" << zoneNames[e.zone] << "\",\"cat\":\"physics\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+			<< ",\"ts\":" << e.start << ",\"dur\":" << e.duration << "}";
+		first = false;
+	}
+	for (const TraceFrame& f : traceFrames) {
+		file << (first ? "" : ",\n");
+		file << "{\"name\":\"Counters\",\"cat\":\"physics\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":" << f.start << ",\"args\":{";
+		for (int c = 0; c < CounterCount; ++c) {
+			file << (c ? "," : "") << "\"" << counterNames[c] << "\":" << f.counters[c];
+		}
+		file << "}}";
+		first = false;
+	}
+	file << "\n]}\n";
+	return (bool)file;
+}
+
+const char* PhysicsProfiler::GetZoneName(Zone z) {
+	return zoneNames[z];
+}
+
+const char* PhysicsProfiler::GetCounterName(Counter c) {
+	return counterNames[c];
+}
+
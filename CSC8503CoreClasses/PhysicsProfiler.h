@@ -0,0 +1,157 @@
+#pragma once
+#include "GameTimer.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Times where each physics frame goes, and counts how much work it did.
+
+		Zones are timed by putting a Scope round them - the same zone can be
+		entered any number of times a frame (once per substep, say), and the
+		times are added up. Counters are either added to as the frame goes,
+		or set to how things stand at the end of it. Every finished frame is
+		kept in a ring buffer, so the last few seconds can be averaged or
+		graphed.
+
+		While tracing, every zone entered is also recorded with its start time,
+		and can be written out in the Chrome trace format - load the file into
+		chrome://tracing or ui.perfetto.dev to see each frame laid out in time.
+
+		Zones are only ever entered from the thread running the update, so
+		none of this is locked.
+		*/
+		class PhysicsProfiler {
+		public:
+			enum Zone {
+				Update,		//The whole frame, from BeginFrame to EndFrame
+				Sync,
+				BroadPhase,
+				NarrowPhase,
+				Solver,
+				Integration,
+				Sleeping,
+				Callbacks,
+				ZoneCount
+			};
+
+			enum Counter {
+				Steps,
+				PairsTested,	//Pairs the broadphase passed on to the narrowphase
+				Contacts,
+				Manifolds,		//Pairs in the collision cache at the end of the frame
+				AwakeBodies,
+				Bodies,
+				TreeNodes,
+				Islands,
+				Constraints,
+				CounterCount
+			};
+
+			struct FrameStats {
+				float	zoneTimes[ZoneCount];	//Milliseconds
+				int		zoneCalls[ZoneCount];
+				int		counters[CounterCount];
+			};
+
+			static constexpr int HistorySize		= 240;
+			static constexpr int MaxTraceEvents	= 1 << 18;
+
+			class Scope {
+			public:
+				Scope(PhysicsProfiler& p, Zone z) : profiler(p.enabled ? &p : nullptr), zone(z) {
+					if (profiler) {
+						start = std::chrono::high_resolution_clock::now();
+					}
+				}
+				~Scope() {
+					if (profiler) {
+						profiler->EndZone(zone, start);
+					}
+				}
+			protected:
+				PhysicsProfiler*	profiler;
+				Zone				zone;
+				Timepoint			start;
+			};
+
+			PhysicsProfiler();
+			~PhysicsProfiler() = default;
+
+			void SetEnabled(bool state) {
+				enabled = state;
+			}
+
+			bool IsEnabled() const {
+				return enabled;
+			}
+
+			void BeginFrame();
+			void EndFrame();
+
+			void AddCounter(Counter c, int amount) {
+				current.counters[c] += amount;
+			}
+
+			void SetCounter(Counter c, int value) {
+				current.counters[c] = value;
+			}
+
+			//How many finished frames are in the history - at most HistorySize
+			int GetFrameCount() const {
+				return frameCount;
+			}
+
+			//0 is the frame that finished most recently
+			const FrameStats& GetFrame(int framesAgo = 0) const;
+
+			//Average of the most recent frames, or all of them if there aren't that many
+			FrameStats GetAverage(int frames) const;
+
+			//Prints the averages for the last second or so with Debug::Print, one line per zone or counter
+			void DrawOverlay(const Vector2& position, float lineHeight = 3.0f) const;
+
+			//Starting a trace throws away any that was recorded before
+			void SetTracing(bool state);
+
+			bool IsTracing() const {
+				return tracing;
+			}
+
+			//Writes out everything recorded since tracing was started
+			bool ExportChromeTrace(const std::string& filename) const;
+
+			static const char* GetZoneName(Zone z);
+			static const char* GetCounterName(Counter c);
+
+		protected:
+			void EndZone(Zone z, const Timepoint& start);
+
+			struct TraceEvent {
+				Zone	zone;
+				double	start;		//Microseconds since the profiler was made
+				double	duration;
+			};
+
+			struct TraceFrame {
+				double	start;
+				int		counters[CounterCount];
+			};
+
+			bool	enabled;
+			bool	tracing;
+
+			Timepoint	epoch;
+			Timepoint	frameStart;
+
+			FrameStats				current;
+			std::vector<FrameStats> history;
+			int						nextFrame;
+			int						frameCount;
+
+			std::vector<TraceEvent> traceEvents;
+			std::vector<TraceFrame> traceFrames;
+		};
+	}
+}
+
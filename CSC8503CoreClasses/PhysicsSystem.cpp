@@ -2,13 +2,17 @@
 #include "PhysicsObject.h"
 #include "GameObject.h"
 #include "CollisionDetection.h"
-#include "Quaternion.h"
+#include "ConvexCollision.h"
+#include "SphereVolume.h"
+#include "SIMDLanes.h"
 #include "QuadTree.h"
+#include "Quaternion.h"
 #include "Constraint.h"
 
 #include "Debug.h"
-#include "Window.h"
+#include "GameTimer.h"
 #include <functional>
+#include <cstring>
 using namespace NCL;
 using namespace CSC8503;
 
@@ -16,13 +20,23 @@ PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)
 {
 	applyGravity	= false;
 	useBroadPhase	= false;	
+	solverIterationCount = 6;
 	dTOffset		= 0.0f;
 	globalDamping	= 0.995f;
+
+	broadphaseStamp			= 0;
+	broadphaseWorldState	= -1;
+	bodyWorldState			= -1;
 	SetGravity(Vector3(0.0f, -9.8f, 0.0f));
+
+	gameWorld.SetPhysicsSystem(this);
 }
 
 PhysicsSystem::~PhysicsSystem()	
 {
+	if (gameWorld.GetPhysicsSystem() == this) {
+		gameWorld.SetPhysicsSystem(nullptr);
+	}
 }
 
 void PhysicsSystem::SetGravity(const Vector3& g) 
@@ -34,15 +48,73 @@ void PhysicsSystem::SetGravity(const Vector3& g)
 
 If the 'game' is ever reset, the PhysicsSystem must be
 'cleared' to remove any old collisions that might still
-be hanging around in the collision list. If your engine
-is expanded to allow objects to be removed from the world,
-you'll need to iterate through this collisions list to remove
-any collisions they are in.
+be hanging around in the collision list. Objects removed
+from the world one at a time have their collisions taken
+out by RemoveObject instead.
 
 */
 void PhysicsSystem::Clear() 
 {
-	allCollisions.clear();
+	allCollisions.Clear();
+	broadphaseCollisions.Clear();
+	separatingAxes.Clear();
+
+	broadphaseTree.Clear();
+	sweepAndPrune.Clear();
+	broadphaseDynamics.clear();
+	broadphaseProxyStamps.clear();
+	broadphaseWorldState = -1;
+	queryTreeVersion = -1;
+
+	bodies.Clear();
+	bodyWorldState = -1;
+	continuousBodies.clear();
+	fastBodies.clear();
+
+	staticTree.Clear();
+	staticWorldState = -1;
+}
+
+/*
+The world's state changes as the object leaves it, so the broadphase and body
+store would catch up on their own by the next update - but the caches only
+drop pairs as they time out, and would call back into a deleted object first.
+Anything asleep against the object, or constrained to it, has to be woken up
+before its pairs go, as nothing will touch it again to wake it later.
+*/
+void PhysicsSystem::RemoveObject(GameObject* o) 
+{
+	auto wake = [](GameObject* other) {
+		PhysicsObject* phys = other ? other->GetPhysicsObject() : nullptr;
+		if (phys && phys->GetInverseMass() > 0.0f) {
+			phys->SetAwake(true);
+		}
+	};
+	for (int i = 0; i < allCollisions.Size(); ++i) {
+		const CollisionDetection::CollisionInfo& info = allCollisions[i].info;
+		if (info.a == o || info.b == o) {
+			wake(info.a == o ? info.b : info.a);
+		}
+	}
+	std::vector<Constraint*>::const_iterator first, last;
+	gameWorld.GetConstraintIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		if ((*i)->GetObjectA() == o || (*i)->GetObjectB() == o) {
+			wake((*i)->GetObjectA() == o ? (*i)->GetObjectB() : (*i)->GetObjectA());
+		}
+	}
+
+	allCollisions.RemoveAll(o);
+	broadphaseCollisions.RemoveAll(o);
+	separatingAxes.RemoveAll(o);
+
+	int proxy = o->GetBroadphaseProxy();
+	if (broadphaseTree.IsValidProxy(proxy) && broadphaseTree.GetProxyObject(proxy) == o) {
+		broadphaseTree.Remove(proxy);
+		sweepAndPrune.Remove(proxy);
+	}
+	broadphaseDynamics.erase(std::remove(broadphaseDynamics.begin(), broadphaseDynamics.end(), o), broadphaseDynamics.end());
+	continuousBodies.erase(std::remove(continuousBodies.begin(), continuousBodies.end(), o), continuousBodies.end());
 }
 
 /*
@@ -51,196 +123,119 @@ This is the core of the physics engine update
 
 */
 
-bool useSimpleContainer = false;
-
-int constraintIterationCount = 10;
-
-//This is the fixed timestep we'd LIKE to have
+//The fixed timestep the simulation always moves forward by
 const int   idealHZ = 120;
 const float idealDT = 1.0f / idealHZ;
 
-/*
-This is the fixed update we actually have...
-If physics takes too long it starts to kill the framerate, it'll drop the 
-iteration count down until the FPS stabilises, even if that ends up
-being at a low rate. 
-*/
-int realHZ		= idealHZ;
-float realDT	= idealDT;
-
-//void PhysicsSystem::Update(float dt) 
-//{	
-//	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
-//		useBroadPhase = !useBroadPhase;
-//		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-//	}
-//	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
-//		useSimpleContainer = !useSimpleContainer;
-//		std::cout << "Setting broad container to " << useSimpleContainer << std::endl;
-//	}
-//	if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
-//		constraintIterationCount--;
-//		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-//	}
-//	if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
-//		constraintIterationCount++;
-//		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-//	}
-//
-//	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
-//
-//	GameTimer t;
-//	t.GetTimeDeltaSeconds();
-//
-//	if (useBroadPhase) {
-//		UpdateObjectAABBs();
-//	}
-//	int iteratorCount = 0;
-//	while(dTOffset > realDT) {
-//		IntegrateAccel(realDT); //Update accelerations from external forces
-//		if (useBroadPhase) {
-//			BroadPhase();
-//			NarrowPhase();
-//		}
-//		else {
-//			BasicCollisionDetection();
-//		}
-//
-//		//This is our simple iterative solver - 
-//		//we just run things multiple times, slowly moving things forward
-//		//and then rechecking that the constraints have been met		
-//		float constraintDt = realDT /  (float)constraintIterationCount;
-//		for (int i = 0; i < constraintIterationCount; ++i) {
-//			UpdateConstraints(constraintDt);	
-//		}
-//		IntegrateVelocity(realDT); //update positions from new velocity changes
-//
-//		dTOffset -= realDT;
-//		iteratorCount++;
-//	}
-//
-//	ClearForces();	//Once we've finished with the forces, reset them to zero
-//
-//	UpdateCollisionList(); //Remove any old collisions
-//
-//	t.Tick();
-//	float updateTime = t.GetTimeDeltaSeconds();
-//
-//	//Uh oh, physics is taking too long...
-//	if (updateTime > realDT) {
-//		realHZ /= 2;
-//		realDT *= 2;
-//		std::cout << "Dropping iteration count due to long physics time...(now " << realHZ << ")\n";
-//	}
-//	else if(dt*2 < realDT) { //we have plenty of room to increase iteration count!
-//		int temp = realHZ;
-//		realHZ *= 2;
-//		realDT /= 2;
-//
-//		if (realHZ > idealHZ) {
-//			realHZ = idealHZ;
-//			realDT = idealDT;
-//		}
-//		if (temp != realHZ) {
-//			std::cout << "Raising iteration count due to short physics time...(now " << realHZ << ")\n";
-//		}
-//	}
-//}
 void PhysicsSystem::Update(float dt) {
-	//  ԰  
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
-		useSimpleContainer = !useSimpleContainer;
-		std::cout << "Setting broad container to " << useSimpleContainer << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
-		constraintIterationCount--;
-		if (constraintIterationCount < 1) {
-			constraintIterationCount = 1;
-		}
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
-		constraintIterationCount++;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-
 	// ۻʱ䣨ܻһ֡ʣµʱ䣩
-	dTOffset += dt;
+	dTOffset = deterministic ? idealDT : dTOffset + dt;
 
-	GameTimer t;
-	t.GetTimeDeltaSeconds(); // reset timer
+	profiler.BeginFrame();
+	{
+		PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Sync);
+		SyncBodies();
+		SyncStaticLayer();
 
-	if (useBroadPhase) {
-		UpdateObjectAABBs();
+		if (useBroadPhase) {
+			UpdateObjectAABBs();
+		}
 	}
 
 	int iterationCount = 0;
+	GameTimer stepTimer;
 
 	//  ̶ʱ䲽ѭ  
-	while (dTOffset >= realDT) {
-		// 1)  realDT ּٶȣ -> ٶȱ仯
-		IntegrateAccel(realDT);
+	while (dTOffset >= idealDT && iterationCount < maxSubsteps) {
+		{
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Integration);
+			ParallelFor(bodies.GetAwakeCount(), 1024,
+				[&](int first, int last) {
+					bodies.StorePreviousState(first, last);
+				});
+		}
+
+		// 1)  idealDT ּٶȣ -> ٶȱ仯
+		{
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Integration);
+			IntegrateAccel(idealDT);
+		}
 
 		// 2) ײ
+		stepContacts.clear();
 		if (useBroadPhase) {
-			BroadPhase();
+			{
+				PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::BroadPhase);
+				BroadPhase();
+			}
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::NarrowPhase);
 			NarrowPhase();
+			profiler.AddCounter(PhysicsProfiler::PairsTested, broadphaseCollisions.Size());
 		}
 		else {
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::NarrowPhase);
 			BasicCollisionDetection();
 		}
+		if (deterministic) {
+			SortContacts();
+		}
+		profiler.AddCounter(PhysicsProfiler::Contacts, (int)stepContacts.size());
 
-		// 3) Լ
-		//     realDT ٻֳɶθСʱ䲽Լ
-		float constraintDt = realDT / (float)constraintIterationCount;
-		for (int i = 0; i < constraintIterationCount; ++i) {
-			UpdateConstraints(constraintDt);
+		// 3) ӴԼг + 
+		{
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Solver);
+			SolveIslands(idealDT);
 		}
 
-		// 4)  realDT ٶȣٶ -> λñ仯
-		IntegrateVelocity(realDT);
+		// 4)  idealDT ٶȣٶ -> λñ仯
+		{
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Integration);
+			FindFastBodies(idealDT);
+			IntegrateVelocity(idealDT);
+			SweepFastBodies();
+		}
 
-		// 5) ۵һõʱ
-		dTOffset -= realDT;
+		// 5) ֹõĵ
+		{
+			PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Sleeping);
+			UpdateSleeping(idealDT);
+		}
+
+		// 6) ۵һõʱ
+		dTOffset -= idealDT;
 		iterationCount++;
+
+		//Stop once another step would likely run over this frame's budget
+		double elapsed = stepTimer.GetTotalTimeSeconds();
+		if (!deterministic && elapsed + elapsed / iterationCount > stepBudget) {
+			break;
+		}
 	}
+	// ̫Ͷ׷ϵʱ
+	if (dTOffset >= idealDT) {
+		dTOffset = std::fmod(dTOffset, idealDT);
+	}
+	bodies.SetInterpolation(deterministic ? 1.0f : dTOffset / idealDT);
 
 	// һ֡
 	ClearForces();        // 
-	UpdateCollisionList();// ײϢ
-
-	t.Tick();
-	float updateTime = t.GetTimeDeltaSeconds();
-
-	//  Ӧ realDTԭԴ߼ɣ
-	if (updateTime > realDT) {
-		realHZ /= 2;
-		realDT *= 2;
-		std::cout << "Dropping iteration count due to long physics time...(now "
-			<< realHZ << ")\n";
+	{
+		PhysicsProfiler::Scope zone(profiler, PhysicsProfiler::Callbacks);
+		UpdateCollisionList();// ײϢ
 	}
-	else if (dt * 2 < realDT) {
-		int temp = realHZ;
-		realHZ *= 2;
-		realDT /= 2;
 
-		if (realHZ > idealHZ) {
-			realHZ = idealHZ;
-			realDT = idealDT;
-		}
-		if (temp != realHZ) {
-			std::cout << "Raising iteration count due to short physics time...(now "
-				<< realHZ << ")\n";
-		}
-	}
+	profiler.SetCounter(PhysicsProfiler::Steps, iterationCount);
+	profiler.SetCounter(PhysicsProfiler::Manifolds, allCollisions.Size());
+	profiler.SetCounter(PhysicsProfiler::AwakeBodies, bodies.GetAwakeCount());
+	profiler.SetCounter(PhysicsProfiler::Bodies, bodies.Size());
+	profiler.SetCounter(PhysicsProfiler::TreeNodes, broadphaseTree.GetNodeCount() + staticTree.GetNodeCount());
+	profiler.SetCounter(PhysicsProfiler::Islands, islands.GetIslandCount());
+	profiler.SetCounter(PhysicsProfiler::Constraints, (int)stepConstraints.size());
+	profiler.EndFrame();
 }
 /*
 Later on we're going to need to keep track of collisions
-across multiple frames, so we store them in a set.
+across multiple frames, so we store them in a pair cache.
 
 The first time they are added, we tell the objects they are colliding.
 The frame they are to be removed, we tell them they're no longer colliding.
@@ -250,20 +245,24 @@ OnCollisionBegin / OnCollisionEnd functions (removing health when hit by a
 rocket launcher, gaining a point when the player hits the gold coin, and so on).
 */
 void PhysicsSystem::UpdateCollisionList() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator
-		i = allCollisions.begin(); i != allCollisions.end();) {
+	for (int i = 0; i < allCollisions.Size();) {
+		PairCache::Entry& e = allCollisions[i];
 
-		if ((*i).framesLeft == numCollisionFrames) {
-			/*i->a->OnCollisionBegin(i->b);*/
-			/*i->b->OnCollisionBegin(i->a);*/
+		if (e.isNew) {
+			e.info.a->OnCollisionBegin(e.info.b);
+			e.info.b->OnCollisionBegin(e.info.a);
+			e.isNew = false;
 		}
 
-		(*i).framesLeft == (*i).framesLeft - 1;
+		//Sleeping objects aren't collided again, but are still touching
+		if (!IsResting(e.info.a) || !IsResting(e.info.b)) {
+			e.info.framesLeft = e.info.framesLeft - 1;
+		}
 
-		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
-			i = allCollisions.erase(i);
+		if (e.info.framesLeft < 0) {
+			e.info.a->OnCollisionEnd(e.info.b);
+			e.info.b->OnCollisionEnd(e.info.a);
+			allCollisions.RemoveAt(i); //Last entry moves into i, so don't step on
 		}
 		else {
 			++i;
@@ -273,22 +272,112 @@ void PhysicsSystem::UpdateCollisionList() {
 
 void PhysicsSystem::UpdateObjectAABBs() 
 {
-	std::vector < GameObject* >::const_iterator first;
-	std::vector < GameObject* >::const_iterator last;
+	if (gameWorld.GetWorldStateID() != broadphaseWorldState) {
+		SyncBroadphase();
+	}
+	ParallelFor((int)broadphaseDynamics.size(), 256,
+		[&](int first, int last) {
+			for (int i = first; i < last; ++i) {
+				if (!IsResting(broadphaseDynamics[i])) {
+					broadphaseDynamics[i]->UpdateBroadphaseAABB();
+				}
+			}
+		});
+}
+
+/*
+Physics objects are only picked up by (or dropped from) the body store when
+the world has changed. Deleted objects take themselves out of the store.
+*/
+void PhysicsSystem::SyncBodies() 
+{
+	if (gameWorld.GetWorldStateID() == bodyWorldState) {
+		return;
+	}
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
+
+	bodies.Sync(first, last);
+	bodyWorldState = gameWorld.GetWorldStateID();
+
+	continuousBodies.clear();
 	for (auto i = first; i != last; ++i) {
-		(*i) -> UpdateBroadphaseAABB();
+		PhysicsObject* phys = (*i)->GetPhysicsObject();
+		if (phys && phys->UsesContinuousCollision() && (*i)->GetBoundingVolume()) {
+			continuousBodies.emplace_back(*i);
+		}
 	}
 }
 
+/*
+The broadphase tree persists between frames, so it only needs to be brought
+back in line with the world when objects have been added or removed. New
+objects get a proxy, and any proxy that isn't claimed by an object still in
+the world is dropped. Objects with infinite mass are treated as static - they
+are inserted once here, and never moved or queried from in the BroadPhase.
+The sweep and prune arrays use the same proxy IDs, so are kept in step here too.
+*/
+void PhysicsSystem::SyncBroadphase() 
+{
+	broadphaseStamp++;
+	broadphaseDynamics.clear();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	for (auto i = first; i != last; ++i) {
+		GameObject* o = *i;
+		if (!o->GetBoundingVolume()) {
+			continue;
+		}
+		o->UpdateBroadphaseAABB();
+
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+
+		PhysicsObject* phys = o->GetPhysicsObject();
+		bool isDynamic = phys && phys->GetInverseMass() > 0.0f;
+
+		int proxy = o->GetBroadphaseProxy();
+		if (!broadphaseTree.IsValidProxy(proxy) || broadphaseTree.GetProxyObject(proxy) != o) {
+			proxy = broadphaseTree.Insert(o, o->GetTransform().GetPosition(), halfSizes);
+			sweepAndPrune.Insert(proxy, o, o->GetTransform().GetPosition(), halfSizes, !isDynamic);
+			o->SetBroadphaseProxy(proxy);
+		}
+		if (proxy >= (int)broadphaseProxyStamps.size()) {
+			broadphaseProxyStamps.resize(broadphaseTree.GetCapacity(), 0);
+		}
+		broadphaseProxyStamps[proxy] = broadphaseStamp;
+
+		if (isDynamic) {
+			broadphaseDynamics.emplace_back(o);
+		}
+	}
+	broadphaseProxyStamps.resize(broadphaseTree.GetCapacity(), 0);
+	for (int i = 0; i < broadphaseTree.GetCapacity(); ++i) {
+		if (broadphaseTree.IsValidProxy(i) && broadphaseProxyStamps[i] != broadphaseStamp) {
+			broadphaseTree.Remove(i);
+			sweepAndPrune.Remove(i);
+		}
+	}
+	broadphaseWorldState = gameWorld.GetWorldStateID();
+}
+
 /*
 
 This is how we'll be doing collision detection in tutorial 4.
 We step thorugh every pair of objects once (the inner for loop offset 
 ensures this), and determine whether they collide, and if so, add them
-to the collision set for later processing. The set will guarantee that
+to the list of contacts to be resolved this step. Once resolved, they go
+into the collision cache. The cache will guarantee that
 a particular pair will only be added once, so objects colliding for
-multiple frames won't flood the set with duplicates.
+multiple frames won't flood it with duplicates - they just have their
+frame count refreshed.
+
+Pairs whose collision layers and masks don't match are skipped before any
+intersection test is done.
 */
 void PhysicsSystem::BasicCollisionDetection() {
 	std::vector<GameObject*>::const_iterator first;
@@ -299,17 +388,31 @@ void PhysicsSystem::BasicCollisionDetection() {
 		if ((*i)->GetPhysicsObject() == nullptr) {
 			continue;
 		}
+		if (!IsResting(*i)) {
+			(*i)->UpdateBroadphaseAABB();
+			QueryStaticLayer(*i,
+				[&](GameObject* other) {
+					CollisionDetection::CollisionInfo info;
+					if ((*i)->CanCollideWith(other) && CollisionDetection::ObjectIntersection(*i, other, info)) {
+						stepContacts.emplace_back(info);
+					}
+				});
+		}
 		for (auto j = i + 1; j != last; ++j) {
 			if ((*j)->GetPhysicsObject() == nullptr) {
 				continue;
 			}
+			if (IsResting(*i) && IsResting(*j)) {
+				continue;
+			}
+			if (!(*i)->CanCollideWith(*j)) {
+				continue;
+			}
 
 			CollisionDetection::CollisionInfo info;
 
 			if (CollisionDetection::ObjectIntersection(*i, *j, info)) {
-				ImpulseResolveCollision(*info.a, *info.b, info.point);
-				info.framesLeft = numCollisionFrames;
-				allCollisions.insert(info);
+				stepContacts.emplace_back(info);
 			}
 		}
 	}
@@ -317,116 +420,160 @@ void PhysicsSystem::BasicCollisionDetection() {
 
 /*
 
-In tutorial 5, we start determining the correct response to a collision,
-so that objects separate back out. 
-
-*/
-void PhysicsSystem::ImpulseResolveCollision(
-	GameObject& a, GameObject& b,
-	CollisionDetection::ContactPoint& p) const {
-
-	PhysicsObject* physA = a.GetPhysicsObject();
-	PhysicsObject* physB = b.GetPhysicsObject();
-
-	Transform& transformA = a.GetTransform();
-	Transform& transformB = b.GetTransform();
-
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
-
-	if (totalMass == 0) {
-		return; // ̬壿
-	}
-
-	// ʹͶӰֿ
-	transformA.SetPosition(transformA.GetPosition() -
-		(p.normal * p.penetration * (physA->GetInverseMass() / totalMass)));
-
-	transformB.SetPosition(transformB.GetPosition() +
-		(p.normal * p.penetration * (physB->GetInverseMass() / totalMass)));
-
-	// λãײģ
-	Vector3 relativeA = p.localA;
-	Vector3 relativeB = p.localB;
-
-	// ײĽٶȹ
-	Vector3 angVelocityA =
-		Vector::Cross(physA->GetAngularVelocity(), relativeA);
-	Vector3 angVelocityB =
-		Vector::Cross(physB->GetAngularVelocity(), relativeB);
-
-	// ײٶȣٶ + ٶȹף
-	Vector3 fullVelocityA = physA->GetLinearVelocity() + angVelocityA;
-	Vector3 fullVelocityB = physB->GetLinearVelocity() + angVelocityB;
+Later, we replace the BasicCollisionDetection method with a broadphase
+and a narrowphase collision detection method. In the broad phase, we
+split the world up using an acceleration structure, so that we can only
+compare the collisions that we absolutely need to. 
 
-	// ײٶ
-	Vector3 contactVelocity = fullVelocityB - fullVelocityA;
+The tree is kept from frame to frame, so only objects that can actually
+move are refitted, and only they query the tree for overlaps - static
+objects will be found by those queries, but never pair with each other.
 
-	// 㷨߷ٶ
-	float impulseForce = Vector::Dot(contactVelocity, p.normal);
+With the simple container turned on, the tree is swapped for sweep and
+prune over flat sorted arrays, which can be cheaper when lots of objects
+are moving every frame, and the tree would be constantly reinserting them.
+Either can also be swapped for a QuadTree built from scratch every step,
+only there to measure the other two against.
 
-	// Ӱ
-	Vector3 inertiaA = Vector::Cross(physA->GetInertiaTensor() *
-		Vector::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector::Cross(physB->GetInertiaTensor() *
-		Vector::Cross(relativeB, p.normal), relativeB);
+Sleeping objects haven't moved, so aren't updated, and don't look for pairs
+themselves - they're still found by any awake object that comes near them.
 
-	float angularEffect = Vector::Dot(inertiaA + inertiaB, p.normal);
+The world's static objects aren't in either of these - every awake object
+queries the static layer's tree separately.
 
-	// ָϵӲΪ0.66ԺɢһЩܣ
-	float cRestitution = 0.66f;
+Collision layers and masks are checked as each pair comes out, so pairs that
+can never collide don't take up room in the pair list, or narrow phase time.
+*/
+void PhysicsSystem::BroadPhase() {
+	broadphaseCollisions.Clear();
 
-	// С J
-	float j = (-(1.0f + cRestitution) * impulseForce) /
-		(totalMass + angularEffect);
+	if (useQuadTree) {
+		QuadTree<GameObject*> tree(Vector2(1024, 1024), 7, 6);
 
-	// ĳ
-	Vector3 fullImpulse = p.normal * j;
+		std::vector<GameObject*>::const_iterator first;
+		std::vector<GameObject*>::const_iterator last;
+		gameWorld.GetObjectIterators(first, last);
+		for (auto i = first; i != last; ++i) {
+			Vector3 halfSizes;
+			if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+				continue;
+			}
+			tree.Insert(*i, (*i)->GetTransform().GetPosition(), halfSizes);
+		}
+		//Objects spanning several nodes are paired in each of them, but the cache only keeps one
+		tree.OperateOnContents(
+			[&](std::list<QuadTreeEntry<GameObject*>>& data) {
+				for (auto i = data.begin(); i != data.end(); ++i) {
+					for (auto j = std::next(i); j != data.end(); ++j) {
+						GameObject* a = i->object;
+						GameObject* b = j->object;
+						if ((!IsResting(a) || !IsResting(b)) && a->CanCollideWith(b)) {
+							broadphaseCollisions.Add(a, b);
+						}
+					}
+				}
+			});
+	}
+	else if (useSimpleContainer) {
+		for (GameObject* o : broadphaseDynamics) {
+			if (IsResting(o)) {
+				continue;
+			}
+			Vector3 halfSizes;
+			o->GetBroadphaseAABB(halfSizes);
+			sweepAndPrune.Update(o->GetBroadphaseProxy(), o->GetTransform().GetPosition(), halfSizes);
+		}
+		sweepAndPrune.FindPairs(
+			[&](GameObject* a, GameObject* b) {
+				if ((!IsResting(a) || !IsResting(b)) && a->CanCollideWith(b)) {
+					broadphaseCollisions.Add(a, b);
+				}
+			});
+	}
+	else {
+		for (GameObject* o : broadphaseDynamics) {
+			if (IsResting(o)) {
+				continue;
+			}
+			Vector3 halfSizes;
+			o->GetBroadphaseAABB(halfSizes);
+			broadphaseTree.Move(o->GetBroadphaseProxy(), o->GetTransform().GetPosition(), halfSizes);
+		}
 
-	// Ӧ߳෴
-	physA->ApplyLinearImpulse(-fullImpulse);
-	physB->ApplyLinearImpulse(fullImpulse);
+		for (GameObject* o : broadphaseDynamics) {
+			if (IsResting(o)) {
+				continue;
+			}
+			Vector3 halfSizes;
+			o->GetBroadphaseAABB(halfSizes);
+			Vector3 pos = o->GetTransform().GetPosition();
+
+			broadphaseTree.Query(pos - halfSizes, pos + halfSizes,
+				[&](GameObject* other, int) {
+					if (other != o && o->CanCollideWith(other)) {
+						broadphaseCollisions.Add(o, other);
+					}
+					return true;
+				});
+		}
+	}
 
-	// Ӧýǳ
-	physA->ApplyAngularImpulse(Vector::Cross(relativeA, -fullImpulse));
-	physB->ApplyAngularImpulse(Vector::Cross(relativeB, fullImpulse));
+	for (GameObject* o : broadphaseDynamics) {
+		if (IsResting(o)) {
+			continue;
+		}
+		QueryStaticLayer(o,
+			[&](GameObject* other) {
+				if (o->CanCollideWith(other)) {
+					broadphaseCollisions.Add(o, other);
+				}
+			});
+	}
 }
 
 /*
-
-Later, we replace the BasicCollisionDetection method with a broadphase
-and a narrowphase collision detection method. In the broad phase, we
-split the world up using an acceleration structure, so that we can only
-compare the collisions that we absolutely need to. 
-
+The static layer is only built when static objects have been added to (or
+removed from) the world - usually just the once, as a level is loaded.
 */
-void PhysicsSystem::BroadPhase() {
-	broadphaseCollisions.clear();
-	QuadTree<GameObject*> tree(Vector2(1024, 1024), 7, 6);
-
+void PhysicsSystem::SyncStaticLayer() 
+{
+	if (gameWorld.GetStaticStateID() == staticWorldState) {
+		return;
+	}
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	gameWorld.GetStaticObjectIterators(first, last);
+
+	staticTree.Clear();
 	for (auto i = first; i != last; ++i) {
-		Vector3 halfSizes;
-		if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+		GameObject* o = *i;
+		if (!o->GetBoundingVolume()) {
 			continue;
 		}
-		Vector3 pos = (*i)->GetTransform().GetPosition();
-		tree.Insert(*i, pos, halfSizes);
+		o->UpdateBroadphaseAABB();
+
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+		staticTree.Add(o, o->GetTransform().GetPosition(), halfSizes);
 	}
+	staticTree.Build();
+	staticWorldState = gameWorld.GetStaticStateID();
+}
 
-	tree.OperateOnContents(
-		[&](std::list<QuadTreeEntry<GameObject*> >& data) {
-			CollisionDetection::CollisionInfo info;
-			for (auto i = data.begin(); i != data.end(); ++i) {
-				for (auto j = std::next(i); j != data.end(); ++j) {
-					// ˶Ƿײ -
-					// ͬһԶλһĲڵеȵ
-					info.a = std::min((*i).object, (*j).object);
-					info.b = std::max((*i).object, (*j).object);
-					broadphaseCollisions.insert(info);
-				}
-			}
+//Calls func for every static object whose box overlaps the object's broadphase box
+template<typename F>
+void PhysicsSystem::QueryStaticLayer(GameObject* o, F&& func) const 
+{
+	Vector3 halfSizes;
+	if (!o->GetBroadphaseAABB(halfSizes)) {
+		return;
+	}
+	Vector3 pos = o->GetTransform().GetPosition();
+
+	staticTree.Query(pos - halfSizes, pos + halfSizes,
+		[&](GameObject* other, int) {
+			func(other);
+			return true;
 		});
 }
 
@@ -434,19 +581,97 @@ void PhysicsSystem::BroadPhase() {
 
 The broadphase will now only give us likely collisions, so we can now go through them,
 and work out if they are truly colliding, and if so, add them into the main collision list
+
+Sphere and AABB pairs are handed to the batch, and tested together once every
+pair has been sorted - anything else is tested one pair at a time as before.
+Each pair's result goes in its own slot, so the pairs can be tested on any
+number of threads, and still give the same list of contacts.
+
+Pairs that were found to be apart recently start off with the axis that
+separated them, which is usually enough to show they still are. Those axes
+are forgotten if the pair stops being tested for a few frames.
 */
 void PhysicsSystem::NarrowPhase() 
 {
-	for (std::set < CollisionDetection::CollisionInfo >::iterator
-		i = broadphaseCollisions.begin();
-		i != broadphaseCollisions.end(); ++i) {
-		CollisionDetection::CollisionInfo info = *i;
-		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
-			info.framesLeft = numCollisionFrames;
-			ImpulseResolveCollision(*info.a, *info.b, info.point);
-			allCollisions.insert(info); // insert into our main set
+	narrowPhaseBatch.Clear();
+	narrowPhasePairs.clear();
+
+	for (int i = 0; i < broadphaseCollisions.Size(); ++i) {
+		const CollisionDetection::CollisionInfo& info = broadphaseCollisions[i].info;
+		if (!narrowPhaseBatch.Add(info.a, info.b)) {
+			narrowPhasePairs.emplace_back(i);
 		}
 	}
+
+	int pairCount = (int)narrowPhasePairs.size();
+	narrowPhaseHits.resize(pairCount);
+	narrowPhaseResults.resize(pairCount);
+
+	for (int i = 0; i < pairCount; ++i) {
+		const CollisionDetection::CollisionInfo& pair = broadphaseCollisions[narrowPhasePairs[i]].info;
+		PairCache::Entry* missed = separatingAxes.Find(pair.a, pair.b);
+		narrowPhaseResults[i] = missed ? missed->info : pair;
+	}
+
+	ParallelFor(pairCount, 64,
+		[&](int first, int last) {
+			for (int i = first; i < last; ++i) {
+				const CollisionDetection::CollisionInfo& pair = broadphaseCollisions[narrowPhasePairs[i]].info;
+				narrowPhaseHits[i] = CollisionDetection::ObjectIntersection(pair.a, pair.b, narrowPhaseResults[i]);
+			}
+		});
+
+	for (int i = 0; i < pairCount; ++i) {
+		const CollisionDetection::CollisionInfo& info = narrowPhaseResults[i];
+		if (narrowPhaseHits[i]) {
+			stepContacts.emplace_back(info);
+		}
+		if (info.hasSeparatingAxis) {
+			PairCache::Entry& e = separatingAxes.Add(info.a, info.b);
+			e.info				= info;
+			e.info.framesLeft	= numCollisionFrames;
+		}
+	}
+	for (int i = 0; i < separatingAxes.Size();) {
+		PairCache::Entry& e = separatingAxes[i];
+		if (--e.info.framesLeft < 0) {
+			separatingAxes.RemoveAt(i);
+		}
+		else {
+			++i;
+		}
+	}
+
+	narrowPhaseBatch.Run(jobs);
+
+	for (int i = 0; i < narrowPhaseBatch.GetContactCount(); ++i) {
+		stepContacts.emplace_back(narrowPhaseBatch.GetContact(i));
+	}
+}
+
+/*
+Pairs that are already in the cache keep their entry (and so don't fire
+OnCollisionBegin again), but get the latest contact manifold and a fresh frame
+count. Any of the new manifold's points that match up with the old one's start
+off with the impulses the solver built up for them last time.
+*/
+int PhysicsSystem::AddCollision(const CollisionDetection::CollisionInfo& info) {
+	PairCache::Entry& e = allCollisions.Add(info.a, info.b);
+	CollisionDetection::CollisionInfo latest = info;
+	ContactSolver::CarryImpulses(e.info, latest);
+
+	e.info				= latest;
+	e.info.framesLeft	= numCollisionFrames;
+	return allCollisions.IndexOf(e);
+}
+
+//Puts the contacts found this step in order of the world IDs of their objects
+void PhysicsSystem::SortContacts() 
+{
+	std::sort(stepContacts.begin(), stepContacts.end(),
+		[](const CollisionDetection::CollisionInfo& a, const CollisionDetection::CollisionInfo& b) {
+			return PairCache::MakeKey(a.a, a.b) < PairCache::MakeKey(b.a, b.b);
+		});
 }
 
 /*
@@ -459,84 +684,426 @@ based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
 */
 void PhysicsSystem::IntegrateAccel(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	Vector3 g = applyGravity ? gravity : Vector3();
+	ParallelFor(bodies.GetAwakeCount(), 1024,
+		[&](int first, int last) {
+			bodies.IntegrateAccel(dt, g, first, last);
+		});
+}
 
-	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue; // No physics object for this GameObject!
+
+/*
+This function integrates linear and angular velocity into
+position and orientation. It may be called multiple times
+throughout a physics update, to slowly move the objects through
+the world, looking for collisions.
+*/
+void PhysicsSystem::IntegrateVelocity(float dt) 
+{
+	float frameDamping = 1.0f - (0.4f * dt);
+	ParallelFor(bodies.GetAwakeCount(), 1024,
+		[&](int first, int last) {
+			bodies.IntegrateVelocity(dt, frameDamping, first, last);
+		});
+	bodies.IncrementVersion();
+}
+
+/*
+Continuous collision detection. Anything moving further in a step than a
+fraction of its own size could pass straight through something thin, and
+never be seen touching it. So before integrating, the bodies that asked for
+it are checked for how far they're about to go, and the ones going too far
+have where they started from noted down.
+*/
+void PhysicsSystem::FindFastBodies(float dt) 
+{
+	fastBodies.clear();
+	for (GameObject* o : continuousBodies) {
+		if (IsResting(o) || o->IsTrigger()) {
+			continue;
 		}
+		Vector3 halfSizes;
+		if (!o->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		float smallest	= std::min(halfSizes.x, std::min(halfSizes.y, halfSizes.z));
+		float reach		= smallest * continuousThreshold;
+		Vector3 motion	= o->GetPhysicsObject()->GetLinearVelocity() * dt;
 
-		float inverseMass = object->GetInverseMass();
+		if (Vector::LengthSquared(motion) > reach * reach) {
+			fastBodies.push_back({ o, o->GetTransform().GetPosition() });
+		}
+	}
+}
 
-		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
-		Vector3 accel = force * inverseMass;
+/*
+Once integrated, each fast body is swept from where it started to where it
+has ended up, against everything its swept box overlaps, and stopped at the
+first thing it would have hit - nudged just into it, so that next step the
+narrow phase finds the contact, and the solver bounces it off as usual.
+
+Everything else is taken to be where it is at the end of the step, and the
+sweep only follows the body's movement, not its spin. The stopped position
+goes straight into the body store rather than through the transform, which
+would treat it as a teleport and lose the previous state rendering blends from.
+
+The dynamic objects come from the broadphase tree, which the tree broadphase
+has already moved this step. The other broadphases don't keep it moving, so
+it is brought up to date here the same way scene queries do it.
+*/
+void PhysicsSystem::SweepFastBodies() 
+{
+	if (fastBodies.empty()) {
+		return;
+	}
+	if (!useBroadPhase || useSimpleContainer || useQuadTree) {
+		UpdateQueryTrees();
+	}
+	bool moved = false;
+	for (const FastBody& f : fastBodies) {
+		GameObject* o = f.object;
+		Vector3 end		= o->GetTransform().GetPosition();
+		Vector3 motion	= end - f.start;
+
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+		Vector3 boxMin(std::min(f.start.x, end.x), std::min(f.start.y, end.y), std::min(f.start.z, end.z));
+		Vector3 boxMax(std::max(f.start.x, end.x), std::max(f.start.y, end.y), std::max(f.start.z, end.z));
+		boxMin -= halfSizes;
+		boxMax += halfSizes;
+
+		ConvexShape shape(*o->GetBoundingVolume(), o->GetTransform());
+		shape.Translate(-motion);
+
+		float	earliest = 1.0f;
+		Vector3 hitNormal;
+		auto sweep = [&](GameObject* other) {
+			if (other == o || other->IsTrigger() || !other->GetBoundingVolume() || !o->CanCollideWith(other)) {
+				return;
+			}
+			ConvexShape otherShape(*other->GetBoundingVolume(), other->GetTransform());
+			float	toi;
+			Vector3 normal;
+			if (ConvexCollision::TimeOfImpact(shape, motion, otherShape, Vector3(), toi, normal) && toi < earliest) {
+				earliest	= toi;
+				hitNormal	= normal;
+			}
+		};
+		staticTree.Query(boxMin, boxMax,
+			[&](GameObject* other, int) {
+				sweep(other);
+				return true;
+			});
+
+		broadphaseTree.Query(boxMin, boxMax,
+			[&](GameObject* other, int) {
+				sweep(other);
+				return true;
+			});
+		if (earliest < 1.0f) {
+			bodies.SetVector(RigidBodyStore::PositionX, o->GetPhysicsObject()->GetStoreIndex(),
+				f.start + motion * earliest + hitNormal * continuousSlop);
+			moved = true;
+		}
+	}
+	if (moved) {
+		bodies.IncrementVersion();
+	}
+}
 
-		if (applyGravity && inverseMass > 0) {
-			accel += gravity; // Don't move infinitely heavy things
+/*
+Queries can come in at any point in the frame, and in any broadphase mode, so
+the trees are brought up to date by the first query after anything has moved
+(or been added), rather than by the physics update. Objects moved by hand are
+only picked up once the next physics step moves the bodies again - until then
+the fat boxes in the tree are usually still big enough to hold them.
+*/
+void PhysicsSystem::UpdateQueryTrees() 
+{
+	SyncStaticLayer();
+	if (gameWorld.GetWorldStateID() != broadphaseWorldState) {
+		SyncBroadphase();
+	}
+	else if (bodies.GetVersion() == queryTreeVersion) {
+		return;
+	}
+	for (GameObject* o : broadphaseDynamics) {
+		if (IsResting(o)) {
+			continue;
 		}
+		o->UpdateBroadphaseAABB();
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+		broadphaseTree.Move(o->GetBroadphaseProxy(), o->GetTransform().GetPosition(), halfSizes);
+	}
+	queryTreeVersion = bodies.GetVersion();
+}
 
-		linearVel += accel * dt; // integrate accel!
-		object->SetLinearVelocity(linearVel);
-		
-		// ˶
-		Vector3 torque = object->GetTorque();
-		Vector3 angVel = object->GetAngularVelocity();
+/*
+The static layer is tried first, as the level usually blocks most rays - whatever
+it hits then cuts the ray short before the dynamic objects are looked at.
+*/
+bool PhysicsSystem::Raycast(const Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignore, unsigned int layerMask) 
+{
+	UpdateQueryTrees();
+
+	RayCollision closest;
+	auto test = [&](GameObject* o) {
+		RayCollision collision;
+		if (o == ignore || !(o->GetCollisionLayer() & layerMask) || 
+			!CollisionDetection::RayIntersection(r, *o, collision) || collision.rayDistance >= closest.rayDistance) {
+			return closest.rayDistance;
+		}
+		closest			= collision;
+		closest.node	= o;
+		return closestObject ? closest.rayDistance : -1.0f;
+	};
+	staticTree.RayQuery(r.GetPosition(), r.GetDirection(), FLT_MAX, Vector3(),
+		[&](GameObject* o, int) {
+			return test(o);
+		});
 
-		object->UpdateInertiaTensor(); // ķ
+	if (closestObject || !closest.node) {
+		broadphaseTree.RayQuery(r.GetPosition(), r.GetDirection(), closest.rayDistance, Vector3(),
+			[&](GameObject* o, int) {
+				return test(o);
+			});
+	}
+	if (!closest.node) {
+		return false;
+	}
+	closestCollision = closest;
+	return true;
+}
 
-		Vector3 angAccel = object->GetInertiaTensor() * torque;
+int PhysicsSystem::RaycastBatch(const Ray* rays, int count, RayCollision* results, unsigned int layerMask) 
+{
+	UpdateQueryTrees();
+
+	int packetCount = (count + LaneWidth - 1) / LaneWidth;
+	ParallelFor(packetCount, 16,
+		[&](int first, int last) {
+			for (int i = first; i < last; ++i) {
+				int offset = i * LaneWidth;
+				TracePacket(rays + offset, std::min(LaneWidth, count - offset), results + offset, layerMask);
+			}
+		});
 
-		angVel += angAccel * dt; // ֽǼٶȣ
-		object->SetAngularVelocity(angVel);
+	int hits = 0;
+	for (int i = 0; i < count; ++i) {
+		hits += results[i].node ? 1 : 0;
 	}
+	return hits;
 }
 
+/*
+Traces up to LaneWidth rays together - each node's box is tested against
+every ray in the packet at once, one ray per SIMD lane, and the packet only
+goes down into the node if at least one of them hits it, and could still
+find something closer than it already has. Each object reached is then
+tested properly against just the rays whose lanes were still active.
+
+The packet is ordered along the rays' average direction, so works best with
+rays that head roughly the same way, like those fanned out from one point.
+*/
+void PhysicsSystem::TracePacket(const Ray* rays, int count, RayCollision* results, unsigned int layerMask) const 
+{
+	float originX[LaneWidth], originY[LaneWidth], originZ[LaneWidth];
+	float invDirX[LaneWidth], invDirY[LaneWidth], invDirZ[LaneWidth];
+	float best[LaneWidth];
+
+	Vector3 averageDir;
+	for (int i = 0; i < LaneWidth; ++i) {
+		const Ray&	r	= rays[std::min(i, count - 1)];	//Spare lanes copy the last ray, but never hit anything
+		Vector3		pos = r.GetPosition();
+		Vector3		dir = r.GetDirection();
+
+		originX[i] = pos.x;
+		originY[i] = pos.y;
+		originZ[i] = pos.z;
+		invDirX[i] = dir.x != 0.0f ? 1.0f / dir.x : FLT_MAX;
+		invDirY[i] = dir.y != 0.0f ? 1.0f / dir.y : FLT_MAX;
+		invDirZ[i] = dir.z != 0.0f ? 1.0f / dir.z : FLT_MAX;
+		best[i] = i < count ? FLT_MAX : -1.0f;
+
+		if (i < count) {
+			results[i]	= RayCollision();
+			averageDir	+= dir;
+		}
+	}
+	Lane ox = LaneLoad(originX);
+	Lane oy = LaneLoad(originY);
+	Lane oz = LaneLoad(originZ);
+	Lane ix = LaneLoad(invDirX);
+	Lane iy = LaneLoad(invDirY);
+	Lane iz = LaneLoad(invDirZ);
+
+	int activeLanes = 0;	//Rays that made it into the last box tested
+	auto test = [&](const Vector3& min, const Vector3& max) {
+		Lane t0		= LaneMul(LaneSub(LaneSplat(min.x), ox), ix);
+		Lane t1		= LaneMul(LaneSub(LaneSplat(max.x), ox), ix);
+		Lane tNear	= LaneMax(LaneSplat(0.0f), LaneMin(t0, t1));
+		Lane tFar	= LaneMin(LaneLoad(best), LaneMax(t0, t1));
+
+		t0		= LaneMul(LaneSub(LaneSplat(min.y), oy), iy);
+		t1		= LaneMul(LaneSub(LaneSplat(max.y), oy), iy);
+		tNear	= LaneMax(tNear, LaneMin(t0, t1));
+		tFar	= LaneMin(tFar, LaneMax(t0, t1));
+
+		t0		= LaneMul(LaneSub(LaneSplat(min.z), oz), iz);
+		t1		= LaneMul(LaneSub(LaneSplat(max.z), oz), iz);
+		tNear	= LaneMax(tNear, LaneMin(t0, t1));
+		tFar	= LaneMin(tFar, LaneMax(t0, t1));
+
+		activeLanes = ~LaneBits(LaneLess(tFar, tNear)) & ((1 << LaneWidth) - 1);
+		return activeLanes != 0;
+	};
+	auto hit = [&](GameObject* o) {
+		if (!(o->GetCollisionLayer() & layerMask)) {
+			return;
+		}
+		for (int i = 0; i < count; ++i) {
+			RayCollision collision;
+			if ((activeLanes & (1 << i)) && CollisionDetection::RayIntersection(rays[i], *o, collision) && collision.rayDistance < best[i]) {
+				best[i]			= collision.rayDistance;
+				results[i]		= collision;
+				results[i].node = o;
+			}
+		}
+	};
+	staticTree.Traverse(averageDir, test,
+		[&](GameObject* o, int) {
+			hit(o);
+		});
+	broadphaseTree.Traverse(averageDir, test,
+		[&](GameObject* o, int) {
+			hit(o);
+		});
+}
 
 /*
-This function integrates linear and angular velocity into
-position and orientation. It may be called multiple times
-throughout a physics update, to slowly move the objects through
-the world, looking for collisions.
+Shape casts use the same trees as rays, just with every box grown by the
+half size of the shape's own box, so that any box the shape's centre passes
+through is one the shape itself would touch. Each object found is then swept
+against properly, using conservative advancement - as continuous collision
+detection does - which works for any pair of volumes.
 */
-void PhysicsSystem::IntegrateVelocity(float dt) 
+bool PhysicsSystem::ShapeCast(const CollisionVolume& volume, const Transform& transform, const Vector3& dir, float maxDistance,
+	RayCollision& hit, GameObject* ignore, unsigned int layerMask) 
 {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-	float frameLinearDamping = 1.0f - (0.4f * dt);
+	UpdateQueryTrees();
 
-	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue;
+	ConvexShape shape(volume, transform);
+	Vector3		origin = shape.GetPosition();
+	Vector3		extent = shape.GetExtent();
+	Vector3		motion = dir * maxDistance;
+
+	RayCollision closest;
+	auto test = [&](GameObject* o) {
+		if (o == ignore || !(o->GetCollisionLayer() & layerMask) || !o->GetBoundingVolume()) {
+			return closest.rayDistance;
+		}
+		ConvexShape other(*o->GetBoundingVolume(), o->GetTransform());
+		float	toi;
+		Vector3 normal;
+		if (!ConvexCollision::TimeOfImpact(shape, motion, other, Vector3(), toi, normal) || toi * maxDistance >= closest.rayDistance) {
+			return closest.rayDistance;
 		}
-		Transform& transform = (*i)->GetTransform();
-		// 
-		Vector3 position = transform.GetPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
-		position += linearVel * dt;
-		transform.SetPosition(position);
-		// 
-		linearVel = linearVel * frameLinearDamping;
-		object->SetLinearVelocity(linearVel);
-		// 
-		Quaternion orientation = transform.GetOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
+		ConvexShape moved = shape;
+		moved.Translate(motion * toi);
+
+		closest.node		= o;
+		closest.rayDistance = toi * maxDistance;
+		closest.collidedAt	= moved.Support(normal);
+		return closest.rayDistance;
+	};
+	staticTree.RayQuery(origin, dir, maxDistance, extent,
+		[&](GameObject* o, int) {
+			return test(o);
+		});
+	broadphaseTree.RayQuery(origin, dir, std::min(maxDistance, closest.rayDistance), extent,
+		[&](GameObject* o, int) {
+			return test(o);
+		});
+
+	if (!closest.node) {
+		return false;
+	}
+	hit = closest;
+	return true;
+}
+
+bool PhysicsSystem::SphereCast(const Vector3& origin, float radius, const Vector3& dir, float maxDistance,
+	RayCollision& hit, GameObject* ignore, unsigned int layerMask) 
+{
+	SphereVolume	sphere(radius);
+	Transform		transform;
+	transform.SetPosition(origin);
+	return ShapeCast(sphere, transform, dir, maxDistance, hit, ignore, layerMask);
+}
 
-		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
-		orientation.Normalise();
+/*
+Both trees are asked for whatever's in the volume's box, and only those
+objects are tested against the volume itself.
+*/
+int PhysicsSystem::Overlap(const CollisionVolume& volume, const Transform& transform, GameObject** results, int maxResults, unsigned int layerMask) 
+{
+	UpdateQueryTrees();
 
-		transform.SetOrientation(orientation);
+	ConvexShape shape(volume, transform);
+	Vector3		extent	= shape.GetExtent();
+	Vector3		boxMin	= shape.GetPosition() - extent;
+	Vector3		boxMax	= shape.GetPosition() + extent;
 
-		// Ҳٶ
-		float frameAngularDamping = 1.0f - (0.4f * dt);
-		angVel = angVel * frameAngularDamping;
-		object->SetAngularVelocity(angVel);
-	}
+	int found = 0;
+	auto test = [&](GameObject* o) {
+		if (found == maxResults) {
+			return false;
+		}
+		if (!(o->GetCollisionLayer() & layerMask) || !o->GetBoundingVolume()) {
+			return true;
+		}
+		if (ConvexCollision::Overlap(shape, ConvexShape(*o->GetBoundingVolume(), o->GetTransform()))) {
+			results[found++] = o;
+		}
+		return found < maxResults;
+	};
+	staticTree.Query(boxMin, boxMax,
+		[&](GameObject* o, int) {
+			return test(o);
+		});
+	broadphaseTree.Query(boxMin, boxMax,
+		[&](GameObject* o, int) {
+			return test(o);
+		});
+	return found;
+}
+
+/*
+An object's box always holds its position, so how far away the box is can
+never be more than how far away the object is - once maxResults have been
+found, any box further away than the furthest of them can be skipped.
+*/
+int PhysicsSystem::FindNearest(const Vector3& point, GameObject** results, int maxResults, float maxDistance, unsigned int layerMask) 
+{
+	UpdateQueryTrees();
+
+	int found = 0;
+	auto test = [&](GameObject* o) {
+		if (o->GetCollisionLayer() & layerMask) {
+			found = GameWorld::InsertNearest(point, o, results, found, maxResults, maxDistance);
+		}
+		return maxDistance;
+	};
+	broadphaseTree.NearestQuery(point, maxDistance,
+		[&](GameObject* o, int) {
+			return test(o);
+		});
+	staticTree.NearestQuery(point, maxDistance,
+		[&](GameObject* o, int) {
+			return test(o);
+		});
+	return found;
 }
 
 /*
@@ -546,11 +1113,7 @@ ones in the next 'game' frame.
 */
 void PhysicsSystem::ClearForces() 
 {
-	gameWorld.OperateOnContents(
-		[](GameObject* o) {
-			o->GetPhysicsObject()->ClearForces();
-		}
-	);
+	bodies.ClearForces();
 }
 
 
@@ -560,14 +1123,460 @@ As part of the final physics tutorials, we add in the ability
 to constrain objects based on some extra calculation, allowing
 us to model springs and ropes etc. 
 
+Most constraints are solved along with the rest of their island in
+SolveIslands - this handles any that don't say which objects they join.
 */
 void PhysicsSystem::UpdateConstraints(float dt) 
+{
+	for (Constraint* c : freeConstraints) {
+		c->UpdateConstraint(dt);
+	}
+}
+
+/*
+Every contact found this step, and every constraint, joins its two objects
+into an island. Islands can't affect each other, so each one is solved
+independently of the rest - which lets them be spread across threads. Within
+an island, everything is done in the order it was found, so the end result is
+the same regardless of how many threads there are, or which islands they pick up.
+
+Contacts are first merged into the collision cache (serially, as it's not
+thread safe), so that the solver works on the cached manifolds, and the
+impulses it builds up are still there to warm start it next step. Then each
+island's contacts are prepared and warm started, and the solver iterates over
+its constraints and contacts together.
+
+The built in constraint types (distance, ball and socket, orientation) are
+left to the ConstraintSolver instead, which works through all of them at once,
+a colour at a time. Each iteration solves those first, then every island's
+contacts and custom constraints - so a bridge is still linked into one island
+with whatever is resting on it, and sleeps and wakes as one.
+
+Contacts with a trigger go into the cache (so still raise collision events),
+but aren't put in any island, so are never solved.
+*/
+void PhysicsSystem::SolveIslands(float dt) 
 {
 	std::vector<Constraint*>::const_iterator first;
 	std::vector<Constraint*>::const_iterator last;
 	gameWorld.GetConstraintIterators(first, last);
 
+	stepConstraints.clear();
+	freeConstraints.clear();
+	islandItemBodies.clear();
+
+	//Constraints between objects that are both asleep (or static) have nothing to do
 	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateConstraint(dt);
+		GameObject* objectA = (*i)->GetObjectA();
+		GameObject* objectB = (*i)->GetObjectB();
+		if (objectA && objectB && IsResting(objectA) && IsResting(objectB)) {
+			continue;
+		}
+		stepConstraints.emplace_back(*i);
+	}
+	WakeTouchedBodies();
+	islands.Reset(bodies.Size());
+	constraintSolver.Reset(bodies.Size());
+
+	int contactCount = (int)stepContacts.size();
+
+	stepManifolds.resize(contactCount);
+	for (int i = 0; i < contactCount; ++i) {
+		stepManifolds[i] = AddCollision(stepContacts[i]);
+	}
+	contactSolver.Reset(contactCount);
+
+	for (const CollisionDetection::CollisionInfo& info : stepContacts) {
+		if (info.a->IsTrigger() || info.b->IsTrigger()) {
+			islandItemBodies.emplace_back(-1);
+			continue;
+		}
+		bool staticA, staticB;
+		int bodyA = GetBodyIndex(info.a, staticA);
+		int bodyB = GetBodyIndex(info.b, staticB);
+
+		islands.Link(bodyA, bodyB, staticA, staticB);
+		islandItemBodies.emplace_back(!staticA ? bodyA : (!staticB ? bodyB : -1));
 	}
-}
\ No newline at end of file
+	for (Constraint* c : stepConstraints) {
+		GameObject* objectA = c->GetObjectA();
+		GameObject* objectB = c->GetObjectB();
+		if (!objectA || !objectB) {
+			freeConstraints.emplace_back(c);
+			islandItemBodies.emplace_back(-1);
+			continue;
+		}
+		bool staticA, staticB;
+		int bodyA = GetBodyIndex(objectA, staticA);
+		int bodyB = GetBodyIndex(objectB, staticB);
+
+		if (staticA && staticB) {
+			freeConstraints.emplace_back(c);
+			islandItemBodies.emplace_back(-1);
+			continue;
+		}
+		islands.Link(bodyA, bodyB, staticA, staticB);
+
+		//The built in types are solved in bulk, so still join islands up, but aren't items of them
+		if (constraintSolver.Add(c, staticA ? -1 : bodyA, staticB ? -1 : bodyB)) {
+			islandItemBodies.emplace_back(-1);
+			continue;
+		}
+		islandItemBodies.emplace_back(!staticA ? bodyA : bodyB);
+	}
+	islands.Build(islandItemBodies);
+
+	float constraintDt = dt / (float)solverIterationCount;
+
+	auto contactsEnd = [&](const IslandGraph::Island& island) {
+		//Contacts come before constraints in the item list
+		int itemsEnd	= island.firstItem + island.itemCount;
+		int end			= island.firstItem;
+		while (end < itemsEnd && islands.GetItem(end) < contactCount) {
+			end++;
+		}
+		return end;
+	};
+
+	constraintSolver.PreStep(dt, jobs);
+	constraintSolver.WarmStart(jobs);
+
+	ParallelFor(islands.GetIslandCount(), 16,
+		[&](int firstIsland, int lastIsland) {
+			for (int i = firstIsland; i < lastIsland; ++i) {
+				const IslandGraph::Island& island = islands.GetIsland(i);
+				int end = contactsEnd(island);
+
+				for (int item = island.firstItem; item < end; ++item) {
+					int contact = islands.GetItem(item);
+					contactSolver.PreStep(contact, allCollisions[stepManifolds[contact]].info, dt);
+				}
+				for (int item = island.firstItem; item < end; ++item) {
+					contactSolver.WarmStart(islands.GetItem(item));
+				}
+			}
+		});
+
+	for (int iteration = 0; iteration < solverIterationCount; ++iteration) {
+		constraintSolver.Solve(jobs);
+
+		ParallelFor(islands.GetIslandCount(), 16,
+			[&](int firstIsland, int lastIsland) {
+				for (int i = firstIsland; i < lastIsland; ++i) {
+					const IslandGraph::Island& island = islands.GetIsland(i);
+					int end = contactsEnd(island);
+
+					for (int item = end; item < island.firstItem + island.itemCount; ++item) {
+						stepConstraints[islands.GetItem(item) - contactCount]->UpdateConstraint(constraintDt);
+					}
+					for (int item = island.firstItem; item < end; ++item) {
+						contactSolver.Solve(islands.GetItem(item));
+					}
+				}
+			});
+	}
+	constraintSolver.StoreImpulses();
+
+	for (int i = 0; i < solverIterationCount; ++i) {
+		UpdateConstraints(constraintDt);
+	}
+}
+
+/*
+Anything asleep that an awake object has touched, or is joined to by a
+constraint, is woken up here - before any body indices are looked up for the
+islands, as waking a body moves it in the store. Static objects are left as
+they are, as nothing touching them could make them move - and so is anything
+only touching a trigger.
+*/
+void PhysicsSystem::WakeTouchedBodies() 
+{
+	auto wakePair = [&](GameObject* a, GameObject* b) {
+		PhysicsObject* physA = a->GetPhysicsObject();
+		PhysicsObject* physB = b->GetPhysicsObject();
+		if (!physA || !physB) {
+			return;
+		}
+		bool movingA = !IsResting(a);
+		bool movingB = !IsResting(b);
+		if (movingA && !movingB && physB->GetInverseMass() > 0.0f) {
+			physB->SetAwake(true);
+		}
+		if (movingB && !movingA && physA->GetInverseMass() > 0.0f) {
+			physA->SetAwake(true);
+		}
+	};
+	for (const CollisionDetection::CollisionInfo& info : stepContacts) {
+		if (!info.a->IsTrigger() && !info.b->IsTrigger()) {
+			wakePair(info.a, info.b);
+		}
+	}
+	for (Constraint* c : stepConstraints) {
+		if (c->GetObjectA() && c->GetObjectB()) {
+			wakePair(c->GetObjectA(), c->GetObjectB());
+		}
+	}
+}
+
+/*
+Every awake body keeps track of how long it has been moving slowly. Bodies in
+an island can only go to sleep together, once the whole island has been slow
+for long enough - otherwise a body at the bottom of a stack could fall asleep
+while the ones above it are still settling. Anything touching nothing goes to
+sleep on its own timer.
+*/
+void PhysicsSystem::UpdateSleeping(float dt) 
+{
+	if (!allowSleeping) {
+		while (bodies.GetAwakeCount() < bodies.Size()) {
+			bodies.SetAwake(bodies.GetAwakeCount(), true);
+		}
+		return;
+	}
+	int awakeCount = bodies.GetAwakeCount();
+	ParallelFor(awakeCount, 1024,
+		[&](int first, int last) {
+			bodies.UpdateSleepTimes(dt, sleepLinearSpeed, sleepAngularSpeed, first, last);
+		});
+
+	islandSleepTimes.assign(islands.GetIslandCount(), FLT_MAX);
+	for (int i = 0; i < awakeCount; ++i) {
+		int island = islands.GetBodyIsland(i);
+		if (island >= 0) {
+			islandSleepTimes[island] = std::min(islandSleepTimes[island], bodies.Get(RigidBodyStore::SleepTime, i));
+		}
+	}
+	sleepers.clear();
+	for (int i = 0; i < awakeCount; ++i) {
+		int island = islands.GetBodyIsland(i);
+		float time = island >= 0 ? islandSleepTimes[island] : bodies.Get(RigidBodyStore::SleepTime, i);
+		if (time >= sleepTime) {
+			sleepers.emplace_back(bodies.GetPhysicsObject(i));
+		}
+	}
+	//Each one moves other bodies around the store, so go by object rather than index
+	for (PhysicsObject* o : sleepers) {
+		o->SetAwake(false);
+	}
+}
+
+//True for objects that can't currently be moving - asleep, static, or without physics
+bool PhysicsSystem::IsResting(const GameObject* o) const 
+{
+	PhysicsObject* phys = o->GetPhysicsObject();
+	return !phys || !phys->IsAwake() || phys->GetInverseMass() == 0.0f;
+}
+
+//Returns where the object's physics state is in the body store, or -1 if it has none
+int PhysicsSystem::GetBodyIndex(const GameObject* o, bool& isStatic) const 
+{
+	PhysicsObject* phys = o->GetPhysicsObject();
+	if (!phys || phys->GetStoreIndex() < 0) {
+		isStatic = true;
+		return -1;
+	}
+	isStatic = bodies.Get(RigidBodyStore::InverseMass, phys->GetStoreIndex()) == 0.0f;
+	return phys->GetStoreIndex();
+}
+
+void PhysicsSystem::ParallelFor(int count, int grainSize, const RangeJob& func) 
+{
+	if (jobs) {
+		jobs->ParallelFor(count, grainSize, func);
+	}
+	else if (count > 0) {
+		func(0, count);
+	}
+}
+
+/*
+Snapshots are a header, then a record per body and per cached pair, and the
+warm starting impulse of each constraint, written out as they are in memory -
+so are only meant to be read back by the same build.
+*/
+namespace {
+	template<typename T>
+	void WriteSnapshot(std::vector<char>& buffer, const T& value) {
+		const char* bytes = (const char*)&value;
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadSnapshot(const char*& data, const char* end, T& value) {
+		if (end - data < (ptrdiff_t)sizeof(T)) {
+			return false;
+		}
+		memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+		return true;
+	}
+}
+
+void PhysicsSystem::SaveState(std::vector<char>& buffer) 
+{
+	SyncBodies();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	SnapshotHeader header;
+	header.bodyCount		= bodies.Size();
+	header.collisionCount	= allCollisions.Size();
+	header.separatedCount	= separatingAxes.Size();
+	std::vector<Constraint*>::const_iterator firstConstraint;
+	std::vector<Constraint*>::const_iterator lastConstraint;
+	gameWorld.GetConstraintIterators(firstConstraint, lastConstraint);
+
+	header.constraintCount	= (int)(lastConstraint - firstConstraint);
+	header.timeOffset		= dTOffset;
+	header.randomState		= gameWorld.GetRandomState();
+
+	buffer.clear();
+	buffer.reserve(sizeof(SnapshotHeader) + header.bodyCount * sizeof(SnapshotBody) +
+		(header.collisionCount + header.separatedCount) * sizeof(SnapshotPair));
+	WriteSnapshot(buffer, header);
+
+	for (auto i = first; i != last; ++i) {
+		PhysicsObject* phys = (*i)->GetPhysicsObject();
+		if (!phys || phys->GetStoreIndex() < 0) {
+			continue;
+		}
+		SnapshotBody body;
+		body.worldID	= (*i)->GetWorldID();
+		body.awake		= bodies.IsAwake(phys->GetStoreIndex());
+		bodies.SaveState(phys->GetStoreIndex(), body.state);
+		WriteSnapshot(buffer, body);
+	}
+	SavePairs(allCollisions, buffer);
+	SavePairs(separatingAxes, buffer);
+
+	for (auto i = firstConstraint; i != lastConstraint; ++i) {
+		WriteSnapshot(buffer, ConstraintSolver::GetImpulse(*i));
+	}
+}
+
+bool PhysicsSystem::RestoreState(const std::vector<char>& buffer) 
+{
+	const char* data	= buffer.data();
+	const char* end		= data + buffer.size();
+
+	SnapshotHeader header;
+	if (!ReadSnapshot(data, end, header)) {
+		return false;
+	}
+	SyncBodies();
+
+	//Constraints are matched up by order, so only if none have come or gone since
+	std::vector<Constraint*>::const_iterator firstConstraint;
+	std::vector<Constraint*>::const_iterator lastConstraint;
+	gameWorld.GetConstraintIterators(firstConstraint, lastConstraint);
+
+	if (header.bodyCount != bodies.Size() || header.collisionCount < 0 || header.separatedCount < 0 ||
+		header.constraintCount != (int)(lastConstraint - firstConstraint)) {
+		return false;
+	}
+	size_t expectedSize = sizeof(SnapshotHeader) + header.bodyCount * sizeof(SnapshotBody) +
+		((size_t)header.collisionCount + header.separatedCount) * sizeof(SnapshotPair) + header.constraintCount * sizeof(Vector3);
+	if (buffer.size() != expectedSize) {
+		return false;
+	}
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	snapshotObjects.clear();
+	for (bool statics : { false, true }) {
+		if (statics) {
+			gameWorld.GetStaticObjectIterators(first, last);
+		}
+		else {
+			gameWorld.GetObjectIterators(first, last);
+		}
+		for (auto i = first; i != last; ++i) {
+			snapshotObjects.emplace_back((*i)->GetWorldID(), *i);
+		}
+	}
+	std::sort(snapshotObjects.begin(), snapshotObjects.end());
+
+	//Everything is read, and matched up to the world, before anything is changed
+	snapshotBodies.resize(header.bodyCount);
+	for (SnapshotBody& body : snapshotBodies) {
+		ReadSnapshot(data, end, body);
+		GameObject* o = FindSnapshotObject(body.worldID);
+		PhysicsObject* phys = o ? o->GetPhysicsObject() : nullptr;
+		if (!phys || phys->GetStoreIndex() < 0) {
+			return false;
+		}
+	}
+	snapshotPairs.resize(header.collisionCount + header.separatedCount);
+	for (SnapshotPair& pair : snapshotPairs) {
+		ReadSnapshot(data, end, pair);
+		if (!FindSnapshotObject(pair.worldIDA) || !FindSnapshotObject(pair.worldIDB)) {
+			return false;
+		}
+	}
+	snapshotImpulses.resize(header.constraintCount);
+	for (Vector3& impulse : snapshotImpulses) {
+		ReadSnapshot(data, end, impulse);
+	}
+
+	for (const SnapshotBody& body : snapshotBodies) {
+		PhysicsObject* phys = FindSnapshotObject(body.worldID)->GetPhysicsObject();
+		//Waking or sleeping moves the body, so it's only loaded once that's done
+		bodies.SetAwake(phys->GetStoreIndex(), body.awake != 0);
+		bodies.LoadState(phys->GetStoreIndex(), body.state);
+	}
+	bodies.IncrementVersion();
+
+	RestorePairs(allCollisions, 0, header.collisionCount);
+	RestorePairs(separatingAxes, header.collisionCount, header.separatedCount);
+
+	for (auto i = firstConstraint; i != lastConstraint; ++i) {
+		ConstraintSolver::SetImpulse(*i, snapshotImpulses[i - firstConstraint]);
+	}
+	dTOffset = header.timeOffset;
+	gameWorld.SetRandomState(header.randomState);
+
+	//Everything may have moved, so the broadphase starts again from scratch
+	broadphaseCollisions.Clear();
+	broadphaseTree.Clear();
+	sweepAndPrune.Clear();
+	broadphaseProxyStamps.clear();
+	broadphaseWorldState	= -1;
+	queryTreeVersion		= -1;
+	return true;
+}
+
+void PhysicsSystem::SavePairs(const PairCache& pairs, std::vector<char>& buffer) const 
+{
+	for (int i = 0; i < pairs.Size(); ++i) {
+		SnapshotPair pair;
+		pair.worldIDA	= pairs[i].info.a->GetWorldID();
+		pair.worldIDB	= pairs[i].info.b->GetWorldID();
+		pair.isNew		= pairs[i].isNew;
+		pair.info		= pairs[i].info;
+		WriteSnapshot(buffer, pair);
+	}
+}
+
+void PhysicsSystem::RestorePairs(PairCache& pairs, int first, int count) const 
+{
+	pairs.Clear();
+	for (int i = first; i < first + count; ++i) {
+		const SnapshotPair& pair = snapshotPairs[i];
+		GameObject* a = FindSnapshotObject(pair.worldIDA);
+		GameObject* b = FindSnapshotObject(pair.worldIDB);
+
+		PairCache::Entry& e = pairs.Add(a, b);
+		e.info		= pair.info;
+		e.info.a	= a;
+		e.info.b	= b;
+		e.isNew		= pair.isNew != 0;
+	}
+}
+
+GameObject* PhysicsSystem::FindSnapshotObject(int worldID) const 
+{
+	auto i = std::lower_bound(snapshotObjects.begin(), snapshotObjects.end(), std::pair<int, GameObject*>(worldID, nullptr));
+	return (i != snapshotObjects.end() && i->first == worldID) ? i->second : nullptr;
+}
@@ -1,6 +1,17 @@
 #pragma once
 #include "GameWorld.h"
 #include "./CollisionDetection.h"
+#include "DynamicAABBTree.h"
+#include "StaticAABBTree.h"
+#include "SweepAndPrune.h"
+#include "PairCache.h"
+#include "NarrowPhaseBatch.h"
+#include "RigidBodyStore.h"
+#include "IslandGraph.h"
+#include "ContactSolver.h"
+#include "ConstraintSolver.h"
+#include "PhysicsProfiler.h"
+#include "JobSystem.h"
 
 namespace NCL {
 	namespace CSC8503 {
@@ -12,6 +23,14 @@ namespace NCL {
 
 			void Clear();
 
+			/*
+			Forgets everything held about an object that's leaving the world -
+			its cached pairs (without raising OnCollisionEnd for them), and its
+			broadphase proxy. The GameWorld calls this as the object is removed,
+			so nothing is left pointing at it once it's deleted.
+			*/
+			void RemoveObject(GameObject* o);
+
 			void Update(float dt);
 
 			void UseGravity(bool state) 
@@ -25,6 +44,141 @@ namespace NCL {
 			}
 
 			void SetGravity(const Vector3& g);
+
+			void UseBroadPhase(bool state) {
+				useBroadPhase = state;
+			}
+
+			bool UsingBroadPhase() const {
+				return useBroadPhase;
+			}
+
+			//Sweep and prune over sorted arrays, instead of the AABB tree
+			void UseSimpleContainer(bool state) {
+				useSimpleContainer = state;
+			}
+
+			bool UsingSimpleContainer() const {
+				return useSimpleContainer;
+			}
+
+			//Builds a QuadTree of every object from scratch each step instead, as the broadphase
+			//first did - it's slower than either of the others, and only kept to compare them to
+			void UseQuadTree(bool state) {
+				useQuadTree = state;
+			}
+
+			bool UsingQuadTree() const {
+				return useQuadTree;
+			}
+
+			void SetSolverIterations(int iterations) {
+				solverIterationCount = std::max(1, iterations);
+			}
+
+			int GetSolverIterations() const {
+				return solverIterationCount;
+			}
+
+			//Spreads the update across the pool's threads, or keeps it all on
+			//the calling thread if nullptr. Either way, the results are the same.
+			void SetJobSystem(JobSystem* j) {
+				jobs = j;
+			}
+
+			void AllowSleeping(bool state) {
+				allowSleeping = state;
+			}
+
+			//Islands whose bodies all stay under these speeds for 'time' seconds are put to sleep
+			void SetSleepThresholds(float linearSpeed, float angularSpeed, float time) {
+				sleepLinearSpeed	= linearSpeed;
+				sleepAngularSpeed	= angularSpeed;
+				sleepTime			= time;
+			}
+
+			//Static bodies count as sleeping once they've been still for long enough
+			int GetAwakeBodyCount() const {
+				return bodies.GetAwakeCount();
+			}
+
+			int GetSleepingBodyCount() const {
+				return bodies.Size() - bodies.GetAwakeCount();
+			}
+
+			PhysicsProfiler& GetProfiler() {
+				return profiler;
+			}
+
+			/*
+			Deterministic mode runs exactly one fixed step per Update, whatever dt
+			it's given, so where the simulation ends up only depends on how many
+			updates there have been, not how long the frames took. Contacts are
+			also solved in the order of their objects' world IDs, rather than the
+			order the broadphase finds them in - which depends on the shape its
+			tree has grown into, and so on everything that's happened before.
+			*/
+			void SetDeterministic(bool state) {
+				deterministic = state;
+			}
+
+			/*
+			Each Update runs however many fixed steps the time it's given owes,
+			but stops early once it has spent more than budget seconds on them,
+			or has run maxSteps. Whatever time is left owing then is dropped, so
+			the simulation runs slow for a moment, rather than trying to catch
+			up, taking even longer the next frame, and never recovering.
+			*/
+			void SetStepBudget(float budget, int maxSteps) {
+				stepBudget	= budget;
+				maxSubsteps	= maxSteps;
+			}
+
+			/*
+			Writes the state of every body, and the contact cache the solver warm
+			starts from, into buffer - objects are identified by world ID, so the
+			state can only be restored into the same world (or one built the same
+			way). Restoring puts everything back where it was, and rebuilds the
+			broadphase around it; in deterministic mode, stepping on from there
+			then gives exactly the same results as it did the first time.
+			Collision events aren't raised for pairs a restore starts or ends.
+			A snapshot that doesn't match the world (a different number of
+			bodies or constraints, or objects that have since gone) or that's
+			been cut short isn't restored at all, and false is returned.
+			*/
+			void SaveState(std::vector<char>& buffer);
+			bool RestoreState(const std::vector<char>& buffer);
+
+			//Bodies using continuous collision are only swept when they'd move further
+			//than this much of their smallest half size in a step
+			void SetContinuousThreshold(float fraction) {
+				continuousThreshold = fraction;
+			}
+
+			/*
+			Scene queries. These trace through the same trees the broadphase
+			uses, nearest first, so only ever look at objects close to the ray,
+			and stop as soon as nothing nearer can be found. Only objects on a
+			collision layer in layerMask can be hit.
+			*/
+			bool Raycast(const Ray& r, RayCollision& closestCollision, bool closestObject = true, GameObject* ignore = nullptr, unsigned int layerMask = ~0u);
+
+			//Finds the closest hit for every ray, tracing them through the trees a SIMD
+			//width at a time. Misses get a null node. Returns how many rays hit something
+			int RaycastBatch(const Ray* rays, int count, RayCollision* results, unsigned int layerMask = ~0u);
+
+			//Sweeps the volume from where the transform puts it, along dir (normalised) for up
+			//to maxDistance, and finds the first thing it would touch, and where
+			bool ShapeCast(const CollisionVolume& volume, const Transform& transform, const Vector3& dir, float maxDistance,
+				RayCollision& hit, GameObject* ignore = nullptr, unsigned int layerMask = ~0u);
+			bool SphereCast(const Vector3& origin, float radius, const Vector3& dir, float maxDistance,
+				RayCollision& hit, GameObject* ignore = nullptr, unsigned int layerMask = ~0u);
+
+			//Fills results with up to maxResults objects touching the volume, and returns how many
+			int Overlap(const CollisionVolume& volume, const Transform& transform, GameObject** results, int maxResults, unsigned int layerMask = ~0u);
+
+			//Fills results with the (up to) maxResults objects positioned closest to point, nearest first
+			int FindNearest(const Vector3& point, GameObject** results, int maxResults, float maxDistance = FLT_MAX, unsigned int layerMask = ~0u);
 		protected:
 			void BasicCollisionDetection();
 			void BroadPhase();
@@ -36,11 +190,50 @@ namespace NCL {
 			void IntegrateVelocity(float dt);
 
 			void UpdateConstraints(float dt);
+			void SolveIslands(float dt);
+			void WakeTouchedBodies();
+			void UpdateSleeping(float dt);
+			void FindFastBodies(float dt);
+			void SweepFastBodies();
+			bool IsResting(const GameObject* o) const;
+
+			void ParallelFor(int count, int grainSize, const RangeJob& func);
+			int  GetBodyIndex(const GameObject* o, bool& isStatic) const;
 
 			void UpdateCollisionList();
+			int  AddCollision(const CollisionDetection::CollisionInfo& info);
 			void UpdateObjectAABBs();
+			void SyncBroadphase();
+			void SyncStaticLayer();
+			template<typename F>
+			void QueryStaticLayer(GameObject* o, F&& func) const;
+			void SyncBodies();
+			void UpdateQueryTrees();
+			void TracePacket(const Ray* rays, int count, RayCollision* results, unsigned int layerMask) const;
+			void SortContacts();
+			void SavePairs(const PairCache& pairs, std::vector<char>& buffer) const;
+			void RestorePairs(PairCache& pairs, int first, int count) const;
+			GameObject* FindSnapshotObject(int worldID) const;
 
-			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
+			struct SnapshotHeader {
+				int				bodyCount;
+				int				collisionCount;
+				int				separatedCount;
+				int				constraintCount;
+				float			timeOffset;
+				unsigned int	randomState;
+			};
+			struct SnapshotBody {
+				int		worldID;
+				int		awake;
+				float	state[RigidBodyStore::StateChannelCount];
+			};
+			struct SnapshotPair {
+				int		worldIDA;
+				int		worldIDB;
+				int		isNew;
+				CollisionDetection::CollisionInfo info;	//Object pointers are meaningless once saved
+			};
 
 			GameWorld& gameWorld;
 
@@ -48,11 +241,74 @@ namespace NCL {
 			Vector3 gravity;
 			float	dTOffset;
 			float	globalDamping;
-			std::set<CollisionDetection::CollisionInfo>		allCollisions;
-			std::set<CollisionDetection::CollisionInfo>		broadphaseCollisions;
+			PairCache										allCollisions;
+			PairCache										broadphaseCollisions;
 			std::vector<CollisionDetection::CollisionInfo>	broadphaseCollisionsVec;
 			bool	useBroadPhase		= true;
+			bool	useSimpleContainer	= false;
+			bool	useQuadTree			= false;
 			int		numCollisionFrames	= 5;
+			int		solverIterationCount;
+
+			DynamicAABBTree<GameObject*>	broadphaseTree;
+			std::vector<GameObject*>		broadphaseDynamics;
+			std::vector<int>				broadphaseProxyStamps;
+			int								broadphaseStamp;
+			int								broadphaseWorldState;
+
+			SweepAndPrune<GameObject*>		sweepAndPrune;
+			int								queryTreeVersion = -1;	//Body store version the tree was last brought up to for queries
+
+			//The world's static objects, rebuilt only when they change
+			StaticAABBTree<GameObject*>		staticTree;
+			int								staticWorldState = -1;
+
+			NarrowPhaseBatch				narrowPhaseBatch;
+			std::vector<int>				narrowPhasePairs;	//Broadphase pairs the batch can't take
+			std::vector<char>				narrowPhaseHits;
+			std::vector<CollisionDetection::CollisionInfo> narrowPhaseResults;
+			PairCache						separatingAxes;		//Pairs that missed recently, and the axis that separated them
+
+			//Contacts found this step, waiting to be resolved island by island
+			std::vector<CollisionDetection::CollisionInfo> stepContacts;
+			std::vector<int>				stepManifolds;	//Where each contact's manifold is in allCollisions
+			ContactSolver					contactSolver;
+			ConstraintSolver				constraintSolver;
+			std::vector<Constraint*>		stepConstraints;
+			std::vector<Constraint*>		freeConstraints;
+			std::vector<int>				islandItemBodies;
+			IslandGraph						islands;
+
+			JobSystem*						jobs = nullptr;
+			PhysicsProfiler					profiler;
+
+			bool							allowSleeping		= true;
+			float							sleepLinearSpeed	= 0.05f;
+			float							sleepAngularSpeed	= 0.05f;
+			float							sleepTime			= 0.5f;
+			std::vector<float>				islandSleepTimes;
+			std::vector<PhysicsObject*>		sleepers;
+
+			RigidBodyStore					bodies;
+			int								bodyWorldState;
+
+			//Bodies that asked for continuous collision, and those of them moving fast enough to need it this step
+			struct FastBody {
+				GameObject* object;
+				Vector3		start;
+			};
+			std::vector<GameObject*>		continuousBodies;
+			std::vector<FastBody>			fastBodies;
+			float							continuousThreshold	= 0.5f;	//Of a body's smallest half size, per step
+			float							continuousSlop		= 0.01f;	//How far into what it hits a swept body is left
+
+			bool							deterministic = false;
+			float							stepBudget	= 0.008f;
+			int								maxSubsteps	= 8;
+			std::vector<std::pair<int, GameObject*>> snapshotObjects;	//Sorted by world ID, to match saved objects back up
+			std::vector<SnapshotBody>		snapshotBodies;	//A snapshot is read into these in full before any of it is restored
+			std::vector<SnapshotPair>		snapshotPairs;
+			std::vector<Vector3>			snapshotImpulses;
 		};
 	}
 }
@@ -55,71 +55,13 @@
 //}
 //
 #include "PositionConstraint.h"
-#include "GameObject.h"
-#include "PhysicsObject.h"
-#include "Transform.h"
 
 using namespace NCL;
-using namespace NCL::Maths;
 using namespace NCL::CSC8503;
 
-PositionConstraint::PositionConstraint(GameObject* a, GameObject* b, float d) {
-	objectA = a;
-	objectB = b;
-	distance = d;
+PositionConstraint::PositionConstraint(GameObject* a, GameObject* b, float d) : Constraint(ConstraintType::Distance) {
+	objectA		= a;
+	objectB		= b;
+	distance	= d;
+	impulse		= 0.0f;
 }
-
-// a simple constraint that stops objects from being more than <distance> away
-// from each other...this would be all we need to simulate a rope, or a ragdoll
-void PositionConstraint::UpdateConstraint(float dt) {
-	if (!objectA || !objectB) {
-		return;
-	}
-
-	Vector3 relativePos =
-		objectA->GetTransform().GetPosition() -
-		objectB->GetTransform().GetPosition();
-
-	// ǰ֮ľ
-	float currentDistance = Vector::Length(relativePos);
-	float offset = distance - currentDistance;
-
-	// Ѿڡ롱ϣͲù
-	if (std::abs(offset) > 0.0f) {
-		Vector3 offsetDir = Vector::Normalise(relativePos);
-
-		PhysicsObject* physA = objectA->GetPhysicsObject();
-		PhysicsObject* physB = objectB->GetPhysicsObject();
-
-		if (!physA || !physB) {
-			return;
-		}
-
-		Vector3 relativeVelocity =
-			physA->GetLinearVelocity() -
-			physB->GetLinearVelocity();
-
-		float constraintMass =
-			physA->GetInverseMass() +
-			physB->GetInverseMass();
-
-		if (constraintMass > 0.0f) {
-			// ٶԼϵķ
-			float velocityDot = Vector::Dot(relativeVelocity, offsetDir);
-
-			// Baumgarte biasֹԼ
-			float biasFactor = 0.01f;
-			float bias = -(biasFactor / dt) * offset;
-
-			//  lambda
-			float lambda = -(velocityDot + bias) / constraintMass;
-
-			Vector3 aImpulse = offsetDir * lambda;
-			Vector3 bImpulse = -offsetDir * lambda;
-
-			physA->ApplyLinearImpulse(aImpulse);
-			physB->ApplyLinearImpulse(bImpulse);
-		}
-	}
-}
-
@@ -33,19 +33,35 @@ namespace NCL {
 	namespace CSC8503 {
 		class GameObject;
 
+		/*
+		Keeps the centres of two objects a fixed distance apart - all a chain
+		or rope bridge needs. Solved in bulk by the ConstraintSolver.
+		*/
 		class PositionConstraint : public Constraint {
+			friend class ConstraintSolver;
 		public:
 			// ֻҪд
 			PositionConstraint(GameObject* a, GameObject* b, float d);
 			~PositionConstraint() override = default;
 
-			void UpdateConstraint(float dt) override;
+			GameObject* GetObjectA() const override {
+				return objectA;
+			}
+
+			GameObject* GetObjectB() const override {
+				return objectB;
+			}
+
+			float GetDistance() const {
+				return distance;
+			}
 
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
 
 			float distance;
+			float impulse;	//Built up by the solver, and carried across steps to warm start it
 		};
 	}
 }
\ No newline at end of file
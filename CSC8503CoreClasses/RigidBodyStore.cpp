@@ -0,0 +1,419 @@
+#include "RigidBodyStore.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "Transform.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Position then orientation, in both the current and previous state
+	const int PoseChannelCount = 7;
+}
+
+RigidBodyStore::RigidBodyStore() {
+	syncStamp	= 0;
+	version		= 0;
+	awakeCount	= 0;
+
+	interpolation = 1.0f;
+}
+
+RigidBodyStore::~RigidBodyStore() {
+	Clear();
+}
+
+int RigidBodyStore::Add(PhysicsObject* object, Transform* transform) {
+	int index = Size();
+	for (int c = 0; c < ChannelCount; ++c) {
+		channels[c].emplace_back(0.0f);
+	}
+	objects.emplace_back(object);
+	transforms.emplace_back(transform);
+	syncStamps.emplace_back(syncStamp);
+
+	SetVector(PositionX, index, transform->position);
+	SetOrientation(index, transform->orientation);
+
+	SetVector(LinearVelX,		index, object->linearVelocity);
+	SetVector(AngularVelX,		index, object->angularVelocity);
+	SetVector(ForceX,			index, object->force);
+	SetVector(TorqueX,			index, object->torque);
+	SetVector(InverseInertiaX,	index, object->inverseInertia);
+	channels[InverseMass][index] = object->inverseMass;
+	UpdateInertiaTensor(index);
+	ResetPreviousState(index);
+
+	object->store		= this;
+	object->storeIndex	= index;
+	transform->store		= this;
+	transform->storeIndex	= index;
+	transform->matrixDirty	= true;
+
+	//New bodies start off awake
+	if (index != awakeCount) {
+		SwapBodies(index, awakeCount);
+	}
+	return awakeCount++;
+}
+
+//Hands the latest state back to the objects, and unbinds them
+void RigidBodyStore::CopyOut(int index) {
+	PhysicsObject*	object		= objects[index];
+	Transform*		transform	= transforms[index];
+
+	transform->position		= GetVector(PositionX, index);
+	transform->orientation	= GetOrientation(index);
+	transform->store		= nullptr;
+	transform->storeIndex	= -1;
+	transform->matrixDirty	= true;
+
+	object->linearVelocity	= GetVector(LinearVelX, index);
+	object->angularVelocity	= GetVector(AngularVelX, index);
+	object->force			= GetVector(ForceX, index);
+	object->torque			= GetVector(TorqueX, index);
+	object->inverseInertia	= GetVector(InverseInertiaX, index);
+	object->inverseMass		= channels[InverseMass][index];
+	object->inverseInteriaTensor = GetInertiaTensor(index);
+	object->store			= nullptr;
+	object->storeIndex		= -1;
+}
+
+void RigidBodyStore::MoveBody(int from, int to) {
+	for (int c = 0; c < ChannelCount; ++c) {
+		channels[c][to] = channels[c][from];
+	}
+	objects[to]		= objects[from];
+	transforms[to]	= transforms[from];
+	syncStamps[to]	= syncStamps[from];
+
+	objects[to]->storeIndex		= to;
+	transforms[to]->storeIndex	= to;
+}
+
+void RigidBodyStore::SwapBodies(int a, int b) {
+	for (int c = 0; c < ChannelCount; ++c) {
+		std::swap(channels[c][a], channels[c][b]);
+	}
+	std::swap(objects[a], objects[b]);
+	std::swap(transforms[a], transforms[b]);
+	std::swap(syncStamps[a], syncStamps[b]);
+
+	objects[a]->storeIndex		= a;
+	transforms[a]->storeIndex	= a;
+	objects[b]->storeIndex		= b;
+	transforms[b]->storeIndex	= b;
+}
+
+/*
+An awake body's slot is filled by the last awake body, which leaves a gap at
+the start of the sleeping bodies - that's then filled by the very last body.
+*/
+void RigidBodyStore::Remove(int index) {
+	CopyOut(index);
+	if (index < awakeCount) {
+		awakeCount--;
+		if (index != awakeCount) {
+			MoveBody(awakeCount, index);
+		}
+		index = awakeCount;
+	}
+	int last = Size() - 1;
+	if (index != last) {
+		MoveBody(last, index);
+	}
+	for (int c = 0; c < ChannelCount; ++c) {
+		channels[c].pop_back();
+	}
+	objects.pop_back();
+	transforms.pop_back();
+	syncStamps.pop_back();
+}
+
+void RigidBodyStore::Clear() {
+	for (int i = 0; i < Size(); ++i) {
+		CopyOut(i);
+	}
+	for (int c = 0; c < ChannelCount; ++c) {
+		channels[c].clear();
+	}
+	objects.clear();
+	transforms.clear();
+	syncStamps.clear();
+	awakeCount = 0;
+}
+
+void RigidBodyStore::SetAwake(int index, bool awake) {
+	if (awake == IsAwake(index)) {
+		return;
+	}
+	if (awake) {
+		SwapBodies(index, awakeCount);
+		index = awakeCount++;
+		channels[SleepTime][index] = 0.0f;
+		//Might have been turned by hand while asleep
+		UpdateInertiaTensor(index);
+	}
+	else {
+		awakeCount--;
+		SwapBodies(index, awakeCount);
+		index = awakeCount;
+		SetVector(LinearVelX,	index, Vector3());
+		SetVector(AngularVelX,	index, Vector3());
+		//Asleep, it should be drawn exactly where it stopped
+		ResetPreviousState(index);
+	}
+}
+
+/*
+Deleted objects unbind themselves as they are destroyed, so anything left in
+the store that isn't stamped here is still alive, just no longer in the world.
+*/
+void RigidBodyStore::Sync(GameObjectIterator first, GameObjectIterator last) {
+	syncStamp++;
+	for (auto i = first; i != last; ++i) {
+		PhysicsObject* object = (*i)->GetPhysicsObject();
+		if (!object) {
+			continue;
+		}
+		if (object->store != this) {
+			if (object->store) {
+				object->store->Remove(object->storeIndex);
+			}
+			Add(object, &(*i)->GetTransform());
+		}
+		syncStamps[object->storeIndex] = syncStamp;
+	}
+	//Walk backwards, so the body swapped into a removed slot has already been checked
+	for (int i = Size() - 1; i >= 0; --i) {
+		if (syncStamps[i] != syncStamp) {
+			Remove(i);
+		}
+	}
+}
+
+Quaternion RigidBodyStore::GetOrientation(int index, Channel first) const {
+	return Quaternion(channels[first][index], channels[first + 1][index],
+		channels[first + 2][index], channels[first + 3][index]);
+}
+
+void RigidBodyStore::SetOrientation(int index, const Quaternion& q, Channel first) {
+	channels[first][index]		= q.x;
+	channels[first + 1][index]	= q.y;
+	channels[first + 2][index]	= q.z;
+	channels[first + 3][index]	= q.w;
+}
+
+void RigidBodyStore::StorePreviousState(int first, int last) {
+	for (int c = 0; c < PoseChannelCount; ++c) {
+		std::copy(channels[PositionX + c].begin() + first, channels[PositionX + c].begin() + last,
+			channels[PreviousPositionX + c].begin() + first);
+	}
+}
+
+void RigidBodyStore::ResetPreviousState(int index) {
+	for (int c = 0; c < PoseChannelCount; ++c) {
+		channels[PreviousPositionX + c][index] = channels[PositionX + c][index];
+	}
+}
+
+Vector3 RigidBodyStore::GetInterpolatedPosition(int index) const {
+	Vector3 previous	= GetVector(PreviousPositionX, index);
+	Vector3 current		= GetVector(PositionX, index);
+	return previous + (current - previous) * interpolation;
+}
+
+Quaternion RigidBodyStore::GetInterpolatedOrientation(int index) const {
+	Quaternion q = Quaternion::Lerp(GetOrientation(index, PreviousOrientationX), GetOrientation(index), interpolation);
+	q.Normalise();
+	return q;
+}
+
+Matrix3 RigidBodyStore::GetInertiaTensor(int index) const {
+	Matrix3 m;
+	m.array[0][0] = channels[TensorXX][index];
+	m.array[1][1] = channels[TensorYY][index];
+	m.array[2][2] = channels[TensorZZ][index];
+	m.array[0][1] = m.array[1][0] = channels[TensorXY][index];
+	m.array[0][2] = m.array[2][0] = channels[TensorXZ][index];
+	m.array[1][2] = m.array[2][1] = channels[TensorYZ][index];
+	return m;
+}
+
+/*
+The world space inverse inertia tensor is R * I * R^T, where R is the rotation
+matrix of the body's orientation, and I is its diagonal local inverse inertia.
+Written out per element, so that the loop over all bodies can be vectorised.
+*/
+void RigidBodyStore::UpdateInertiaTensors(int first, int last) {
+	const float* __restrict qx = channels[OrientationX].data();
+	const float* __restrict qy = channels[OrientationY].data();
+	const float* __restrict qz = channels[OrientationZ].data();
+	const float* __restrict qw = channels[OrientationW].data();
+	const float* __restrict ix = channels[InverseInertiaX].data();
+	const float* __restrict iy = channels[InverseInertiaY].data();
+	const float* __restrict iz = channels[InverseInertiaZ].data();
+
+	float* __restrict txx = channels[TensorXX].data();
+	float* __restrict tyy = channels[TensorYY].data();
+	float* __restrict tzz = channels[TensorZZ].data();
+	float* __restrict txy = channels[TensorXY].data();
+	float* __restrict txz = channels[TensorXZ].data();
+	float* __restrict tyz = channels[TensorYZ].data();
+
+	for (int i = first; i < last; ++i) {
+		float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+		//Rows of the rotation matrix (matching Quaternion::RotationMatrix)
+		float r00 = 1 - 2 * (y * y + z * z), r01 = 2 * (x * y - z * w), r02 = 2 * (x * z + y * w);
+		float r10 = 2 * (x * y + z * w), r11 = 1 - 2 * (x * x + z * z), r12 = 2 * (y * z - x * w);
+		float r20 = 2 * (x * z - y * w), r21 = 2 * (y * z + x * w), r22 = 1 - 2 * (x * x + y * y);
+
+		txx[i] = r00 * r00 * ix[i] + r01 * r01 * iy[i] + r02 * r02 * iz[i];
+		tyy[i] = r10 * r10 * ix[i] + r11 * r11 * iy[i] + r12 * r12 * iz[i];
+		tzz[i] = r20 * r20 * ix[i] + r21 * r21 * iy[i] + r22 * r22 * iz[i];
+		txy[i] = r00 * r10 * ix[i] + r01 * r11 * iy[i] + r02 * r12 * iz[i];
+		txz[i] = r00 * r20 * ix[i] + r01 * r21 * iy[i] + r02 * r22 * iz[i];
+		tyz[i] = r10 * r20 * ix[i] + r11 * r21 * iy[i] + r12 * r22 * iz[i];
+	}
+}
+
+void RigidBodyStore::UpdateInertiaTensor(int index) {
+	Quaternion	q	= GetOrientation(index);
+	Vector3		inv = GetVector(InverseInertiaX, index);
+
+	Matrix3 m = Quaternion::RotationMatrix<Matrix3>(q) * Matrix::Scale3x3(inv) *
+		Quaternion::RotationMatrix<Matrix3>(q.Conjugate());
+
+	channels[TensorXX][index] = m.array[0][0];
+	channels[TensorYY][index] = m.array[1][1];
+	channels[TensorZZ][index] = m.array[2][2];
+	channels[TensorXY][index] = m.array[1][0];
+	channels[TensorXZ][index] = m.array[2][0];
+	channels[TensorYZ][index] = m.array[2][1];
+}
+
+void RigidBodyStore::IntegrateAccel(float dt, const Vector3& gravity, int first, int last) {
+	UpdateInertiaTensors(first, last);
+
+	float* __restrict lvx = channels[LinearVelX].data();
+	float* __restrict lvy = channels[LinearVelY].data();
+	float* __restrict lvz = channels[LinearVelZ].data();
+	float* __restrict avx = channels[AngularVelX].data();
+	float* __restrict avy = channels[AngularVelY].data();
+	float* __restrict avz = channels[AngularVelZ].data();
+
+	const float* __restrict fx = channels[ForceX].data();
+	const float* __restrict fy = channels[ForceY].data();
+	const float* __restrict fz = channels[ForceZ].data();
+	const float* __restrict tx = channels[TorqueX].data();
+	const float* __restrict ty = channels[TorqueY].data();
+	const float* __restrict tz = channels[TorqueZ].data();
+	const float* __restrict im = channels[InverseMass].data();
+
+	const float* __restrict txx = channels[TensorXX].data();
+	const float* __restrict tyy = channels[TensorYY].data();
+	const float* __restrict tzz = channels[TensorZZ].data();
+	const float* __restrict txy = channels[TensorXY].data();
+	const float* __restrict txz = channels[TensorXZ].data();
+	const float* __restrict tyz = channels[TensorYZ].data();
+
+	for (int i = first; i < last; ++i) {
+		float g = im[i] > 0.0f ? dt : 0.0f; // Don't move infinitely heavy things
+		lvx[i] += fx[i] * im[i] * dt + gravity.x * g;
+		lvy[i] += fy[i] * im[i] * dt + gravity.y * g;
+		lvz[i] += fz[i] * im[i] * dt + gravity.z * g;
+
+		avx[i] += (txx[i] * tx[i] + txy[i] * ty[i] + txz[i] * tz[i]) * dt;
+		avy[i] += (txy[i] * tx[i] + tyy[i] * ty[i] + tyz[i] * tz[i]) * dt;
+		avz[i] += (txz[i] * tx[i] + tyz[i] * ty[i] + tzz[i] * tz[i]) * dt;
+	}
+}
+
+void RigidBodyStore::IntegrateVelocity(float dt, float damping, int first, int last) {
+	float* __restrict px = channels[PositionX].data();
+	float* __restrict py = channels[PositionY].data();
+	float* __restrict pz = channels[PositionZ].data();
+	float* __restrict qx = channels[OrientationX].data();
+	float* __restrict qy = channels[OrientationY].data();
+	float* __restrict qz = channels[OrientationZ].data();
+	float* __restrict qw = channels[OrientationW].data();
+
+	float* __restrict lvx = channels[LinearVelX].data();
+	float* __restrict lvy = channels[LinearVelY].data();
+	float* __restrict lvz = channels[LinearVelZ].data();
+	float* __restrict avx = channels[AngularVelX].data();
+	float* __restrict avy = channels[AngularVelY].data();
+	float* __restrict avz = channels[AngularVelZ].data();
+
+	float halfDt = dt * 0.5f;
+
+	for (int i = first; i < last; ++i) {
+		px[i] += lvx[i] * dt;
+		py[i] += lvy[i] * dt;
+		pz[i] += lvz[i] * dt;
+
+		lvx[i] *= damping;
+		lvy[i] *= damping;
+		lvz[i] *= damping;
+
+		//q += (angVel * dt * 0.5, 0) * q
+		float hx = avx[i] * halfDt, hy = avy[i] * halfDt, hz = avz[i] * halfDt;
+		float ox = qx[i], oy = qy[i], oz = qz[i], ow = qw[i];
+
+		float x = ox + (hx * ow) + (hy * oz) - (hz * oy);
+		float y = oy + (hy * ow) + (hz * ox) - (hx * oz);
+		float z = oz + (hz * ow) + (hx * oy) - (hy * ox);
+		float w = ow - (hx * ox) - (hy * oy) - (hz * oz);
+
+		float sqLength	= x * x + y * y + z * z + w * w;
+		float scale		= sqLength > 0.0f ? 1.0f / std::sqrt(sqLength) : 1.0f;
+		qx[i] = x * scale;
+		qy[i] = y * scale;
+		qz[i] = z * scale;
+		qw[i] = w * scale;
+
+		avx[i] *= damping;
+		avy[i] *= damping;
+		avz[i] *= damping;
+	}
+}
+
+void RigidBodyStore::UpdateSleepTimes(float dt, float linearSpeed, float angularSpeed, int first, int last) {
+	const float* __restrict lvx = channels[LinearVelX].data();
+	const float* __restrict lvy = channels[LinearVelY].data();
+	const float* __restrict lvz = channels[LinearVelZ].data();
+	const float* __restrict avx = channels[AngularVelX].data();
+	const float* __restrict avy = channels[AngularVelY].data();
+	const float* __restrict avz = channels[AngularVelZ].data();
+
+	float* __restrict st = channels[SleepTime].data();
+
+	float linearSq	= linearSpeed * linearSpeed;
+	float angularSq	= angularSpeed * angularSpeed;
+
+	for (int i = first; i < last; ++i) {
+		float l = lvx[i] * lvx[i] + lvy[i] * lvy[i] + lvz[i] * lvz[i];
+		float a = avx[i] * avx[i] + avy[i] * avy[i] + avz[i] * avz[i];
+		st[i] = (l < linearSq && a < angularSq) ? st[i] + dt : 0.0f;
+	}
+}
+
+void RigidBodyStore::SaveState(int index, float* state) const {
+	for (int c = 0; c < StateChannelCount; ++c) {
+		state[c] = channels[c][index];
+	}
+}
+
+void RigidBodyStore::LoadState(int index, const float* state) {
+	for (int c = 0; c < StateChannelCount; ++c) {
+		channels[c][index] = state[c];
+	}
+	UpdateInertiaTensor(index);
+	ResetPreviousState(index);
+}
+
+void RigidBodyStore::ClearForces() {
+	for (int c = ForceX; c <= TorqueZ; ++c) {
+		std::fill(channels[c].begin(), channels[c].end(), 0.0f);
+	}
+}
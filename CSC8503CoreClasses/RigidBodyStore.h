@@ -0,0 +1,174 @@
+#pragma once
+#include "GameWorld.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class PhysicsObject;
+		class Transform;
+
+		/*
+		Holds the state the integrator needs for every physics object in the
+		world as a structure of arrays - each component (position x, linear
+		velocity y etc) lives in its own contiguous array of floats. This lets
+		the integration steps be written as simple loops over arrays, rather
+		than chasing GameObject / PhysicsObject / Transform pointers.
+
+		PhysicsObjects and Transforms that have been added here are 'bound',
+		and read and write their state through the store until removed again,
+		at which point the latest values are copied back into them.
+
+		Awake bodies are kept at the front of the arrays, and sleeping ones at
+		the back, so the integration loops only have to run over the first
+		GetAwakeCount() bodies. Waking or sleeping a body swaps it across that
+		boundary, so changes the index of whichever body it swaps with.
+		*/
+		class RigidBodyStore {
+		public:
+			enum Channel {
+				PositionX, PositionY, PositionZ,
+				OrientationX, OrientationY, OrientationZ, OrientationW,
+				LinearVelX, LinearVelY, LinearVelZ,
+				AngularVelX, AngularVelY, AngularVelZ,
+				ForceX, ForceY, ForceZ,
+				TorqueX, TorqueY, TorqueZ,
+				InverseMass,
+				SleepTime,	//How long the body has been moving slowly enough to sleep
+				InverseInertiaX, InverseInertiaY, InverseInertiaZ,
+				//World space inverse inertia tensor - symmetric, so only 6 values
+				TensorXX, TensorYY, TensorZZ, TensorXY, TensorXZ, TensorYZ,
+				//Where the body was before the latest step, for rendering between the two
+				PreviousPositionX, PreviousPositionY, PreviousPositionZ,
+				PreviousOrientationX, PreviousOrientationY, PreviousOrientationZ, PreviousOrientationW,
+				ChannelCount
+			};
+			//Everything up to here can change as the simulation runs - the rest is fixed, or worked out from it
+			static const int StateChannelCount = SleepTime + 1;
+
+			RigidBodyStore();
+			~RigidBodyStore();
+
+			int		Add(PhysicsObject* object, Transform* transform);
+			void	Remove(int index);
+			void	Clear();
+
+			//Binds any objects with physics that aren't in the store yet, and
+			//removes any bodies that are no longer in the given range
+			void	Sync(GameObjectIterator first, GameObjectIterator last);
+
+			int Size() const {
+				return (int)objects.size();
+			}
+
+			//Goes up every time the integrator moves the bodies
+			int GetVersion() const {
+				return version;
+			}
+
+			int GetAwakeCount() const {
+				return awakeCount;
+			}
+
+			bool IsAwake(int index) const {
+				return index < awakeCount;
+			}
+
+			//Sleeping bodies have their velocities zeroed, waking ones their sleep time
+			void SetAwake(int index, bool awake);
+
+			void IntegrateAccel(float dt, const Vector3& gravity) {
+				IntegrateAccel(dt, gravity, 0, awakeCount);
+			}
+			void IntegrateVelocity(float dt, float damping) {
+				IntegrateVelocity(dt, damping, 0, awakeCount);
+				IncrementVersion();
+			}
+			void UpdateInertiaTensors() {
+				UpdateInertiaTensors(0, Size());
+			}
+			void ClearForces();
+
+			//These only touch bodies [first, last), so separate ranges can be worked
+			//on by separate threads. Once all of the ranges have been integrated,
+			//IncrementVersion must be called, so transforms know they have moved
+			void IntegrateAccel(float dt, const Vector3& gravity, int first, int last);
+			void IntegrateVelocity(float dt, float damping, int first, int last);
+			void UpdateInertiaTensors(int first, int last);
+
+			//Copies the position and orientation of bodies [first, last) into their previous state, ready to step
+			void StorePreviousState(int first, int last);
+			//Makes the body's previous state match where it is now, so it isn't blended from anywhere
+			void ResetPreviousState(int index);
+
+			/*
+			How far the world is between the previous state and the current one,
+			from 0 to 1 - the time left over after the last step, as a fraction
+			of a step. Rendering blends by this, so bodies move smoothly whatever
+			the display rate, at the cost of showing them up to a step behind.
+			*/
+			void SetInterpolation(float alpha) {
+				interpolation = alpha;
+			}
+
+			float GetInterpolation() const {
+				return interpolation;
+			}
+
+			Vector3		GetInterpolatedPosition(int index) const;
+			Quaternion	GetInterpolatedOrientation(int index) const;
+
+			//Adds dt to the sleep time of bodies moving slower than the given speeds, and resets the rest
+			void UpdateSleepTimes(float dt, float linearSpeed, float angularSpeed, int first, int last);
+
+			void IncrementVersion() {
+				version++;
+			}
+
+			float& Get(Channel c, int index) {
+				return channels[c][index];
+			}
+
+			float Get(Channel c, int index) const {
+				return channels[c][index];
+			}
+
+			Vector3 GetVector(Channel first, int index) const {
+				return Vector3(channels[first][index], channels[first + 1][index], channels[first + 2][index]);
+			}
+
+			void SetVector(Channel first, int index, const Vector3& v) {
+				channels[first][index]		= v.x;
+				channels[first + 1][index]	= v.y;
+				channels[first + 2][index]	= v.z;
+			}
+
+			//Copies a body's StateChannelCount changing channels out to, or in from, state
+			void		SaveState(int index, float* state) const;
+			void		LoadState(int index, const float* state);
+
+			Quaternion	GetOrientation(int index, Channel first = OrientationX) const;
+			void		SetOrientation(int index, const Quaternion& q, Channel first = OrientationX);
+
+			Matrix3		GetInertiaTensor(int index) const;
+			void		UpdateInertiaTensor(int index);
+
+			PhysicsObject* GetPhysicsObject(int index) const {
+				return objects[index];
+			}
+
+		protected:
+			void MoveBody(int from, int to);
+			void SwapBodies(int a, int b);
+			void CopyOut(int index);
+
+			std::vector<float>			channels[ChannelCount];
+			std::vector<PhysicsObject*>	objects;
+			std::vector<Transform*>		transforms;
+			std::vector<int>			syncStamps;
+
+			int		syncStamp;
+			int		version;
+			int		awakeCount;
+			float	interpolation;
+		};
+	}
+}
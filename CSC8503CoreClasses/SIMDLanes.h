@@ -0,0 +1,78 @@
+#pragma once
+#include "SIMD.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Kernels that work on many things at once are written against this small
+		set of lane operations, which map onto 8 wide AVX2 registers, 4 wide SSE
+		registers, or (with NCL_MATHS_SCALAR defined) plain floats.
+		*/
+#if defined(NCL_MATHS_AVX2)
+		typedef __m256	Lane;
+		typedef __m256	LaneMask;
+		const int LaneWidth = 8;
+
+		inline Lane		LaneLoad(const float* p)				{ return _mm256_loadu_ps(p); }
+		inline void		LaneStore(float* p, Lane v)				{ _mm256_storeu_ps(p, v); }
+		inline Lane		LaneSplat(float f)						{ return _mm256_set1_ps(f); }
+		inline Lane		LaneAdd(Lane a, Lane b)					{ return _mm256_add_ps(a, b); }
+		inline Lane		LaneSub(Lane a, Lane b)					{ return _mm256_sub_ps(a, b); }
+		inline Lane		LaneMul(Lane a, Lane b)					{ return _mm256_mul_ps(a, b); }
+		inline Lane		LaneDiv(Lane a, Lane b)					{ return _mm256_div_ps(a, b); }
+		inline Lane		LaneSqrt(Lane a)						{ return _mm256_sqrt_ps(a); }
+		inline Lane		LaneMin(Lane a, Lane b)					{ return _mm256_min_ps(a, b); }
+		inline Lane		LaneMax(Lane a, Lane b)					{ return _mm256_max_ps(a, b); }
+		inline Lane		LaneAbs(Lane a)							{ return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		inline LaneMask	LaneLess(Lane a, Lane b)				{ return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		inline LaneMask	LaneAnd(LaneMask a, LaneMask b)			{ return _mm256_and_ps(a, b); }
+		inline Lane		LaneSelect(Lane a, Lane b, LaneMask m)	{ return _mm256_blendv_ps(a, b, m); }
+		inline int		LaneBits(LaneMask m)					{ return _mm256_movemask_ps(m); }
+#elif defined(NCL_MATHS_SSE)
+		typedef __m128	Lane;
+		typedef __m128	LaneMask;
+		const int LaneWidth = 4;
+
+		inline Lane		LaneLoad(const float* p)				{ return _mm_loadu_ps(p); }
+		inline void		LaneStore(float* p, Lane v)				{ _mm_storeu_ps(p, v); }
+		inline Lane		LaneSplat(float f)						{ return _mm_set1_ps(f); }
+		inline Lane		LaneAdd(Lane a, Lane b)					{ return _mm_add_ps(a, b); }
+		inline Lane		LaneSub(Lane a, Lane b)					{ return _mm_sub_ps(a, b); }
+		inline Lane		LaneMul(Lane a, Lane b)					{ return _mm_mul_ps(a, b); }
+		inline Lane		LaneDiv(Lane a, Lane b)					{ return _mm_div_ps(a, b); }
+		inline Lane		LaneSqrt(Lane a)						{ return _mm_sqrt_ps(a); }
+		inline Lane		LaneMin(Lane a, Lane b)					{ return _mm_min_ps(a, b); }
+		inline Lane		LaneMax(Lane a, Lane b)					{ return _mm_max_ps(a, b); }
+		inline Lane		LaneAbs(Lane a)							{ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		inline LaneMask	LaneLess(Lane a, Lane b)				{ return _mm_cmplt_ps(a, b); }
+		inline LaneMask	LaneAnd(LaneMask a, LaneMask b)			{ return _mm_and_ps(a, b); }
+		inline Lane		LaneSelect(Lane a, Lane b, LaneMask m)	{ return _mm_or_ps(_mm_and_ps(m, b), _mm_andnot_ps(m, a)); }
+		inline int		LaneBits(LaneMask m)					{ return _mm_movemask_ps(m); }
+#else
+		typedef float	Lane;
+		typedef bool	LaneMask;
+		const int LaneWidth = 1;
+
+		inline Lane		LaneLoad(const float* p)				{ return *p; }
+		inline void		LaneStore(float* p, Lane v)				{ *p = v; }
+		inline Lane		LaneSplat(float f)						{ return f; }
+		inline Lane		LaneAdd(Lane a, Lane b)					{ return a + b; }
+		inline Lane		LaneSub(Lane a, Lane b)					{ return a - b; }
+		inline Lane		LaneMul(Lane a, Lane b)					{ return a * b; }
+		inline Lane		LaneDiv(Lane a, Lane b)					{ return a / b; }
+		inline Lane		LaneSqrt(Lane a)						{ return std::sqrt(a); }
+		inline Lane		LaneMin(Lane a, Lane b)					{ return b < a ? b : a; }
+		inline Lane		LaneMax(Lane a, Lane b)					{ return a < b ? b : a; }
+		inline Lane		LaneAbs(Lane a)							{ return std::abs(a); }
+		inline LaneMask	LaneLess(Lane a, Lane b)				{ return a < b; }
+		inline LaneMask	LaneAnd(LaneMask a, LaneMask b)			{ return a && b; }
+		inline Lane		LaneSelect(Lane a, Lane b, LaneMask m)	{ return m ? b : a; }
+		inline int		LaneBits(LaneMask m)					{ return m ? 1 : 0; }
+#endif
+
+		//1 / length, or 0 for zero length vectors, as Vector::Normalise does
+		inline Lane LaneSafeReciprocal(Lane length) {
+			return LaneSelect(LaneSplat(0.0f), LaneDiv(LaneSplat(1.0f), length), LaneLess(LaneSplat(0.0f), length));
+		}
+	}
+}
@@ -0,0 +1,2 @@
+#include "StaticAABBTree.h"
+using namespace NCL;
@@ -0,0 +1,331 @@
+#pragma once
+#include <cfloat>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A bounding volume hierarchy for objects that never move. Everything is
+		added up front, then the tree is built once, top down, splitting each
+		node's objects in half along the axis they are most spread out on.
+		After that it can only be queried - there's no refitting or reinserting,
+		so nodes don't need parent links or fat margins, and are stored depth
+		first in a single array: a node's first child always comes straight
+		after it, so only the second child's index needs storing.
+
+		Adding anything more (or clearing it) means building it all again.
+		*/
+		template<class T>
+		class StaticAABBTree {
+		public:
+			StaticAABBTree() = default;
+			~StaticAABBTree() = default;
+
+			void Clear() {
+				items.clear();
+				nodes.clear();
+			}
+
+			void Add(T object, const Vector3& pos, const Vector3& halfSize) {
+				items.push_back({ object, pos - halfSize, pos + halfSize, pos, (int)items.size() });
+			}
+
+			void Build() {
+				nodes.clear();
+				if (items.empty()) {
+					return;
+				}
+				nodes.reserve(items.size() * 2);
+				BuildNode(0, (int)items.size());
+			}
+
+			int GetObjectCount() const {
+				return (int)items.size();
+			}
+
+			int GetNodeCount() const {
+				return (int)nodes.size();
+			}
+
+			bool IsEmpty() const {
+				return nodes.empty();
+			}
+
+			/*
+			Calls func(object, index) for every object whose box overlaps the
+			given box, where index is the order it was added in. Returning false
+			from func stops the query early.
+			*/
+			template<typename F>
+			void Query(const Vector3& boxMin, const Vector3& boxMax, F&& func) const {
+				if (nodes.empty()) {
+					return;
+				}
+				int stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = 0;
+
+				while (count > 0) {
+					const Node& n = nodes[stack[--count]];
+
+					if (!Overlaps(n.min, n.max, boxMin, boxMax)) {
+						continue;
+					}
+					if (n.itemCount > 0) {
+						for (int i = n.firstItem; i < n.firstItem + n.itemCount; ++i) {
+							const Item& item = items[i];
+							if (Overlaps(item.min, item.max, boxMin, boxMax) && !func(item.object, item.index)) {
+								return;
+							}
+						}
+					}
+					else {
+						stack[count++] = n.secondChild;
+						stack[count++] = (int)(&n - nodes.data()) + 1;
+					}
+				}
+			}
+
+			/*
+			Walks the objects whose boxes (grown by extent, to sweep a box along
+			the ray instead of a point) the ray passes through, nearest node
+			first. func(object, index) returns how far along the ray to carry on
+			looking - anything it has hit cuts the ray short, and returning less
+			than 0 stops the query.
+			*/
+			template<typename F>
+			void RayQuery(const Vector3& origin, const Vector3& dir, float maxDistance, const Vector3& extent, F&& func) const {
+				if (nodes.empty()) {
+					return;
+				}
+				Vector3 invDir = InverseDirection(dir);
+
+				RayEntry stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = { 0, RayDistance(origin, invDir, nodes[0].min - extent, nodes[0].max + extent, maxDistance) };
+
+				while (count > 0) {
+					RayEntry e = stack[--count];
+					if (e.distance >= maxDistance) {
+						continue;
+					}
+					const Node& n = nodes[e.node];
+					if (n.itemCount > 0) {
+						for (int i = n.firstItem; i < n.firstItem + n.itemCount; ++i) {
+							const Item& item = items[i];
+							if (RayDistance(origin, invDir, item.min - extent, item.max + extent, maxDistance) >= maxDistance) {
+								continue;
+							}
+							float d = func(item.object, item.index);
+							if (d < 0.0f) {
+								return;
+							}
+							maxDistance = std::min(maxDistance, d);
+						}
+						continue;
+					}
+					RayEntry closer		= { e.node + 1, RayDistance(origin, invDir, nodes[e.node + 1].min - extent, nodes[e.node + 1].max + extent, maxDistance) };
+					RayEntry further	= { n.secondChild, RayDistance(origin, invDir, nodes[n.secondChild].min - extent, nodes[n.secondChild].max + extent, maxDistance) };
+					if (further.distance < closer.distance) {
+						std::swap(closer, further);
+					}
+					if (further.distance < maxDistance) {
+						stack[count++] = further;
+					}
+					if (closer.distance < maxDistance) {
+						stack[count++] = closer;
+					}
+				}
+			}
+
+			/*
+			Walks the objects whose boxes come within maxDistance of point,
+			nearest node first. func(object, index) returns how far away to carry
+			on looking - so a k nearest search can shrink it to its k-th best.
+			*/
+			template<typename F>
+			void NearestQuery(const Vector3& point, float maxDistance, F&& func) const {
+				if (nodes.empty()) {
+					return;
+				}
+				RayEntry stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = { 0, BoxDistance(point, nodes[0].min, nodes[0].max) };
+
+				while (count > 0) {
+					RayEntry e = stack[--count];
+					if (e.distance > maxDistance) {
+						continue;
+					}
+					const Node& n = nodes[e.node];
+					if (n.itemCount > 0) {
+						for (int i = n.firstItem; i < n.firstItem + n.itemCount; ++i) {
+							const Item& item = items[i];
+							if (BoxDistance(point, item.min, item.max) <= maxDistance) {
+								maxDistance = std::min(maxDistance, func(item.object, item.index));
+							}
+						}
+						continue;
+					}
+					RayEntry closer		= { e.node + 1, BoxDistance(point, nodes[e.node + 1].min, nodes[e.node + 1].max) };
+					RayEntry further	= { n.secondChild, BoxDistance(point, nodes[n.secondChild].min, nodes[n.secondChild].max) };
+					if (further.distance < closer.distance) {
+						std::swap(closer, further);
+					}
+					if (further.distance <= maxDistance) {
+						stack[count++] = further;
+					}
+					if (closer.distance <= maxDistance) {
+						stack[count++] = closer;
+					}
+				}
+			}
+
+			/*
+			Walks every node and object box that test(min, max) accepts, calling
+			func(object, index) for each object that passes. Of two children, the
+			one further back along dir is visited first.
+			*/
+			template<typename Test, typename F>
+			void Traverse(const Vector3& dir, Test&& test, F&& func) const {
+				if (nodes.empty()) {
+					return;
+				}
+				int stack[MaxStackDepth];
+				int count = 0;
+				stack[count++] = 0;
+
+				while (count > 0) {
+					int index = stack[--count];
+					const Node& n = nodes[index];
+					if (!test(n.min, n.max)) {
+						continue;
+					}
+					if (n.itemCount > 0) {
+						for (int i = n.firstItem; i < n.firstItem + n.itemCount; ++i) {
+							if (test(items[i].min, items[i].max)) {
+								func(items[i].object, items[i].index);
+							}
+						}
+						continue;
+					}
+					const Node& c0 = nodes[index + 1];
+					const Node& c1 = nodes[n.secondChild];
+					bool firstNearer = Vector::Dot(c0.min + c0.max - c1.min - c1.max, dir) < 0.0f;
+
+					stack[count++] = firstNearer ? n.secondChild : index + 1;
+					stack[count++] = firstNearer ? index + 1 : n.secondChild;
+				}
+			}
+
+		protected:
+			static const int MaxStackDepth	= 64;
+			static const int MaxLeafItems	= 4;
+
+			struct RayEntry {
+				int		node;
+				float	distance;
+			};
+
+			static Vector3 InverseDirection(const Vector3& dir) {
+				return Vector3(dir.x != 0.0f ? 1.0f / dir.x : FLT_MAX,
+							   dir.y != 0.0f ? 1.0f / dir.y : FLT_MAX,
+							   dir.z != 0.0f ? 1.0f / dir.z : FLT_MAX);
+			}
+
+			//How far the point is from the box - 0 if it's inside it
+			static float BoxDistance(const Vector3& point, const Vector3& min, const Vector3& max) {
+				Vector3 outside(std::max(0.0f, std::max(min.x - point.x, point.x - max.x)),
+								std::max(0.0f, std::max(min.y - point.y, point.y - max.y)),
+								std::max(0.0f, std::max(min.z - point.z, point.z - max.z)));
+				return Vector::Length(outside);
+			}
+
+			//How far along the ray it enters the box, or FLT_MAX if it misses it before maxDistance
+			static float RayDistance(const Vector3& origin, const Vector3& invDir, const Vector3& min, const Vector3& max, float maxDistance) {
+				float tNear = 0.0f;
+				float tFar	= maxDistance;
+				for (int i = 0; i < 3; ++i) {
+					float t0 = (min[i] - origin[i]) * invDir[i];
+					float t1 = (max[i] - origin[i]) * invDir[i];
+					tNear	= std::max(tNear, std::min(t0, t1));
+					tFar	= std::min(tFar, std::max(t0, t1));
+				}
+				return tNear <= tFar ? tNear : FLT_MAX;
+			}
+
+			struct Item {
+				T		object;
+				Vector3 min;
+				Vector3 max;
+				Vector3 centre;
+				int		index;
+			};
+
+			struct Node {
+				Vector3 min;
+				Vector3 max;
+				int		secondChild;	//Interior nodes only - the first is the next node along
+				int		firstItem;		//Leaves only
+				int		itemCount;		//0 for interior nodes
+			};
+
+			static bool Overlaps(const Vector3& minA, const Vector3& maxA, const Vector3& minB, const Vector3& maxB) {
+				return !(maxA.x < minB.x || minA.x > maxB.x ||
+						 maxA.y < minB.y || minA.y > maxB.y ||
+						 maxA.z < minB.z || minA.z > maxB.z);
+			}
+
+			static Vector3 Min(const Vector3& a, const Vector3& b) {
+				return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+			}
+
+			static Vector3 Max(const Vector3& a, const Vector3& b) {
+				return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+			}
+
+			//Items are sorted in place, so each leaf's items end up next to each other
+			int BuildNode(int first, int last) {
+				int index = (int)nodes.size();
+				nodes.emplace_back();
+
+				Vector3 min		= items[first].min;
+				Vector3 max		= items[first].max;
+				Vector3 cMin	= items[first].centre;
+				Vector3 cMax	= items[first].centre;
+				for (int i = first; i < last; ++i) {
+					min		= Min(min, items[i].min);
+					max		= Max(max, items[i].max);
+					cMin	= Min(cMin, items[i].centre);
+					cMax	= Max(cMax, items[i].centre);
+				}
+				nodes[index].min = min;
+				nodes[index].max = max;
+
+				if (last - first <= MaxLeafItems) {
+					nodes[index].firstItem	= first;
+					nodes[index].itemCount	= last - first;
+					return index;
+				}
+				Vector3 spread = cMax - cMin;
+				int axis = (spread.x > spread.y && spread.x > spread.z) ? 0 : (spread.y > spread.z ? 1 : 2);
+
+				int middle = first + (last - first) / 2;
+				std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + last,
+					[axis](const Item& a, const Item& b) {
+						return a.centre[axis] < b.centre[axis];
+					});
+
+				BuildNode(first, middle);
+				int second = BuildNode(middle, last);
+
+				nodes[index].secondChild	= second;
+				nodes[index].itemCount		= 0;
+				return index;
+			}
+
+			std::vector<Item>	items;
+			std::vector<Node>	nodes;
+		};
+	}
+}
@@ -0,0 +1,2 @@
+#include "SweepAndPrune.h"
+using namespace NCL;
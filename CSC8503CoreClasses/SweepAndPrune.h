@@ -0,0 +1,187 @@
+#pragma once
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Sweep and prune keeps the min and max of every box as 'endpoints' in a
+		sorted array along one axis. The array is kept between frames - objects
+		usually only move a little each step, so it's already nearly sorted, and
+		an insertion sort puts it back in order in close to linear time. Pairs
+		are then found by sweeping along it, and keeping a list of the boxes
+		that are currently 'open', which are only checked against on the other
+		two axes. The axis is whichever the boxes are most spread out along -
+		if that changes, the array is rebuilt for the new one.
+
+		Boxes are identified by a caller chosen ID (the PhysicsSystem reuses the
+		broadphase tree proxy IDs), so storage is a flat array indexed by that ID.
+		*/
+		template<class T>
+		class SweepAndPrune {
+		public:
+			SweepAndPrune() {
+				needsFullSort = false;
+				sweepAxis = 0;
+			}
+			~SweepAndPrune() = default;
+
+			void Clear() {
+				boxes.clear();
+				endpoints.clear();
+				active.clear();
+				needsFullSort = false;
+			}
+
+			void Insert(int id, T object, const Vector3& pos, const Vector3& halfSize, bool isStatic) {
+				if (id >= (int)boxes.size()) {
+					boxes.resize(id + 1);
+				}
+				SAPBox& b	= boxes[id];
+				b.min		= pos - halfSize;
+				b.max		= pos + halfSize;
+				b.object	= object;
+				b.isStatic	= isStatic;
+				b.inUse		= true;
+				b.activeSlot = -1;
+
+				endpoints.push_back({ b.min[sweepAxis], id << 1 });
+				endpoints.push_back({ b.max[sweepAxis], (id << 1) | 1 });
+
+				//Appended endpoints could be anywhere, so don't rely on insertion sort
+				needsFullSort = true;
+			}
+
+			void Remove(int id) {
+				boxes[id].inUse = false;
+				endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+					[id](const Endpoint& p) { return (p.data >> 1) == id; }), endpoints.end());
+			}
+
+			void Update(int id, const Vector3& pos, const Vector3& halfSize) {
+				boxes[id].min = pos - halfSize;
+				boxes[id].max = pos + halfSize;
+			}
+
+			int GetBoxCount() const {
+				return (int)endpoints.size() / 2;
+			}
+
+			/*
+			Re-sorts the endpoints, then sweeps along them, calling func(a, b) for
+			every overlapping pair of boxes where at least one of them isn't static.
+			*/
+			template<typename F>
+			void FindPairs(F&& func) {
+				SortEndpoints();
+
+				int axisB = (sweepAxis + 1) % 3;
+				int axisC = (sweepAxis + 2) % 3;
+
+				active.clear();
+				for (const Endpoint& e : endpoints) {
+					int id = e.data >> 1;
+					if (e.data & 1) { //max endpoint - this box closes, and the last open box takes its place
+						int slot = boxes[id].activeSlot;
+						active[slot] = active.back();
+						boxes[active[slot]].activeSlot = slot;
+						active.pop_back();
+						continue;
+					}
+					SAPBox& a = boxes[id];
+					for (int other : active) {
+						const SAPBox& b = boxes[other];
+						if (a.isStatic && b.isStatic) {
+							continue;
+						}
+						if (a.max[axisB] < b.min[axisB] || a.min[axisB] > b.max[axisB] ||
+							a.max[axisC] < b.min[axisC] || a.min[axisC] > b.max[axisC]) {
+							continue;
+						}
+						func(a.object, b.object);
+					}
+					a.activeSlot = (int)active.size();
+					active.push_back(id);
+				}
+			}
+
+		protected:
+			struct Endpoint {
+				float	value;
+				int		data; //box ID << 1, with the low bit set for max endpoints
+
+				//Mins go before maxes at the same value, so touching boxes still overlap, and no box closes before it opens
+				bool operator < (const Endpoint& other) const {
+					return value < other.value || (value == other.value && (data & 1) < (other.data & 1));
+				}
+			};
+
+			struct SAPBox {
+				Vector3 min;
+				Vector3 max;
+				T		object	= T();
+				bool	isStatic = false;
+				bool	inUse	= false;
+				int		activeSlot = -1;	//Where it is in the active list, while the sweep has it open
+			};
+
+			void SortEndpoints() {
+				//Find which axis has the largest spread of box centres to sweep along
+				Vector3 sum;
+				Vector3 sumSq;
+				int count = 0;
+				for (const SAPBox& b : boxes) {
+					if (!b.inUse) {
+						continue;
+					}
+					Vector3 c = (b.min + b.max) * 0.5f;
+					sum		+= c;
+					sumSq	+= c * c;
+					count++;
+				}
+				if (count > 0) {
+					Vector3 variance = sumSq - (sum * sum) / (float)count;
+					int bestAxis = 0;
+					if (variance.y > variance[bestAxis]) {
+						bestAxis = 1;
+					}
+					if (variance.z > variance[bestAxis]) {
+						bestAxis = 2;
+					}
+					//The endpoints are in the order of the old axis, which says nothing about the new one
+					if (bestAxis != sweepAxis) {
+						sweepAxis		= bestAxis;
+						needsFullSort	= true;
+					}
+				}
+
+				//Pick up the latest box extents
+				for (Endpoint& e : endpoints) {
+					const SAPBox& b = boxes[e.data >> 1];
+					e.value = (e.data & 1) ? b.max[sweepAxis] : b.min[sweepAxis];
+				}
+
+				if (needsFullSort) {
+					std::sort(endpoints.begin(), endpoints.end());
+					needsFullSort = false;
+					return;
+				}
+				for (size_t j = 1; j < endpoints.size(); ++j) {
+					Endpoint key = endpoints[j];
+					size_t k = j;
+					while (k > 0 && key < endpoints[k - 1]) {
+						endpoints[k] = endpoints[k - 1];
+						--k;
+					}
+					endpoints[k] = key;
+				}
+			}
+
+			std::vector<SAPBox>		boxes;
+			std::vector<Endpoint>	endpoints;	//Along the sweep axis
+			std::vector<int>		active;
+
+			bool	needsFullSort;
+			int		sweepAxis;
+		};
+	}
+}
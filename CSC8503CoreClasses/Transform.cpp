@@ -1,9 +1,15 @@
 #include "Transform.h"
+#include "RigidBodyStore.h"
 
 using namespace NCL::CSC8503;
 
 Transform::Transform()	{
 	scale = Vector3(1, 1, 1);
+
+	store			= nullptr;
+	storeIndex		= -1;
+	matrixVersion	= 0;
+	matrixDirty		= true;
 }
 
 Transform::~Transform()	{
@@ -12,25 +18,73 @@ Transform::~Transform()	{
 
 void Transform::UpdateMatrix() {
 	matrix =
-		Matrix::Translation(position) *
-		Quaternion::RotationMatrix<Matrix4>(orientation) *
+		Matrix::Translation(GetPosition()) *
+		Quaternion::RotationMatrix<Matrix4>(GetOrientation()) *
+		Matrix::Scale(scale);
+	matrixDirty = false;
+	if (store) {
+		matrixVersion = store->GetVersion();
+	}
+}
+
+Matrix4 Transform::GetMatrix() const {
+	//The store's version changes whenever the physics moves its bodies
+	if (matrixDirty || (store && matrixVersion != store->GetVersion())) {
+		const_cast<Transform*>(this)->UpdateMatrix();
+	}
+	return matrix;
+}
+
+//Not cached, as the blend changes every frame, even when the physics doesn't step
+Matrix4 Transform::GetRenderMatrix() const {
+	if (!store) {
+		return GetMatrix();
+	}
+	return Matrix::Translation(GetInterpolatedPosition()) *
+		Quaternion::RotationMatrix<Matrix4>(GetInterpolatedOrientation()) *
 		Matrix::Scale(scale);
 }
 
+Vector3 Transform::GetInterpolatedPosition() const {
+	return store ? store->GetInterpolatedPosition(storeIndex) : position;
+}
+
+Quaternion Transform::GetInterpolatedOrientation() const {
+	return store ? store->GetInterpolatedOrientation(storeIndex) : orientation;
+}
+
+Vector3 Transform::GetPosition() const {
+	return store ? store->GetVector(RigidBodyStore::PositionX, storeIndex) : position;
+}
+
+Quaternion Transform::GetOrientation() const {
+	return store ? store->GetOrientation(storeIndex) : orientation;
+}
+
 Transform& Transform::SetPosition(const Vector3& worldPos) {
-	position = worldPos;
-	UpdateMatrix();
+	if (store) {
+		store->SetAwake(storeIndex, true); //Moving a body by hand means it's no longer at rest
+		store->SetVector(RigidBodyStore::PositionX, storeIndex, worldPos);
+		store->SetVector(RigidBodyStore::PreviousPositionX, storeIndex, worldPos); //Teleported, not moved
+	}
+	position	= worldPos;
+	matrixDirty = true;
 	return *this;
 }
 
 Transform& Transform::SetScale(const Vector3& worldScale) {
-	scale = worldScale;
-	UpdateMatrix();
+	scale		= worldScale;
+	matrixDirty = true;
 	return *this;
 }
 
 Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
+	if (store) {
+		store->SetAwake(storeIndex, true);
+		store->SetOrientation(storeIndex, worldOrientation);
+		store->SetOrientation(storeIndex, worldOrientation, RigidBodyStore::PreviousOrientationX);
+	}
 	orientation = worldOrientation;
-	UpdateMatrix();
+	matrixDirty = true;
 	return *this;
-}
\ No newline at end of file
+}
@@ -6,8 +6,17 @@ using namespace NCL::Maths;
 
 namespace NCL {
 	namespace CSC8503 {
+		class RigidBodyStore;
+
+		/*
+		The matrix is only rebuilt when it is asked for, so moving an object
+		several times in a frame only pays for one rebuild. Transforms of physics
+		objects are bound to the PhysicsSystem's RigidBodyStore, which holds their
+		position and orientation.
+		*/
 		class Transform
 		{
+			friend class RigidBodyStore;
 		public:
 			Transform();
 			~Transform();
@@ -16,31 +25,37 @@ namespace NCL {
 			Transform& SetScale(const Vector3& worldScale);
 			Transform& SetOrientation(const Quaternion& newOr);
 
-			Vector3 GetPosition() const {
-				return position;
-			}
+			Vector3 GetPosition() const;
 
 			Vector3 GetScale() const {
 				return scale;
 			}
 
-			Quaternion GetOrientation() const {
-				return orientation;
-			}
+			Quaternion GetOrientation() const;
+
+			Matrix4 GetMatrix() const;
+
+			//Where physics objects should be drawn - between their last two steps, see
+			//RigidBodyStore::SetInterpolation. Anything else is just where it is
+			Vector3		GetInterpolatedPosition() const;
+			Quaternion	GetInterpolatedOrientation() const;
+			Matrix4		GetRenderMatrix() const;
 
-			Matrix4 GetMatrix() const {
-				return matrix;
-			}
 			Matrix3 GetWorldOrientation() const {
-				return Quaternion::RotationMatrix<Matrix3>(orientation);
+				return Quaternion::RotationMatrix<Matrix3>(GetOrientation());
 			}
 			void UpdateMatrix();
 		protected:
-			Matrix4		matrix;
-			Quaternion	orientation;
-			Vector3		position;
+			mutable Matrix4	matrix;
+			Quaternion		orientation;
+			Vector3			position;
+
+			Vector3			scale;
 
-			Vector3		scale;
+			RigidBodyStore*	store;
+			int				storeIndex;
+			mutable int		matrixVersion;
+			mutable bool	matrixDirty;
 		};
 	}
 }
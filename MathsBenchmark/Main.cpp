@@ -0,0 +1,325 @@
+/*
+Checks the SIMD versions of the float maths types against the plain template
+code they stand in for, then times the two side by side.
+
+	MathsBenchmark [--check] [--cases n] [--count n] [--repeats n]
+
+Each check runs over --cases random inputs, comparing the overloads in
+VectorSIMD.h / MatrixSIMD.h and the SSE paths in Quaternion.cpp with the
+templates in Vector.h / Matrix.h (called with explicit template arguments, so
+the overloads can't be picked) or with the textbook quaternion formulas. The
+answers must agree to a relative 1e-5, or 1e-4 for the inverse and rotation.
+--check stops after the checks, returning non-zero if anything disagreed,
+which is how CTest runs it. Otherwise each operation is then timed over an
+array of --count inputs, --repeats times. Built with NCL_MATHS_SCALAR both
+sides are the template code, so the checks still pass and the times match.
+*/
+#include "Vector.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+
+#include <iomanip>
+#include <random>
+
+using namespace NCL;
+using namespace Maths;
+
+namespace {
+	struct Options {
+		int		cases	= 10000;
+		int		count	= 4096;
+		int		repeats	= 200;
+		bool	check	= false;
+	};
+
+	//What Quaternion.cpp does without SSE
+	Quaternion MultiplyReference(const Quaternion& a, const Quaternion& b) {
+		return Quaternion(
+			(a.x * b.w) + (a.w * b.x) + (a.y * b.z) - (a.z * b.y),
+			(a.y * b.w) + (a.w * b.y) + (a.z * b.x) - (a.x * b.z),
+			(a.z * b.w) + (a.w * b.z) + (a.x * b.y) - (a.y * b.x),
+			(a.w * b.w) - (a.x * b.x) - (a.y * b.y) - (a.z * b.z)
+		);
+	}
+
+	Vector3 RotateReference(const Quaternion& q, const Vector3& v) {
+		Quaternion r = MultiplyReference(MultiplyReference(q, Quaternion(v.x, v.y, v.z, 0.0f)), q.Conjugate());
+		return Vector3(r.x, r.y, r.z);
+	}
+
+	class Inputs {
+	public:
+		Inputs(int count, unsigned int seed) : rng(seed), range(-2.0f, 2.0f) {
+			for (int i = 0; i < count; ++i) {
+				vec4s.push_back(RandomVector4());
+				vec3s.push_back(RandomVector3());
+				quats.push_back(RandomQuaternion());
+				mats.push_back(RandomMatrix());
+			}
+		}
+
+		std::vector<Vector4>	vec4s;
+		std::vector<Vector3>	vec3s;
+		std::vector<Quaternion>	quats;
+		std::vector<Matrix4>	mats;
+
+	protected:
+		float Random() {
+			return range(rng);
+		}
+
+		Vector4 RandomVector4() {
+			return Vector4(Random(), Random(), Random(), Random());
+		}
+
+		Vector3 RandomVector3() {
+			return Vector3(Random(), Random(), Random());
+		}
+
+		Quaternion RandomQuaternion() {
+			return Quaternion(Random(), Random(), Random(), Random()).Normalised();
+		}
+
+		//A heavy diagonal keeps these well conditioned, so the inverses can be compared
+		Matrix4 RandomMatrix() {
+			Matrix4 m;
+			for (int i = 0; i < 4; ++i) {
+				for (int j = 0; j < 4; ++j) {
+					m.array[i][j] = Random() + (i == j ? 8.0f : 0.0f);
+				}
+			}
+			return m;
+		}
+
+		std::mt19937							rng;
+		std::uniform_real_distribution<float>	range;
+	};
+
+	class Checker {
+	public:
+		Checker(float tolerance) : tolerance(tolerance) {}
+
+		bool Near(float a, float b) const {
+			return std::abs(a - b) <= tolerance * std::max(1.0f, std::max(std::abs(a), std::abs(b)));
+		}
+
+		template <uint32_t n>
+		bool Near(const VectorTemplate<float, n>& a, const VectorTemplate<float, n>& b) const {
+			for (uint32_t i = 0; i < n; ++i) {
+				if (!Near(a[i], b[i])) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool Near(const Matrix4& a, const Matrix4& b) const {
+			for (int i = 0; i < 4; ++i) {
+				if (!Near(a.GetRow(i), b.GetRow(i))) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool Near(const Quaternion& a, const Quaternion& b) const {
+			return Near(Vector4(a.x, a.y, a.z, a.w), Vector4(b.x, b.y, b.z, b.w));
+		}
+
+		void Expect(bool ok, const char* name) {
+			if (!ok && failures[name]++ == 0) {
+				std::cerr << "Mismatch in " << name << "\n";
+			}
+		}
+
+		int FailureCount() const {
+			int total = 0;
+			for (const auto& [name, count] : failures) {
+				total += count;
+			}
+			return total;
+		}
+
+	protected:
+		float						tolerance;
+		std::map<std::string, int>	failures;
+	};
+
+	int RunChecks(const Options& options) {
+		Inputs	in(options.cases + 1, 7);
+		Checker	exact(1e-5f);
+		Checker	loose(1e-4f);
+
+		for (int i = 0; i < options.cases; ++i) {
+			const Vector4& a = in.vec4s[i];
+			const Vector4& b = in.vec4s[i + 1];
+			const Vector3& p = in.vec3s[i];
+			const Vector3& q = in.vec3s[i + 1];
+			const Matrix4& m = in.mats[i];
+			const Matrix4& n = in.mats[i + 1];
+			const Quaternion& r = in.quats[i];
+			const Quaternion& s = in.quats[i + 1];
+			float scale = p.x;
+
+			exact.Expect(exact.Near(a + b, operator+<float, 4>(a, b)), "Vector4 + Vector4");
+			exact.Expect(exact.Near(a - b, operator-<float, 4>(a, b)), "Vector4 - Vector4");
+			exact.Expect(exact.Near(-a, operator-<float, 4>(a)), "-Vector4");
+			exact.Expect(exact.Near(a * b, operator*<float, 4>(a, b)), "Vector4 * Vector4");
+			exact.Expect(exact.Near(a * scale, operator*<float, 4>(a, scale)), "Vector4 * float");
+			if (std::abs(scale) > 0.1f) {
+				exact.Expect(exact.Near(a / scale, operator/<float, 4>(a, scale)), "Vector4 / float");
+			}
+			exact.Expect(exact.Near(Vector::Dot(a, b), Vector::Dot<float, 4>(a, b)), "Dot(Vector4)");
+			exact.Expect(exact.Near(Vector::Normalise(a), Vector::Normalise<float, 4>(a)), "Normalise(Vector4)");
+
+			Vector4 c = a;
+			c += b;
+			exact.Expect(exact.Near(c, operator+<float, 4>(a, b)), "Vector4 += Vector4");
+			c = a;
+			c *= scale;
+			exact.Expect(exact.Near(c, operator*<float, 4>(a, scale)), "Vector4 *= float");
+
+			exact.Expect(exact.Near(Vector::Cross(p, q), Vector::Cross<float>(p, q)), "Cross(Vector3)");
+			exact.Expect(exact.Near(Vector::Normalise(p), Vector::Normalise<float, 3>(p)), "Normalise(Vector3)");
+
+			exact.Expect(exact.Near(m * n, operator*<float, 4, 4>(m, n)), "Matrix4 * Matrix4");
+			exact.Expect(exact.Near(m * a, operator*<float>(m, a)), "Matrix4 * Vector4");
+			loose.Expect(loose.Near(Matrix::Inverse(m), Matrix::Inverse<float>(m)), "Inverse(Matrix4)");
+
+			exact.Expect(exact.Near(r * s, MultiplyReference(r, s)), "Quaternion * Quaternion");
+			loose.Expect(loose.Near(r * p, RotateReference(r, p)), "Quaternion * Vector3");
+			Vector4 unit = Vector::Normalise<float, 4>(a);
+			exact.Expect(exact.Near(Quaternion(a.x, a.y, a.z, a.w).Normalised(), Quaternion(unit.x, unit.y, unit.z, unit.w)), "Quaternion::Normalise");
+		}
+		//Zero length vectors have to come back as zero, not NaN
+		exact.Expect(exact.Near(Vector::Normalise(Vector3()), Vector3()), "Normalise(zero Vector3)");
+		exact.Expect(exact.Near(Vector::Normalise(Vector4()), Vector4()), "Normalise(zero Vector4)");
+
+		return exact.FailureCount() + loose.FailureCount();
+	}
+
+	//Times the template version of an operation against whatever the build picks
+	template <typename Reference, typename Fast>
+	void Time(const std::string& name, const Options& options, Reference&& reference, Fast&& fast) {
+		float sink = 0.0f;
+		double times[2];
+
+		GameTimer referenceTimer;
+		for (int r = 0; r < options.repeats; ++r) {
+			for (int i = 0; i + 1 < options.count; ++i) {
+				sink += reference(i);
+			}
+		}
+		times[0] = referenceTimer.GetTotalTimeMSec();
+
+		GameTimer fastTimer;
+		for (int r = 0; r < options.repeats; ++r) {
+			for (int i = 0; i + 1 < options.count; ++i) {
+				sink += fast(i);
+			}
+		}
+		times[1] = fastTimer.GetTotalTimeMSec();
+
+		double calls = (double)options.repeats * (options.count - 1);
+		std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(8) << times[0] * 1000000.0 / calls << "ns "
+			<< std::setw(8) << times[1] * 1000000.0 / calls << "ns "
+			<< std::setw(7) << times[0] / std::max(times[1], 0.0001) << "x"
+			<< "  (" << sink << ")\n";
+	}
+
+	void RunTimings(const Options& options) {
+		Inputs in(options.count, 11);
+
+		const std::vector<Vector4>&		v4 = in.vec4s;
+		const std::vector<Vector3>&		v3 = in.vec3s;
+		const std::vector<Quaternion>&	q  = in.quats;
+		const std::vector<Matrix4>&		m  = in.mats;
+
+		std::cout << std::left << std::setw(26) << "" << std::right << std::setw(10) << "template" << std::setw(10) << "build" << "\n";
+
+		Time("Vector4 + Vector4", options,
+			[&](int i) { return operator+<float, 4>(v4[i], v4[i + 1]).x; },
+			[&](int i) { return (v4[i] + v4[i + 1]).x; });
+		Time("Dot(Vector4)", options,
+			[&](int i) { return Vector::Dot<float, 4>(v4[i], v4[i + 1]); },
+			[&](int i) { return Vector::Dot(v4[i], v4[i + 1]); });
+		Time("Cross(Vector3)", options,
+			[&](int i) { return Vector::Cross<float>(v3[i], v3[i + 1]).y; },
+			[&](int i) { return Vector::Cross(v3[i], v3[i + 1]).y; });
+		Time("Normalise(Vector3)", options,
+			[&](int i) { return Vector::Normalise<float, 3>(v3[i]).z; },
+			[&](int i) { return Vector::Normalise(v3[i]).z; });
+		Time("Matrix4 * Matrix4", options,
+			[&](int i) { return operator*<float, 4, 4>(m[i], m[i + 1]).array[1][2]; },
+			[&](int i) { return (m[i] * m[i + 1]).array[1][2]; });
+		Time("Matrix4 * Vector4", options,
+			[&](int i) { return operator*<float>(m[i], v4[i]).w; },
+			[&](int i) { return (m[i] * v4[i]).w; });
+		Time("Inverse(Matrix4)", options,
+			[&](int i) { return Matrix::Inverse<float>(m[i]).array[2][1]; },
+			[&](int i) { return Matrix::Inverse(m[i]).array[2][1]; });
+		Time("Quaternion * Quaternion", options,
+			[&](int i) { return MultiplyReference(q[i], q[i + 1]).w; },
+			[&](int i) { return (q[i] * q[i + 1]).w; });
+		Time("Quaternion * Vector3", options,
+			[&](int i) { return RotateReference(q[i], v3[i]).x; },
+			[&](int i) { return (q[i] * v3[i]).x; });
+	}
+
+	const char* BuildName() {
+#if defined(NCL_MATHS_AVX2)
+		return "SSE + AVX2";
+#elif defined(NCL_MATHS_SSE)
+		return "SSE";
+#else
+		return "scalar";
+#endif
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "--check") {
+				options.check = true;
+			}
+			else if (arg == "--cases" && hasValue) {
+				options.cases = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--count" && hasValue) {
+				options.count = std::max(2, std::atoi(argv[++i]));
+			}
+			else if (arg == "--repeats" && hasValue) {
+				options.repeats = std::max(1, std::atoi(argv[++i]));
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::cerr << "Usage: " << argv[0] << " [--check] [--cases n] [--count n] [--repeats n]\n";
+		return 1;
+	}
+
+	std::cout << "Maths built as " << BuildName() << "\n";
+
+	int failures = RunChecks(options);
+	if (failures > 0) {
+		std::cerr << failures << " of " << options.cases << " cases disagreed with the template code\n";
+		return 1;
+	}
+	std::cout << "All " << options.cases << " cases agree with the template code\n";
+
+	if (!options.check) {
+		RunTimings(options);
+	}
+	return 0;
+}
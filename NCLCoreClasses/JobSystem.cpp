@@ -0,0 +1,169 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#include "JobSystem.h"
+
+using namespace NCL;
+
+namespace {
+	//Which pool (if any) the current thread works for, and its queue in that pool
+	thread_local const JobSystem*	currentSystem	= nullptr;
+	thread_local int				currentWorker	= -1;
+}
+
+JobSystem::JobSystem(int workerCount) {
+	if (workerCount < 0) {
+		workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+	}
+	queuedJobs	= 0;
+	nextQueue	= 0;
+	running		= true;
+
+	for (int i = 0; i < workerCount; ++i) {
+		queues.emplace_back(new WorkQueue());
+	}
+	for (int i = 0; i < workerCount; ++i) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		running = false;
+	}
+	sleepCondition.notify_all();
+
+	for (std::thread& t : workers) {
+		t.join();
+	}
+	for (WorkQueue* q : queues) {
+		delete q;
+	}
+}
+
+int JobSystem::CurrentWorkerIndex() const {
+	return currentSystem == this ? currentWorker : -1;
+}
+
+/*
+Workers push onto their own queue, so that the jobs they make are likely to be
+picked straight back up by them while the data is still in cache. Anyone else
+deals their jobs out across the queues in turn.
+*/
+void JobSystem::Run(const Job& job, JobCounter& counter) {
+	counter.pending++;
+
+	if (queues.empty()) {
+		QueuedJob inlineJob{ job, &counter };
+		Execute(inlineJob);
+		return;
+	}
+	int index = CurrentWorkerIndex();
+	if (index < 0) {
+		index = (nextQueue++) % (int)queues.size();
+	}
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->jobs.push_back({ job, &counter });
+	}
+	queuedJobs++;
+	{
+		//Taking the lock means a worker can't miss this between checking and sleeping
+		std::lock_guard<std::mutex> guard(sleepLock);
+	}
+	sleepCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	int index = CurrentWorkerIndex();
+	while (counter.pending > 0) {
+		QueuedJob job;
+		if (PopJob(index, job)) {
+			Execute(job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(int count, int grainSize, const RangeJob& func) {
+	if (count <= 0) {
+		return;
+	}
+	grainSize = std::max(1, grainSize);
+	if (queues.empty() || count <= grainSize) {
+		for (int first = 0; first < count; first += grainSize) {
+			func(first, std::min(count, first + grainSize));
+		}
+		return;
+	}
+	JobCounter counter;
+	for (int first = 0; first < count; first += grainSize) {
+		int last = std::min(count, first + grainSize);
+		Run([&func, first, last]() { func(first, last); }, counter);
+	}
+	Wait(counter);
+}
+
+/*
+Our own queue is used like a stack, newest job first, while anything stolen
+from another queue comes off the opposite end, oldest first.
+*/
+bool JobSystem::PopJob(int index, QueuedJob& out) {
+	if (queuedJobs == 0) {
+		return false;
+	}
+	int queueCount = (int)queues.size();
+	if (index >= 0) {
+		WorkQueue& q = *queues[index];
+		std::lock_guard<std::mutex> guard(q.lock);
+		if (!q.jobs.empty()) {
+			out = std::move(q.jobs.back());
+			q.jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+	int start = index < 0 ? 0 : index + 1;
+	for (int i = 0; i < queueCount; ++i) {
+		WorkQueue& q = *queues[(start + i) % queueCount];
+		std::lock_guard<std::mutex> guard(q.lock);
+		if (!q.jobs.empty()) {
+			out = std::move(q.jobs.front());
+			q.jobs.pop_front();
+			queuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute(QueuedJob& job) {
+	job.job();
+	job.counter->pending--;
+}
+
+void JobSystem::WorkerLoop(int index) {
+	currentSystem = this;
+	currentWorker = index;
+
+	while (true) {
+		QueuedJob job;
+		if (PopJob(index, job)) {
+			Execute(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepLock);
+		sleepCondition.wait(lock, [&]() { return !running || queuedJobs > 0; });
+		if (!running) {
+			break;
+		}
+	}
+}
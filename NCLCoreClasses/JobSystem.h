@@ -0,0 +1,79 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace NCL {
+	typedef std::function<void()>					Job;
+	typedef std::function<void(int first, int last)>	RangeJob;
+
+	//Counts how many jobs in a group are still to finish - see JobSystem::Wait
+	struct JobCounter {
+		std::atomic<int> pending{ 0 };
+	};
+
+	/*
+	A pool of worker threads, each with its own queue of jobs. Workers take
+	jobs from the back of their own queue, and when that runs dry, steal from
+	the front of the others. A thread that waits on a JobCounter helps out by
+	running jobs until the counter reaches zero, so jobs can safely start and
+	wait on more jobs themselves.
+
+	With no worker threads, jobs are just run immediately on the calling thread.
+	*/
+	class JobSystem {
+	public:
+		//A negative worker count uses one worker per hardware thread, less the calling thread
+		JobSystem(int workerCount = -1);
+		~JobSystem();
+
+		//Includes the calling thread, which does its share of work while waiting
+		int GetThreadCount() const {
+			return (int)workers.size() + 1;
+		}
+
+		void Run(const Job& job, JobCounter& counter);
+		void Wait(JobCounter& counter);
+
+		/*
+		Splits [0, count) into ranges of at most grainSize, and runs func over
+		each range, returning once all of them are done. The ranges only depend
+		on count and grainSize, never on how many threads there are.
+		*/
+		void ParallelFor(int count, int grainSize, const RangeJob& func);
+
+	protected:
+		struct QueuedJob {
+			Job			job;
+			JobCounter* counter = nullptr;
+		};
+
+		struct WorkQueue {
+			std::mutex				lock;
+			std::deque<QueuedJob>	jobs;
+		};
+
+		void WorkerLoop(int index);
+		bool PopJob(int index, QueuedJob& out);
+		void Execute(QueuedJob& job);
+		int	 CurrentWorkerIndex() const;
+
+		std::vector<std::thread>	workers;
+		std::vector<WorkQueue*>		queues;
+
+		std::mutex					sleepLock;
+		std::condition_variable		sleepCondition;
+		std::atomic<int>			queuedJobs;
+		std::atomic<int>			nextQueue;
+		std::atomic<bool>			running;
+	};
+}
@@ -163,6 +163,29 @@ namespace NCL::Maths {
         template <typename T>
         constexpr MatrixTemplate<T, 3, 3> Inverse(const MatrixTemplate<T, 3, 3>& mat) {
             MatrixTemplate<T, 3, 3> outMat;
+            const auto& m = mat.array;
+
+            //Cofactors of the first row, which the determinant is expanded along
+            float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+            float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+            float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+            float determinant = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+            if (determinant == 0.0f) {
+                return outMat;
+            }
+            float invDet = 1.0f / determinant;
+
+            outMat.array[0][0] = c00 * invDet;
+            outMat.array[1][0] = c01 * invDet;
+            outMat.array[2][0] = c02 * invDet;
+            outMat.array[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+            outMat.array[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+            outMat.array[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+            outMat.array[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+            outMat.array[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+            outMat.array[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
             return outMat;
         }
 
@@ -432,4 +455,6 @@ namespace NCL::Maths {
 
         return o;
     }
-}
\ No newline at end of file
+}
+
+#include "MatrixSIMD.h"
\ No newline at end of file
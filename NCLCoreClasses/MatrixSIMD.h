@@ -0,0 +1,153 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include "SIMD.h"
+
+/*
+SSE (and when available, AVX2) versions of the Matrix4 operations. As with
+VectorSIMD.h, these are non-template overloads, so are picked over the generic
+templates in Matrix.h. Matrix4 is stored column major, so each column is one
+register's worth of floats.
+*/
+#ifdef NCL_MATHS_SSE
+namespace NCL::Maths {
+    inline Matrix4 operator*(const Matrix4& a, const Matrix4& b) {
+        Matrix4 out;
+#ifdef NCL_MATHS_AVX2
+        //Two output columns at once - each 128 bit lane holds one column
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)a.array[0]);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)a.array[1]);
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)a.array[2]);
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)a.array[3]);
+
+        for (int cc = 0; cc < 4; cc += 2) {
+            __m256 bCols = _mm256_loadu_ps(b.array[cc]);
+            __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(bCols, bCols, 0x00));
+            r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(bCols, bCols, 0x55), r);
+            r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(bCols, bCols, 0xAA), r);
+            r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(bCols, bCols, 0xFF), r);
+            _mm256_storeu_ps(out.array[cc], r);
+        }
+#else
+        __m128 a0 = _mm_loadu_ps(a.array[0]);
+        __m128 a1 = _mm_loadu_ps(a.array[1]);
+        __m128 a2 = _mm_loadu_ps(a.array[2]);
+        __m128 a3 = _mm_loadu_ps(a.array[3]);
+
+        for (int cc = 0; cc < 4; ++cc) {
+            __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b.array[cc][0]));
+            r = SIMD::MulAdd(a1, _mm_set1_ps(b.array[cc][1]), r);
+            r = SIMD::MulAdd(a2, _mm_set1_ps(b.array[cc][2]), r);
+            r = SIMD::MulAdd(a3, _mm_set1_ps(b.array[cc][3]), r);
+            _mm_storeu_ps(out.array[cc], r);
+        }
+#endif
+        return out;
+    }
+
+    inline Vector4 operator*(const Matrix4& mat, const Vector4& v) {
+        __m128 r = _mm_mul_ps(_mm_loadu_ps(mat.array[0]), _mm_set1_ps(v.x));
+        r = SIMD::MulAdd(_mm_loadu_ps(mat.array[1]), _mm_set1_ps(v.y), r);
+        r = SIMD::MulAdd(_mm_loadu_ps(mat.array[2]), _mm_set1_ps(v.z), r);
+        r = SIMD::MulAdd(_mm_loadu_ps(mat.array[3]), _mm_set1_ps(v.w), r);
+
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, r);
+        return answer;
+    }
+
+    namespace SIMD {
+        template<int x, int y, int z, int w>
+        inline __m128 Swizzle(__m128 v) {
+            return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), _MM_SHUFFLE(w, z, y, x)));
+        }
+
+        template<int x, int y, int z, int w>
+        inline __m128 Shuffle(__m128 a, __m128 b) {
+            return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x));
+        }
+
+        //The Inverse helpers work on 2x2 matrices packed into a register as (m00, m01, m10, m11)
+        inline __m128 Mat2Mul(__m128 a, __m128 b) {
+            return _mm_add_ps(_mm_mul_ps(a, Swizzle<0, 3, 0, 3>(b)),
+                _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+        }
+
+        //adjugate(a) * b
+        inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+            return _mm_sub_ps(_mm_mul_ps(Swizzle<3, 3, 0, 0>(a), b),
+                _mm_mul_ps(Swizzle<1, 1, 2, 2>(a), Swizzle<2, 3, 0, 1>(b)));
+        }
+
+        //a * adjugate(b)
+        inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+            return _mm_sub_ps(_mm_mul_ps(a, Swizzle<3, 0, 3, 0>(b)),
+                _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+        }
+    }
+
+    namespace Matrix {
+        /*
+        Block-wise inverse - the matrix is split into four 2x2 blocks, and the
+        inverse built from their determinants and adjugates. As the inverse of
+        a transpose is the transpose of the inverse, this doesn't care that our
+        matrices are column rather than row major.
+        */
+        inline Matrix4 Inverse(const Matrix4& mat) {
+            using namespace SIMD;
+            __m128 c0 = _mm_loadu_ps(mat.array[0]);
+            __m128 c1 = _mm_loadu_ps(mat.array[1]);
+            __m128 c2 = _mm_loadu_ps(mat.array[2]);
+            __m128 c3 = _mm_loadu_ps(mat.array[3]);
+
+            __m128 A = _mm_movelh_ps(c0, c1);
+            __m128 B = _mm_movehl_ps(c1, c0);
+            __m128 C = _mm_movelh_ps(c2, c3);
+            __m128 D = _mm_movehl_ps(c3, c2);
+
+            //Determinants of the four blocks, as (|A|, |B|, |C|, |D|)
+            __m128 detSub = _mm_sub_ps(
+                _mm_mul_ps(Shuffle<0, 2, 0, 2>(c0, c2), Shuffle<1, 3, 1, 3>(c1, c3)),
+                _mm_mul_ps(Shuffle<1, 3, 1, 3>(c0, c2), Shuffle<0, 2, 0, 2>(c1, c3))
+            );
+            __m128 detA = Swizzle<0, 0, 0, 0>(detSub);
+            __m128 detB = Swizzle<1, 1, 1, 1>(detSub);
+            __m128 detC = Swizzle<2, 2, 2, 2>(detSub);
+            __m128 detD = Swizzle<3, 3, 3, 3>(detSub);
+
+            __m128 D_C = Mat2AdjMul(D, C);
+            __m128 A_B = Mat2AdjMul(A, B);
+
+            __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+            __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+            __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+            __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+            //|M| = |A||D| + |B||C| - trace((A#B)(D#C))
+            __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+            __m128 tr   = HorizontalSum(_mm_mul_ps(A_B, Swizzle<0, 2, 1, 3>(D_C)));
+            detM = _mm_sub_ps(detM, tr);
+
+            __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+            X_ = _mm_mul_ps(X_, rDetM);
+            Y_ = _mm_mul_ps(Y_, rDetM);
+            Z_ = _mm_mul_ps(Z_, rDetM);
+            W_ = _mm_mul_ps(W_, rDetM);
+
+            Matrix4 out;
+            _mm_storeu_ps(out.array[0], Shuffle<3, 1, 3, 1>(X_, Y_));
+            _mm_storeu_ps(out.array[1], Shuffle<2, 0, 2, 0>(X_, Y_));
+            _mm_storeu_ps(out.array[2], Shuffle<3, 1, 3, 1>(Z_, W_));
+            _mm_storeu_ps(out.array[3], Shuffle<2, 0, 2, 0>(Z_, W_));
+            return out;
+        }
+    }
+}
+#endif
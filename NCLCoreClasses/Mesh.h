@@ -8,6 +8,7 @@ https://research.ncl.ac.uk/game/
 */
 #pragma once
 #include <cstdint>
+#include <memory>
 #include "Vector.h"
 #include "Matrix.h"
 
@@ -90,6 +90,9 @@ float Quaternion::Dot(const Quaternion &a,const Quaternion &b){
 }
 
 void Quaternion::Normalise(){
+#ifdef NCL_MATHS_SSE
+	_mm_storeu_ps(&x, SIMD::Normalise(_mm_loadu_ps(&x)));
+#else
 	float magnitude = sqrt(x*x + y*y + z*z + w*w);
 
 	if(magnitude > 0.0f){
@@ -100,6 +103,7 @@ void Quaternion::Normalise(){
 		z *= t;
 		w *= t;
 	}
+#endif
 }
 
 Quaternion Quaternion::Normalised() const {
@@ -149,12 +153,23 @@ Quaternion Quaternion::Slerp(const Quaternion &from, const Quaternion &to, float
 	float aScale = sin((1 - t) * theta);
 	float bScale = sin(t * theta);
 
+#ifdef NCL_MATHS_SSE
+	//The 1 / sin(theta) scale is dropped here, as normalising removes it anyway
+	__m128 blend = _mm_add_ps(
+		_mm_mul_ps(_mm_loadu_ps(&from.x), _mm_set1_ps(aScale)),
+		_mm_mul_ps(_mm_loadu_ps(&to.x), _mm_set1_ps(bScale)));
+
+	Quaternion q;
+	_mm_storeu_ps(&q.x, SIMD::Normalise(blend));
+	return q;
+#else
 	Quaternion q = (from * aScale) + (to * bScale);
 
 	q *= 1.0f / sin(theta);
 
 	q.Normalise();
 	return q;
+#endif
 }
 
 //http://en.wikipedia.org/wiki/Conversion_between_quaternions_and_Euler_angles
@@ -220,6 +235,21 @@ Quaternion Quaternion::AxisAngleToQuaterion(const Vector3& vector, float degrees
 
 
 Vector3		Quaternion::operator *(const Vector3 &a)	const {
+#ifdef NCL_MATHS_SSE
+	//v' = v + 2w(q x v) + 2(q x (q x v)), which skips the two full quaternion products
+	__m128 q	= _mm_loadu_ps(&x);
+	__m128 v	= SIMD::Load3(a.array);
+	__m128 t	= SIMD::Cross(q, v);
+	t			= _mm_add_ps(t, t);
+
+	__m128 result = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3)), t));
+	result = _mm_add_ps(result, SIMD::Cross(q, t));
+
+	Vector3 out;
+	SIMD::Store3(out.array, result);
+	return out;
+#else
 	Quaternion newVec = *this * Quaternion(a.x, a.y, a.z, 0.0f) * Conjugate();
 	return Vector3(newVec.x, newVec.y, newVec.z);
+#endif
 }
\ No newline at end of file
@@ -60,12 +60,33 @@ namespace NCL::Maths {
 		}
 
 		inline Quaternion  operator *(const Quaternion &b)	const {
+#ifdef NCL_MATHS_SSE
+			__m128 qa = _mm_loadu_ps(&x);
+			__m128 qb = _mm_loadu_ps(&b.x);
+			const __m128 flipW = _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f);
+
+			__m128 r = _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(3, 3, 3, 3)), qb);
+			r = _mm_add_ps(r, _mm_xor_ps(flipW, _mm_mul_ps(
+				_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(0, 2, 1, 0)),
+				_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(0, 3, 3, 3)))));
+			r = _mm_add_ps(r, _mm_xor_ps(flipW, _mm_mul_ps(
+				_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(1, 0, 2, 1)),
+				_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(1, 1, 0, 2)))));
+			r = _mm_sub_ps(r, _mm_mul_ps(
+				_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(2, 1, 0, 2)),
+				_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(2, 0, 2, 1))));
+
+			Quaternion out;
+			_mm_storeu_ps(&out.x, r);
+			return out;
+#else
 			return Quaternion(
 				(x * b.w) + (w * b.x) + (y * b.z) - (z * b.y),
 				(y * b.w) + (w * b.y) + (z * b.x) - (x * b.z),
 				(z * b.w) + (w * b.z) + (x * b.y) - (y * b.x),
 				(w * b.w) - (x * b.x) - (y * b.y) - (z * b.z)
 			);
+#endif
 		}
 
 		Vector3		operator *(const Vector3 &a)	const;
@@ -0,0 +1,79 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+
+/*
+Picks which instruction set the float maths types are built with. Every x64
+CPU has SSE2, so that is the default. Building with USE_AVX2 turned on in CMake
+(which passes /arch:AVX2 or -mavx2 -mfma) adds the 256 bit and fused multiply
+add paths on top. Defining NCL_MATHS_SCALAR (USE_SCALAR_MATHS in CMake) turns it
+all off, leaving just the plain template code in Vector.h / Matrix.h.
+*/
+#if !defined(NCL_MATHS_SCALAR) && (defined(_M_X64) || defined(__SSE2__))
+    #define NCL_MATHS_SSE
+    #include <emmintrin.h>
+
+    #if defined(__AVX2__)
+        #define NCL_MATHS_AVX2
+        #include <immintrin.h>
+    #endif
+#endif
+
+#ifdef NCL_MATHS_SSE
+namespace NCL::Maths::SIMD {
+    //Loads x, y, z into the bottom of a register, with 0 in w
+    inline __m128 Load3(const float* v) {
+        __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)v);
+        return _mm_movelh_ps(xy, _mm_load_ss(v + 2));
+    }
+
+    inline void Store3(float* out, __m128 v) {
+        _mm_storel_pi((__m64*)out, v);
+        _mm_store_ss(out + 2, _mm_movehl_ps(v, v));
+    }
+
+    //a * b + c
+    inline __m128 MulAdd(__m128 a, __m128 b, __m128 c) {
+#if defined(NCL_MATHS_AVX2) && (defined(__FMA__) || defined(_MSC_VER))
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    //Adds all 4 elements together, and puts the result in every element
+    inline __m128 HorizontalSum(__m128 v) {
+        __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuf);
+        shuf = _mm_movehl_ps(shuf, sums);
+        sums = _mm_add_ss(sums, shuf);
+        return _mm_shuffle_ps(sums, sums, 0);
+    }
+
+    inline __m128 Dot4(__m128 a, __m128 b) {
+        return HorizontalSum(_mm_mul_ps(a, b));
+    }
+
+    //Scales v to unit length, leaving zero length vectors as all zeros
+    inline __m128 Normalise(__m128 v) {
+        __m128 length   = _mm_sqrt_ps(Dot4(v, v));
+        __m128 nonZero  = _mm_cmpgt_ps(length, _mm_setzero_ps());
+        __m128 scaled   = _mm_mul_ps(v, _mm_div_ps(_mm_set1_ps(1.0f), length));
+        return _mm_and_ps(scaled, nonZero);
+    }
+
+    //Cross product of the xyz parts - w comes out as 0
+    inline __m128 Cross(__m128 a, __m128 b) {
+        __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c    = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+}
+#endif
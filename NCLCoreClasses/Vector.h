@@ -8,6 +8,7 @@ https://research.ncl.ac.uk/game/
 */
 #pragma once
 #include <algorithm>
+#include <cmath>
 
 namespace NCL::Maths {
 
@@ -51,10 +52,10 @@ namespace NCL::Maths {
             };
         };
 
-        VectorTemplate<T, 2>() : x(0), y(0) {
+        VectorTemplate() : x(0), y(0) {
         }
 
-        VectorTemplate<T, 2>(T inX, T inY) : x(inX), y(inY) {
+        VectorTemplate(T inX, T inY) : x(inX), y(inY) {
         }
 
         //VectorTemplate<T, 2>(VectorTemplate<T, 3> v) : x(v[0]), y(v[1]) {
@@ -79,16 +80,16 @@ namespace NCL::Maths {
             };
         };
 
-        VectorTemplate<T, 3>() : x(0), y(0), z(0) {
+        VectorTemplate() : x(0), y(0), z(0) {
         }
 
-        VectorTemplate<T, 3>(T inX, T inY, T inZ) : x(inX), y(inY), z(inZ) {
+        VectorTemplate(T inX, T inY, T inZ) : x(inX), y(inY), z(inZ) {
         }
 
-        VectorTemplate<T, 3>(VectorTemplate<T, 2> v, T inZ) : x(v.array[0]), y(v.array[1]), z(inZ) {
+        VectorTemplate(VectorTemplate<T, 2> v, T inZ) : x(v.array[0]), y(v.array[1]), z(inZ) {
         }
 
-        VectorTemplate<T, 3>(VectorTemplate<T, 4> v) : x(v[0]), y(v[1]), z(v[2]) {
+        VectorTemplate(VectorTemplate<T, 4> v) : x(v[0]), y(v[1]), z(v[2]) {
         }
 
         T operator[](int i) const {
@@ -111,16 +112,16 @@ namespace NCL::Maths {
             };
         };
 
-        VectorTemplate<T, 4>() : x(0), y(0), z(0), w(0) {
+        VectorTemplate() : x(0), y(0), z(0), w(0) {
         }
 
-        VectorTemplate<T, 4>(T inX, T inY, T inZ, T inW) : x(inX), y(inY), z(inZ), w(inW) {
+        VectorTemplate(T inX, T inY, T inZ, T inW) : x(inX), y(inY), z(inZ), w(inW) {
         }
 
-        VectorTemplate<T, 4>(VectorTemplate<T, 2> v, T inZ, T inW) : x(v.array[0]), y(v.array[1]), z(inZ), w(inW) {
+        VectorTemplate(VectorTemplate<T, 2> v, T inZ, T inW) : x(v.array[0]), y(v.array[1]), z(inZ), w(inW) {
         }
 
-        VectorTemplate<T, 4>(VectorTemplate<T, 3> v, T inW) : x(v.array[0]), y(v.array[1]), z(v.array[2]), w(inW) {
+        VectorTemplate(VectorTemplate<T, 3> v, T inW) : x(v.array[0]), y(v.array[1]), z(v.array[2]), w(inW) {
         }
 
         T operator[](int i) const {
@@ -342,3 +343,5 @@ namespace NCL::Maths {
         return o;
     }
 }
+
+#include "VectorSIMD.h"
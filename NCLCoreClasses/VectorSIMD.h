@@ -0,0 +1,107 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include "SIMD.h"
+
+/*
+SSE versions of the float vector operations. These are plain overloads rather
+than template specialisations, so the compiler prefers them over the generic
+templates in Vector.h whenever the types match exactly. Vector4 maps straight
+onto a register; Vector3 only gets the operations that do enough work to be
+worth the partial loads and stores (cross product and normalisation).
+*/
+#ifdef NCL_MATHS_SSE
+namespace NCL::Maths {
+    inline Vector4 operator+(const Vector4& a, const Vector4& b) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_add_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return answer;
+    }
+
+    inline Vector4 operator-(const Vector4& a, const Vector4& b) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_sub_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return answer;
+    }
+
+    inline Vector4 operator-(const Vector4& a) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_xor_ps(_mm_loadu_ps(a.array), _mm_set1_ps(-0.0f)));
+        return answer;
+    }
+
+    inline Vector4 operator*(const Vector4& a, const Vector4& b) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_mul_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return answer;
+    }
+
+    inline Vector4 operator/(const Vector4& a, const Vector4& b) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_div_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return answer;
+    }
+
+    inline Vector4 operator*(const Vector4& a, const float& b) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_mul_ps(_mm_loadu_ps(a.array), _mm_set1_ps(b)));
+        return answer;
+    }
+
+    inline Vector4 operator/(const Vector4& a, const float& b) {
+        Vector4 answer;
+        _mm_storeu_ps(answer.array, _mm_div_ps(_mm_loadu_ps(a.array), _mm_set1_ps(b)));
+        return answer;
+    }
+
+    inline Vector4& operator+=(Vector4& a, const Vector4& b) {
+        _mm_storeu_ps(a.array, _mm_add_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return a;
+    }
+
+    inline Vector4& operator-=(Vector4& a, const Vector4& b) {
+        _mm_storeu_ps(a.array, _mm_sub_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return a;
+    }
+
+    inline Vector4& operator*=(Vector4& a, const Vector4& b) {
+        _mm_storeu_ps(a.array, _mm_mul_ps(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        return a;
+    }
+
+    inline Vector4& operator*=(Vector4& a, const float& b) {
+        _mm_storeu_ps(a.array, _mm_mul_ps(_mm_loadu_ps(a.array), _mm_set1_ps(b)));
+        return a;
+    }
+
+    namespace Vector {
+        inline Vector3 Cross(const Vector3& a, const Vector3& b) {
+            Vector3 result;
+            SIMD::Store3(result.array, SIMD::Cross(SIMD::Load3(a.array), SIMD::Load3(b.array)));
+            return result;
+        }
+
+        inline float Dot(const Vector4& a, const Vector4& b) {
+            return _mm_cvtss_f32(SIMD::Dot4(_mm_loadu_ps(a.array), _mm_loadu_ps(b.array)));
+        }
+
+        inline Vector3 Normalise(const Vector3& a) {
+            Vector3 result;
+            SIMD::Store3(result.array, SIMD::Normalise(SIMD::Load3(a.array)));
+            return result;
+        }
+
+        inline Vector4 Normalise(const Vector4& a) {
+            Vector4 result;
+            _mm_storeu_ps(result.array, SIMD::Normalise(_mm_loadu_ps(a.array)));
+            return result;
+        }
+    }
+}
+#endif
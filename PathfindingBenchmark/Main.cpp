@@ -0,0 +1,492 @@
+/*
+Times NavigationGrid searches on large generated grids, with no window or
+renderer, and reports how fast they went.
+
+	PathfindingBenchmark [--size n,n...] [--searches n] [--mode name,name...]
+	                     [--diagonal] [--cluster-size n] [--agents n,n...]
+	                     [--updates n] [--json file]
+
+Three kinds of grid are built at each size: a maze like the one TutorialGame
+carves out, all one cell wide corridors, a field with a quarter of its cells
+walled off at random, and open ground with only the odd wall. Each is
+searched with every mode (astar, jps, jpsplus and hpa, unless told
+otherwise), moving in 4 directions, or 8 with --diagonal. The same random
+start and end points are searched on every run, so results can be compared
+between builds.
+
+Modes that precompute something are also timed setting it up, and then
+bringing it up to date after a single node has changed. Hierarchical
+searches are timed only up to the point the path could start being walked,
+with the time to fill the rest in given separately.
+
+The flow mode has a goal wander about each grid, a node at a time, with a
+crowd of agents (1 and 1000, unless told otherwise) chasing it through a
+FlowField. The field is timed catching up with each move, separately from
+all the agents reading their next steps, and then built from scratch for
+comparison.
+
+Results are written as JSON to the given file (or to stdout for "-").
+*/
+#include "NavigationGrid.h"
+#include "GridClusterGraph.h"
+#include "FlowField.h"
+
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <set>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	struct Options {
+		std::vector<int>	sizes		= { 512, 1024 };
+		int					searches	= 200;
+		bool				diagonal	= false;
+		int					clusterSize	= 16;
+		int					updates		= 100;
+		std::vector<int>	agents		= { 1, 1000 };
+		std::string			jsonFile;
+		std::set<std::string> modes;
+	};
+
+	struct ModeInfo {
+		const char*					name;
+		NavigationGrid::SearchMode	mode;
+	};
+
+	const ModeInfo modes[] = {
+		{ "astar",		NavigationGrid::SearchMode::AStar },
+		{ "jps",		NavigationGrid::SearchMode::JumpPoint },
+		{ "jpsplus",	NavigationGrid::SearchMode::JumpPointPlus },
+		{ "hpa",		NavigationGrid::SearchMode::Hierarchical },
+	};
+
+	struct GridLayout {
+		std::string			name;
+		int					width	= 0;
+		int					height	= 0;
+		std::vector<char>	types;
+	};
+
+	//Corridors carved out of solid wall by a depth first walk - every open cell can reach every other
+	GridLayout MakeMaze(int size, std::mt19937& random) {
+		int cells = std::max(1, (size - 1) / 2);
+
+		GridLayout layout;
+		layout.name		= "maze";
+		layout.width	= cells * 2 + 1;
+		layout.height	= cells * 2 + 1;
+		layout.types.assign(layout.width * layout.height, 'x');
+
+		std::vector<bool> visited(cells * cells, false);
+		std::vector<std::pair<int, int>> stack = { { 0, 0 } };
+		visited[0] = true;
+		layout.types[layout.width + 1] = '.';
+
+		const int dx[4] = { 1, -1, 0, 0 };
+		const int dz[4] = { 0, 0, 1, -1 };
+
+		while (!stack.empty()) {
+			auto [cx, cz] = stack.back();
+			int options[4];
+			int optionCount = 0;
+			for (int i = 0; i < 4; ++i) {
+				int nx = cx + dx[i];
+				int nz = cz + dz[i];
+				if (nx >= 0 && nz >= 0 && nx < cells && nz < cells && !visited[nz * cells + nx]) {
+					options[optionCount++] = i;
+				}
+			}
+			if (optionCount == 0) {
+				stack.pop_back();
+				continue;
+			}
+			int dir = options[random() % optionCount];
+			int nx	= cx + dx[dir];
+			int nz	= cz + dz[dir];
+			layout.types[(cz * 2 + 1 + dz[dir]) * layout.width + cx * 2 + 1 + dx[dir]] = '.';
+			layout.types[(nz * 2 + 1) * layout.width + nx * 2 + 1] = '.';
+			visited[nz * cells + nx] = true;
+			stack.emplace_back(nx, nz);
+		}
+		return layout;
+	}
+
+	//Walls scattered at random, one cell in every 'spacing' on average
+	GridLayout MakeField(const std::string& name, int size, int spacing, std::mt19937& random) {
+		GridLayout layout;
+		layout.name		= name;
+		layout.width	= size;
+		layout.height	= size;
+		layout.types.resize(size * size);
+		for (char& type : layout.types) {
+			type = random() % spacing == 0 ? 'x' : '.';
+		}
+		return layout;
+	}
+
+	struct Result {
+		std::string grid;
+		std::string mode;
+		bool	diagonal	= false;
+		int		width		= 0;
+		int		height		= 0;
+		int		searches	= 0;
+		int		found		= 0;
+		double	totalMicros	= 0.0;
+		double	maxMicros	= 0.0;
+		double	refineMicros	= 0.0;
+		double	nodesExpanded	= 0.0;
+		double	waypoints		= 0.0;
+		double	setupMillis		= 0.0;
+		double	editMicros		= 0.0;
+	};
+
+	struct FlowResult {
+		std::string grid;
+		bool	diagonal		= false;
+		int		width			= 0;
+		int		height			= 0;
+		int		agents			= 0;
+		int		updates			= 0;
+		int		incremental		= 0;
+		int		arrivals		= 0;
+		double	fieldMicros		= 0.0;
+		double	stepMicros		= 0.0;
+		double	nodesVisited	= 0.0;
+		double	rebuildMicros	= 0.0;
+	};
+
+	double MicrosSince(std::chrono::high_resolution_clock::time_point start) {
+		return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	Result RunSearches(const GridLayout& layout, const ModeInfo& mode, const NavigationGrid& grid, const std::vector<std::pair<Vector3, Vector3>>& queries) {
+		Result result;
+		result.grid		= layout.name;
+		result.mode		= mode.name;
+		result.diagonal	= grid.GetDiagonalMovement();
+		result.width	= layout.width;
+		result.height	= layout.height;
+
+		GridSearchContext context;
+		NavigationPath path;
+		HierarchicalPath hierarchicalPath;
+		bool hierarchical = mode.mode == NavigationGrid::SearchMode::Hierarchical;
+
+		for (const auto& [from, to] : queries) {
+			path.Clear();
+			auto start = std::chrono::high_resolution_clock::now();
+			bool found = hierarchical ?
+				grid.FindPath(from, to, hierarchicalPath, context) :
+				grid.FindPath(from, to, path, context);
+			double micros = MicrosSince(start);
+
+			result.searches++;
+			result.totalMicros	+= micros;
+			result.maxMicros	= std::max(result.maxMicros, micros);
+			result.nodesExpanded += context.GetNodesExpanded();
+			if (!found) {
+				continue;
+			}
+			result.found++;
+			Vector3 waypoint;
+			if (hierarchical) {
+				start = std::chrono::high_resolution_clock::now();
+				while (hierarchicalPath.PopWaypoint(waypoint)) {
+					result.waypoints++;
+				}
+				result.refineMicros += MicrosSince(start);
+			}
+			while (path.PopWaypoint(waypoint)) {
+				result.waypoints++;
+			}
+		}
+		return result;
+	}
+
+	//The goal steps to a random floor node next to it each update, and every agent takes one step after it
+	FlowResult RunFlowField(const GridLayout& layout, const NavigationGrid& grid, const std::vector<int>& openCells, int agentCount, int updates, std::mt19937& random) {
+		FlowResult result;
+		result.grid		= layout.name;
+		result.diagonal	= grid.GetDiagonalMovement();
+		result.width	= layout.width;
+		result.height	= layout.height;
+		result.agents	= agentCount;
+
+		auto PositionOf = [&](int node) {
+			return Vector3((float)(node % layout.width), 0, (float)(node / layout.width));
+		};
+
+		std::vector<int> agents;
+		for (int i = 0; i < agentCount; ++i) {
+			agents.push_back(openCells[random() % openCells.size()]);
+		}
+		int goal = openCells[random() % openCells.size()];
+
+		FlowField field(grid);
+		field.SetGoal(PositionOf(goal));
+
+		const int dx[4] = { 1, -1, 0, 0 };
+		const int dz[4] = { 0, 0, 1, -1 };
+
+		for (int update = 0; update < updates; ++update) {
+			int dir = random() % 4;
+			int gx	= (goal % layout.width) + dx[dir];
+			int gz	= (goal / layout.width) + dz[dir];
+			if (grid.IsWalkable(gx, gz)) {
+				goal = (gz * layout.width) + gx;
+			}
+
+			auto start = std::chrono::high_resolution_clock::now();
+			field.SetGoal(PositionOf(goal));
+			result.fieldMicros	+= MicrosSince(start);
+			result.nodesVisited	+= field.GetNodesVisited();
+			result.incremental	+= field.LastUpdateWasIncremental() ? 1 : 0;
+
+			start = std::chrono::high_resolution_clock::now();
+			for (int& agent : agents) {
+				Vector3 next;
+				if (field.GetNextStep(PositionOf(agent), next)) {
+					agent = ((int)next.z * layout.width) + (int)next.x;
+				}
+			}
+			result.stepMicros += MicrosSince(start);
+			result.updates++;
+		}
+		for (int agent : agents) {
+			if (agent == goal) {
+				result.arrivals++;
+			}
+		}
+
+		const int rebuilds = 3;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < rebuilds; ++i) {
+			field.Rebuild();
+		}
+		result.rebuildMicros = MicrosSince(start) / rebuilds;
+		return result;
+	}
+
+	void WriteJSON(std::ostream& out, const std::vector<Result>& results, const std::vector<FlowResult>& flowResults) {
+		out << std::fixed << std::setprecision(3);
+		out << "{\n";
+		out << "\t\"results\": [\n";
+		for (size_t r = 0; r < results.size(); ++r) {
+			const Result& result = results[r];
+			double searches = std::max(1, result.searches);
+
+			out << "\t\t{ "
+				<< "\"grid\": \"" << result.grid << "\", "
+				<< "\"mode\": \"" << result.mode << "\", "
+				<< "\"diagonal\": " << (result.diagonal ? "true" : "false") << ", "
+				<< "\"width\": " << result.width << ", "
+				<< "\"height\": " << result.height << ", "
+				<< "\"searches\": " << result.searches << ", "
+				<< "\"found\": " << result.found << ", "
+				<< "\"searchesPerSecond\": " << (result.totalMicros > 0.0 ? result.searches * 1000000.0 / result.totalMicros : 0.0) << ", "
+				<< "\"meanMicros\": " << result.totalMicros / searches << ", "
+				<< "\"maxMicros\": " << result.maxMicros << ", "
+				<< "\"meanRefineMicros\": " << result.refineMicros / std::max(1, result.found) << ", "
+				<< "\"meanNodesExpanded\": " << result.nodesExpanded / searches << ", "
+				<< "\"meanWaypoints\": " << result.waypoints / std::max(1, result.found) << ", "
+				<< "\"setupMillis\": " << result.setupMillis << ", "
+				<< "\"editMicros\": " << result.editMicros << " }"
+				<< (r + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "\t],\n";
+		out << "\t\"flowFields\": [\n";
+		for (size_t r = 0; r < flowResults.size(); ++r) {
+			const FlowResult& result = flowResults[r];
+			double updates = std::max(1, result.updates);
+
+			out << "\t\t{ "
+				<< "\"grid\": \"" << result.grid << "\", "
+				<< "\"diagonal\": " << (result.diagonal ? "true" : "false") << ", "
+				<< "\"width\": " << result.width << ", "
+				<< "\"height\": " << result.height << ", "
+				<< "\"agents\": " << result.agents << ", "
+				<< "\"updates\": " << result.updates << ", "
+				<< "\"incrementalUpdates\": " << result.incremental << ", "
+				<< "\"meanFieldMicros\": " << result.fieldMicros / updates << ", "
+				<< "\"meanStepMicros\": " << result.stepMicros / updates << ", "
+				<< "\"meanUpdateMicros\": " << (result.fieldMicros + result.stepMicros) / updates << ", "
+				<< "\"meanNodesVisited\": " << result.nodesVisited / updates << ", "
+				<< "\"rebuildMicros\": " << result.rebuildMicros << ", "
+				<< "\"arrivals\": " << result.arrivals << " }"
+				<< (r + 1 < flowResults.size() ? "," : "") << "\n";
+		}
+		out << "\t]\n";
+		out << "}\n";
+	}
+
+	void PrintSummary(std::ostream& out, const Result& result) {
+		double searches = std::max(1, result.searches);
+		out << std::left << std::setw(6) << result.grid << " " << std::setw(8) << result.mode << std::right << std::fixed
+			<< std::setw(5) << result.width << "x" << std::setw(5) << std::left << result.height << std::right
+			<< std::setprecision(1)
+			<< std::setw(10) << result.totalMicros / searches << "us/search "
+			<< std::setw(10) << result.maxMicros << "us max "
+			<< std::setw(10) << result.nodesExpanded / searches << " expanded "
+			<< std::setw(5) << result.found << "/" << result.searches << " found";
+		if (result.setupMillis > 0.0) {
+			out << std::setw(10) << result.setupMillis << "ms setup " << std::setw(10) << result.editMicros << "us per edit";
+		}
+		out << "\n";
+	}
+
+	void PrintFlowSummary(std::ostream& out, const FlowResult& result) {
+		double updates = std::max(1, result.updates);
+		out << std::left << std::setw(6) << result.grid << " " << std::setw(8) << "flow" << std::right << std::fixed
+			<< std::setw(5) << result.width << "x" << std::setw(5) << std::left << result.height << std::right
+			<< std::setprecision(1)
+			<< std::setw(6) << result.agents << " agents "
+			<< std::setw(10) << (result.fieldMicros + result.stepMicros) / updates << "us/update ("
+			<< result.fieldMicros / updates << " field, "
+			<< result.stepMicros / updates << " steps) "
+			<< std::setw(10) << result.nodesVisited / updates << " visited "
+			<< std::setw(10) << result.rebuildMicros << "us rebuild\n";
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			if (arg == "--diagonal") {
+				options.diagonal = true;
+			}
+			else if (i + 1 >= argc) {
+				return false;
+			}
+			else if (arg == "--searches") {
+				options.searches = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--updates") {
+				options.updates = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--agents") {
+				options.agents.clear();
+				std::stringstream counts(argv[++i]);
+				std::string count;
+				while (std::getline(counts, count, ',')) {
+					options.agents.push_back(std::max(1, std::atoi(count.c_str())));
+				}
+			}
+			else if (arg == "--cluster-size") {
+				options.clusterSize = std::max(2, std::atoi(argv[++i]));
+			}
+			else if (arg == "--json") {
+				options.jsonFile = argv[++i];
+			}
+			else if (arg == "--mode") {
+				std::stringstream names(argv[++i]);
+				std::string name;
+				while (std::getline(names, name, ',')) {
+					options.modes.insert(name);
+				}
+			}
+			else if (arg == "--size") {
+				options.sizes.clear();
+				std::stringstream sizes(argv[++i]);
+				std::string size;
+				while (std::getline(sizes, size, ',')) {
+					options.sizes.push_back(std::max(3, std::atoi(size.c_str())));
+				}
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::cerr << "Usage: " << argv[0] << " [--size n,n...] [--searches n] [--mode astar,jps,jpsplus,hpa,flow] [--diagonal] [--cluster-size n] [--agents n,n...] [--updates n] [--json file]\n";
+		return 1;
+	}
+
+	bool jsonToStdout = options.jsonFile == "-";
+	std::ostream& log = jsonToStdout ? std::cerr : std::cout;
+
+	std::vector<Result> results;
+	std::vector<FlowResult> flowResults;
+	for (int size : options.sizes) {
+		std::mt19937 random(size);
+		GridLayout layouts[] = { MakeMaze(size, random), MakeField("field", size, 4, random), MakeField("open", size, 50, random) };
+
+		for (const GridLayout& layout : layouts) {
+			NavigationGrid grid(layout.width, layout.height, 1, layout.types);
+			grid.SetDiagonalMovement(options.diagonal);
+
+			std::vector<int> openCells;
+			for (int i = 0; i < (int)layout.types.size(); ++i) {
+				if (layout.types[i] != 'x') {
+					openCells.push_back(i);
+				}
+			}
+
+			std::vector<std::pair<Vector3, Vector3>> queries;
+			for (int i = 0; i < options.searches; ++i) {
+				int from	= openCells[random() % openCells.size()];
+				int to		= openCells[random() % openCells.size()];
+				queries.emplace_back(
+					Vector3((float)(from % layout.width), 0, (float)(from / layout.width)),
+					Vector3((float)(to % layout.width), 0, (float)(to / layout.width)));
+			}
+
+			for (const ModeInfo& mode : modes) {
+				if (!options.modes.empty() && !options.modes.count(mode.name)) {
+					continue;
+				}
+				auto setupStart = std::chrono::high_resolution_clock::now();
+				if (mode.mode == NavigationGrid::SearchMode::Hierarchical) {
+					grid.BuildClusterGraph(options.clusterSize);
+				}
+				grid.SetSearchMode(mode.mode);
+				double setupMicros = MicrosSince(setupStart);
+
+				results.push_back(RunSearches(layout, mode, grid, queries));
+				Result& result = results.back();
+
+				//Walls off a node in the middle of the grid, times catching up with it, then puts it back
+				if (mode.mode == NavigationGrid::SearchMode::JumpPointPlus || mode.mode == NavigationGrid::SearchMode::Hierarchical) {
+					int node = openCells[openCells.size() / 2];
+					grid.SetNodeType(node % layout.width, node / layout.width, 'x');
+					auto editStart = std::chrono::high_resolution_clock::now();
+					grid.SetSearchMode(mode.mode);
+					result.editMicros	= MicrosSince(editStart);
+					result.setupMillis	= setupMicros / 1000.0;
+
+					grid.SetNodeType(node % layout.width, node / layout.width, '.');
+					grid.SetSearchMode(mode.mode);
+				}
+				PrintSummary(log, result);
+			}
+
+			if (options.modes.empty() || options.modes.count("flow")) {
+				for (int agentCount : options.agents) {
+					flowResults.push_back(RunFlowField(layout, grid, openCells, agentCount, options.updates, random));
+					PrintFlowSummary(log, flowResults.back());
+				}
+			}
+		}
+	}
+
+	if (jsonToStdout) {
+		WriteJSON(std::cout, results, flowResults);
+	}
+	else if (!options.jsonFile.empty()) {
+		std::ofstream file(options.jsonFile);
+		if (!file) {
+			std::cerr << "Couldn't write " << options.jsonFile << "\n";
+			return 1;
+		}
+		WriteJSON(file, results, flowResults);
+	}
+	return 0;
+}
@@ -0,0 +1,664 @@
+/*
+Runs the physics engine on its own, with no window or renderer, over a set
+of scripted scenes - the same kinds of scene TutorialGame builds - for a
+fixed number of steps each, and reports how fast it went.
+
+	PhysicsBenchmark [--steps n] [--scenario name,name...] [--threads n]
+	                 [--broadphase tree,sap,quadtree] [--size n,n...]
+	                 [--links n] [--enemies n] [--bodies n] [--no-sleep] [--json file]
+
+Every scene is stepped in deterministic mode, so each update is exactly one
+fixed step, and a run always does the same work whatever machine it's on.
+Each scene is run once per broadphase and size given - the grids are size
+by size, so "--scenario sphere_grid --broadphase tree,sap,quadtree --size
+32,100,224" compares all three broadphases at about 1k, 10k and 50k bodies.
+The integrate scene has --bodies bodies (100k by default) instead.
+A negative thread count uses every hardware thread, and 0 runs the physics
+on the calling thread only. Results are written as JSON to the given file
+(or to stdout for "-"), for comparing one build against another.
+*/
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsSystem.h"
+#include "PhysicsObject.h"
+#include "AABBVolume.h"
+#include "SphereVolume.h"
+#include "PositionConstraint.h"
+#include "JobSystem.h"
+
+#include <climits>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <queue>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const float StepTime = 1.0f / 120.0f;
+
+	//The same layers TutorialGame puts its objects on
+	const unsigned int LayerMaze	= 2;
+	const unsigned int LayerEnemy	= 8;
+
+	struct Options {
+		int			steps		= 1000;
+		int			threads		= -1;
+		int			gridSize	= 20;
+		std::vector<int>		gridSizes	= { 20 };
+		std::set<std::string>	broadPhases	= { "tree" };
+		int			bridgeLinks	= 200;
+		int			enemies		= 64;
+		int			bodies		= 100000;
+		bool		sleeping	= true;
+		std::string jsonFile;
+		std::set<std::string> scenarios;
+	};
+
+	//Both in kilobytes. Peak is over the whole run so far, not just the current scene
+	struct MemoryUsage {
+		size_t current	= 0;
+		size_t peak		= 0;
+	};
+
+	MemoryUsage GetMemoryUsage() {
+		MemoryUsage usage;
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			usage.current	= counters.WorkingSetSize / 1024;
+			usage.peak		= counters.PeakWorkingSetSize / 1024;
+		}
+#else
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line)) {
+			if (line.compare(0, 6, "VmRSS:") == 0) {
+				usage.current = std::stoul(line.substr(6));
+			}
+			else if (line.compare(0, 6, "VmHWM:") == 0) {
+				usage.peak = std::stoul(line.substr(6));
+			}
+		}
+#endif
+		return usage;
+	}
+
+	/*
+	Everything a scene needs while it's being built and run. Scenes that
+	drive their objects about (the maze's enemies) set preStep, which is
+	called before every update, just as the game would between frames.
+	*/
+	struct Scene {
+		GameWorld&		world;
+		const Options&	options;
+		std::mt19937	random;
+		std::function<void()> preStep;
+
+		Scene(GameWorld& w, const Options& o) : world(w), options(o), random(12345) {
+		}
+
+		GameObject* AddFloor(const Vector3& position, const Vector3& halfSize) {
+			GameObject* floor = new GameObject("Floor");
+			floor->SetBoundingVolume(new AABBVolume(halfSize));
+			floor->GetTransform()
+				.SetScale(halfSize * 2.0f)
+				.SetPosition(position);
+
+			floor->SetPhysicsObject(new PhysicsObject(floor->GetTransform(), floor->GetBoundingVolume()));
+			floor->GetPhysicsObject()->SetInverseMass(0);
+			floor->GetPhysicsObject()->InitCubeInertia();
+
+			floor->SetCollisionLayer(LayerMaze);
+			world.AddStaticObject(floor);
+			return floor;
+		}
+
+		GameObject* AddSphere(const Vector3& position, float radius, float inverseMass) {
+			GameObject* sphere = new GameObject("Sphere");
+			sphere->SetBoundingVolume(new SphereVolume(radius));
+			sphere->GetTransform()
+				.SetScale(Vector3(radius, radius, radius))
+				.SetPosition(position);
+
+			sphere->SetPhysicsObject(new PhysicsObject(sphere->GetTransform(), sphere->GetBoundingVolume()));
+			sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+			sphere->GetPhysicsObject()->InitSphereInertia();
+
+			world.AddGameObject(sphere);
+			return sphere;
+		}
+
+		GameObject* AddCube(const Vector3& position, const Vector3& halfSize, float inverseMass, bool isStatic = false) {
+			GameObject* cube = new GameObject("Cube");
+			cube->SetBoundingVolume(new AABBVolume(halfSize));
+			cube->GetTransform()
+				.SetPosition(position)
+				.SetScale(halfSize * 2.0f);
+
+			cube->SetPhysicsObject(new PhysicsObject(cube->GetTransform(), cube->GetBoundingVolume()));
+			cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+			cube->GetPhysicsObject()->InitCubeInertia();
+
+			if (isStatic) {
+				cube->SetCollisionLayer(LayerMaze);
+				world.AddStaticObject(cube);
+			}
+			else {
+				world.AddGameObject(cube);
+			}
+			return cube;
+		}
+	};
+
+	void BuildSphereGrid(Scene& scene) {
+		int size = scene.options.gridSize;
+		for (int x = 0; x < size; ++x) {
+			for (int z = 0; z < size; ++z) {
+				scene.AddSphere(Vector3(x * 2.0f, 10.0f + (x + z) % 3, z * 2.0f), 0.5f, 1.0f);
+			}
+		}
+		scene.AddFloor(Vector3(size, -2, size), Vector3(size + 10.0f, 2, size + 10.0f));
+	}
+
+	void BuildMixedGrid(Scene& scene) {
+		int size = scene.options.gridSize;
+		for (int x = 0; x < size; ++x) {
+			for (int z = 0; z < size; ++z) {
+				Vector3 position(x * 3.0f, 10.0f, z * 3.0f);
+				if (scene.random() % 2) {
+					scene.AddCube(position, Vector3(1, 1, 1), 1.0f);
+				}
+				else {
+					scene.AddSphere(position, 1.0f, 1.0f);
+				}
+			}
+		}
+		scene.AddFloor(Vector3(size * 1.5f, -2, size * 1.5f), Vector3(size * 1.5f + 10.0f, 2, size * 1.5f + 10.0f));
+	}
+
+	//Stacked a few high, so the solver has resting contacts to work through, not just the floor
+	void BuildAABBGrid(Scene& scene) {
+		int size = scene.options.gridSize;
+		for (int x = 0; x < size; ++x) {
+			for (int z = 0; z < size; ++z) {
+				for (int y = 0; y < 3; ++y) {
+					scene.AddCube(Vector3(x * 2.5f, 1.0f + y * 2.1f, z * 2.5f), Vector3(1, 1, 1), 1.0f);
+				}
+			}
+		}
+		scene.AddFloor(Vector3(size * 1.25f, -2, size * 1.25f), Vector3(size * 1.25f + 10.0f, 2, size * 1.25f + 10.0f));
+	}
+
+	//A chain of cubes hung between two fixed ones, as in TutorialGame::BridgeConstraintTest
+	void BuildBridge(Scene& scene) {
+		int		links		= scene.options.bridgeLinks;
+		float	spacing		= 2.0f;
+		Vector3 halfSize	= Vector3(0.5f, 0.5f, 0.5f);
+		Vector3 start		= Vector3(0, 30, 0);
+
+		GameObject* first	= scene.AddCube(start, halfSize, 0.0f);
+		GameObject* last	= scene.AddCube(start + Vector3((links + 1) * spacing, 0, 0), halfSize, 0.0f);
+		GameObject* previous = first;
+
+		for (int i = 0; i < links; ++i) {
+			GameObject* block = scene.AddCube(start + Vector3((i + 1) * spacing, 0, 0), halfSize, 1.0f);
+			scene.world.AddConstraint(new PositionConstraint(previous, block, spacing));
+			previous = block;
+		}
+		scene.world.AddConstraint(new PositionConstraint(previous, last, spacing));
+	}
+
+	/*
+	A maze of static walls, with enemies chasing a target round it. Rather
+	than every enemy searching for its own path, the distance to the target
+	is flooded out over the maze, and each enemy just heads for whichever
+	neighbouring cell is closer. The target moves to another open cell every
+	couple of seconds, so the enemies keep running about.
+	*/
+	void BuildMaze(Scene& scene) {
+		const int	cells		= std::max(2, scene.options.gridSize / 2);
+		const float cellSize	= 5.0f;
+		const float moveSpeed	= 8.0f;
+		const int	retarget	= 240;
+
+		int width = cells * 2 + 1;
+
+		//Grid of walls (1) and corridors (0), carved out by a depth first walk
+		auto maze = std::make_shared<std::vector<int>>(width * width, 1);
+		std::vector<int>& grid = *maze;
+
+		std::vector<std::pair<int, int>> stack = { { 0, 0 } };
+		std::vector<bool> visited(cells * cells, false);
+		visited[0] = true;
+		grid[width + 1] = 0;
+
+		const int dx[4] = { 1, -1, 0, 0 };
+		const int dz[4] = { 0, 0, 1, -1 };
+
+		while (!stack.empty()) {
+			auto [cx, cz] = stack.back();
+			int options[4];
+			int optionCount = 0;
+			for (int i = 0; i < 4; ++i) {
+				int nx = cx + dx[i];
+				int nz = cz + dz[i];
+				if (nx >= 0 && nz >= 0 && nx < cells && nz < cells && !visited[nz * cells + nx]) {
+					options[optionCount++] = i;
+				}
+			}
+			if (optionCount == 0) {
+				stack.pop_back();
+				continue;
+			}
+			int dir = options[scene.random() % optionCount];
+			int nx	= cx + dx[dir];
+			int nz	= cz + dz[dir];
+			grid[(cz * 2 + 1 + dz[dir]) * width + cx * 2 + 1 + dx[dir]] = 0;
+			grid[(nz * 2 + 1) * width + nx * 2 + 1] = 0;
+			visited[nz * cells + nx] = true;
+			stack.emplace_back(nx, nz);
+		}
+
+		std::vector<int> openCells;
+		for (int i = 0; i < width * width; ++i) {
+			if (grid[i]) {
+				int x = i % width;
+				int z = i / width;
+				scene.AddCube(Vector3(x * cellSize, 2.0f, z * cellSize), Vector3(cellSize * 0.5f, 2.0f, cellSize * 0.5f), 0.0f, true);
+			}
+			else {
+				openCells.push_back(i);
+			}
+		}
+		float mazeSize = width * cellSize * 0.5f;
+		scene.AddFloor(Vector3(mazeSize, -2.0f, mazeSize), Vector3(mazeSize + 10.0f, 2, mazeSize + 10.0f));
+
+		auto enemies = std::make_shared<std::vector<GameObject*>>();
+		for (int i = 0; i < scene.options.enemies; ++i) {
+			int cell = openCells[scene.random() % openCells.size()];
+			Vector3 position((cell % width) * cellSize, 3.0f, (cell / width) * cellSize);
+
+			GameObject* enemy = scene.AddCube(position, Vector3(0.9f, 2.7f, 0.9f), 0.5f);
+			enemy->SetCollisionLayer(LayerEnemy);
+			enemy->SetCollisionMask(~LayerEnemy);
+			enemies->push_back(enemy);
+		}
+
+		auto distances	= std::make_shared<std::vector<int>>();
+		auto step		= std::make_shared<int>(0);
+
+		scene.preStep = [&scene, maze, enemies, distances, step, openCells, width, cellSize, moveSpeed, retarget]() {
+			const std::vector<int>& grid = *maze;
+			std::vector<int>& distance = *distances;
+
+			if ((*step)++ % retarget == 0) {
+				int target = openCells[scene.random() % openCells.size()];
+				distance.assign(grid.size(), INT_MAX);
+				distance[target] = 0;
+
+				std::queue<int> open;
+				open.push(target);
+				const int offsets[4] = { 1, -1, width, -width };
+				while (!open.empty()) {
+					int cell = open.front();
+					open.pop();
+					for (int offset : offsets) {
+						int next = cell + offset;
+						if (!grid[next] && distance[next] == INT_MAX) {
+							distance[next] = distance[cell] + 1;
+							open.push(next);
+						}
+					}
+				}
+			}
+
+			for (GameObject* enemy : *enemies) {
+				PhysicsObject* body = enemy->GetPhysicsObject();
+				Vector3 position	= enemy->GetTransform().GetPosition();
+
+				int x = std::clamp((int)std::round(position.x / cellSize), 1, width - 2);
+				int z = std::clamp((int)std::round(position.z / cellSize), 1, width - 2);
+				int cell = z * width + x;
+
+				int best = cell;
+				for (int next : { cell + 1, cell - 1, cell + width, cell - width }) {
+					if (!grid[next] && distance[next] < distance[best]) {
+						best = next;
+					}
+				}
+				Vector3 toTarget = Vector3((best % width) * cellSize, position.y, (best / width) * cellSize) - position;
+				toTarget.y = 0.0f;
+
+				Vector3 velocity = body->GetLinearVelocity();
+				Vector3 heading	 = Vector::LengthSquared(toTarget) > 0.01f ? Vector::Normalise(toTarget) * moveSpeed : Vector3();
+				body->SetLinearVelocity(Vector3(heading.x, velocity.y, heading.z));
+				body->SetAwake(true);
+			}
+		};
+	}
+
+	/*
+	Bodies with no collision volumes, tumbling about under gravity - nothing
+	is ever put in the broadphase, so no pairs are found, and the solver has
+	nothing to do. Almost the whole step is integration over the body store.
+	*/
+	void BuildIntegration(Scene& scene) {
+		std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+		auto randomVector = [&]() {
+			return Vector3(spread(scene.random), spread(scene.random), spread(scene.random));
+		};
+		for (int i = 0; i < scene.options.bodies; ++i) {
+			GameObject* body = new GameObject("Body");
+			body->GetTransform()
+				.SetScale(Vector3(1, 1, 1))
+				.SetPosition(randomVector() * 1000.0f);
+
+			body->SetPhysicsObject(new PhysicsObject(body->GetTransform(), nullptr));
+			body->GetPhysicsObject()->SetInverseMass(1.0f);
+			body->GetPhysicsObject()->InitSphereInertia();
+			body->GetPhysicsObject()->SetLinearVelocity(randomVector() * 10.0f);
+			body->GetPhysicsObject()->SetAngularVelocity(randomVector() * 5.0f);
+
+			scene.world.AddGameObject(body);
+		}
+	}
+
+	struct ScenarioInfo {
+		const char* name;
+		void		(*build)(Scene&);
+	};
+
+	const ScenarioInfo scenarios[] = {
+		{ "sphere_grid",	BuildSphereGrid },
+		{ "mixed_grid",		BuildMixedGrid },
+		{ "aabb_grid",		BuildAABBGrid },
+		{ "bridge",			BuildBridge },
+		{ "maze",			BuildMaze },
+		{ "integrate",		BuildIntegration },
+	};
+
+	struct BroadPhaseInfo {
+		const char* name;
+		bool		simpleContainer;
+		bool		quadTree;
+	};
+
+	const BroadPhaseInfo broadPhases[] = {
+		{ "tree",		false,	false },
+		{ "sap",		true,	false },
+		{ "quadtree",	false,	true },
+	};
+
+	struct Result {
+		std::string name;
+		std::string broadPhase;
+		int		size		= 0;
+		int		bodies		= 0;
+		int		staticBodies = 0;
+		int		constraints = 0;
+		int		steps		= 0;
+		double	seconds		= 0.0;
+		double	zoneTotals[PhysicsProfiler::ZoneCount]	= {};	//Milliseconds
+		float	zoneMax[PhysicsProfiler::ZoneCount]		= {};
+		double	counterTotals[PhysicsProfiler::CounterCount] = {};
+		MemoryUsage memoryBefore;
+		MemoryUsage memoryAfter;
+		double	positionSum = 0.0;	//Where the dynamic bodies ended up - changes if the simulation's results do
+	};
+
+	Result RunScenario(const ScenarioInfo& info, const BroadPhaseInfo& broadPhase, const Options& options, JobSystem* jobs) {
+		Result result;
+		result.name			= info.name;
+		result.broadPhase	= broadPhase.name;
+		result.size			= options.gridSize;
+		result.memoryBefore = GetMemoryUsage();
+
+		GameWorld world;
+		{
+			PhysicsSystem physics(world);
+			physics.UseGravity(true);
+			physics.UseBroadPhase(true);
+			physics.UseSimpleContainer(broadPhase.simpleContainer);
+			physics.UseQuadTree(broadPhase.quadTree);
+			physics.SetDeterministic(true);
+			physics.AllowSleeping(options.sleeping);
+			physics.SetJobSystem(jobs);
+
+			Scene scene(world, options);
+			info.build(scene);
+
+			GameObjectIterator first, last;
+			world.GetObjectIterators(first, last);
+			result.bodies = (int)(last - first);
+			world.GetStaticObjectIterators(first, last);
+			result.staticBodies = (int)(last - first);
+
+			std::vector<Constraint*>::const_iterator firstConstraint, lastConstraint;
+			world.GetConstraintIterators(firstConstraint, lastConstraint);
+			result.constraints = (int)(lastConstraint - firstConstraint);
+
+			PhysicsProfiler& profiler = physics.GetProfiler();
+
+			for (int i = 0; i < options.steps; ++i) {
+				if (scene.preStep) {
+					scene.preStep();
+				}
+				physics.Update(StepTime);
+
+				const PhysicsProfiler::FrameStats& frame = profiler.GetFrame();
+				for (int z = 0; z < PhysicsProfiler::ZoneCount; ++z) {
+					result.zoneTotals[z] += frame.zoneTimes[z];
+					result.zoneMax[z] = std::max(result.zoneMax[z], frame.zoneTimes[z]);
+				}
+				for (int c = 0; c < PhysicsProfiler::CounterCount; ++c) {
+					result.counterTotals[c] += frame.counters[c];
+				}
+			}
+			result.steps	= options.steps;
+			result.seconds	= result.zoneTotals[PhysicsProfiler::Update] / 1000.0;
+
+			result.memoryAfter = GetMemoryUsage();
+
+			world.GetObjectIterators(first, last);
+			for (auto i = first; i != last; ++i) {
+				const Vector3& p = (*i)->GetTransform().GetPosition();
+				result.positionSum += (double)p.x + p.y + p.z;
+			}
+		}
+		world.ClearAndErase();
+		return result;
+	}
+
+	void WriteJSON(std::ostream& out, const std::vector<Result>& results, const Options& options, int threadCount) {
+		out << std::fixed << std::setprecision(4);
+		out << "{\n";
+		out << "\t\"steps\": " << options.steps << ",\n";
+		out << "\t\"threads\": " << threadCount << ",\n";
+		out << "\t\"stepTime\": " << StepTime << ",\n";
+		out << "\t\"scenarios\": [\n";
+
+		for (size_t r = 0; r < results.size(); ++r) {
+			const Result& result = results[r];
+			double steps = std::max(1, result.steps);
+
+			out << "\t\t{\n";
+			out << "\t\t\t\"name\": \"" << result.name << "\",\n";
+			out << "\t\t\t\"broadphase\": \"" << result.broadPhase << "\",\n";
+			out << "\t\t\t\"size\": " << result.size << ",\n";
+			out << "\t\t\t\"bodies\": " << result.bodies << ",\n";
+			out << "\t\t\t\"staticBodies\": " << result.staticBodies << ",\n";
+			out << "\t\t\t\"constraints\": " << result.constraints << ",\n";
+			out << "\t\t\t\"seconds\": " << result.seconds << ",\n";
+			out << "\t\t\t\"stepsPerSecond\": " << (result.seconds > 0.0 ? result.steps / result.seconds : 0.0) << ",\n";
+
+			out << "\t\t\t\"zones\": {\n";
+			for (int z = 0; z < PhysicsProfiler::ZoneCount; ++z) {
+				out << "\t\t\t\t\"" << PhysicsProfiler::GetZoneName((PhysicsProfiler::Zone)z) << "\": { "
+					<< "\"meanMs\": " << result.zoneTotals[z] / steps << ", "
+					<< "\"maxMs\": " << result.zoneMax[z] << " }"
+					<< (z + 1 < PhysicsProfiler::ZoneCount ? "," : "") << "\n";
+			}
+			out << "\t\t\t},\n";
+
+			out << "\t\t\t\"counters\": {\n";
+			for (int c = 0; c < PhysicsProfiler::CounterCount; ++c) {
+				out << "\t\t\t\t\"" << PhysicsProfiler::GetCounterName((PhysicsProfiler::Counter)c) << "\": "
+					<< result.counterTotals[c] / steps
+					<< (c + 1 < PhysicsProfiler::CounterCount ? "," : "") << "\n";
+			}
+			out << "\t\t\t},\n";
+
+			out << "\t\t\t\"memoryKB\": { "
+				<< "\"before\": " << result.memoryBefore.current << ", "
+				<< "\"after\": " << result.memoryAfter.current << ", "
+				<< "\"peak\": " << result.memoryAfter.peak << " },\n";
+			out << "\t\t\t\"positionSum\": " << result.positionSum << "\n";
+			out << "\t\t}" << (r + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "\t]\n";
+		out << "}\n";
+	}
+
+	void PrintSummary(std::ostream& out, const Result& result) {
+		double steps = std::max(1, result.steps);
+		out << std::left << std::setw(12) << result.name << std::setw(9) << result.broadPhase << std::right << std::fixed
+			<< std::setw(7) << result.bodies << " bodies "
+			<< std::setw(10) << std::setprecision(1) << (result.seconds > 0.0 ? result.steps / result.seconds : 0.0) << " steps/s  "
+			<< std::setprecision(3);
+		for (int z = PhysicsProfiler::Sync; z < PhysicsProfiler::ZoneCount; ++z) {
+			out << PhysicsProfiler::GetZoneName((PhysicsProfiler::Zone)z) << " " << result.zoneTotals[z] / steps << "ms ";
+		}
+		out << " " << result.memoryAfter.current / 1024 << "MB\n";
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "--no-sleep") {
+				options.sleeping = false;
+			}
+			else if (!hasValue) {
+				return false;
+			}
+			else if (arg == "--steps") {
+				options.steps = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--threads") {
+				options.threads = std::atoi(argv[++i]);
+			}
+			else if (arg == "--size") {
+				std::stringstream sizes(argv[++i]);
+				std::string size;
+				options.gridSizes.clear();
+				while (std::getline(sizes, size, ',')) {
+					options.gridSizes.push_back(std::max(1, std::atoi(size.c_str())));
+				}
+			}
+			else if (arg == "--broadphase") {
+				std::stringstream names(argv[++i]);
+				std::string name;
+				options.broadPhases.clear();
+				while (std::getline(names, name, ',')) {
+					bool known = false;
+					for (const BroadPhaseInfo& info : broadPhases) {
+						known |= name == info.name;
+					}
+					if (!known) {
+						return false;
+					}
+					options.broadPhases.insert(name);
+				}
+			}
+			else if (arg == "--links") {
+				options.bridgeLinks = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--enemies") {
+				options.enemies = std::max(0, std::atoi(argv[++i]));
+			}
+			else if (arg == "--bodies") {
+				options.bodies = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--json") {
+				options.jsonFile = argv[++i];
+			}
+			else if (arg == "--scenario") {
+				std::stringstream names(argv[++i]);
+				std::string name;
+				while (std::getline(names, name, ',')) {
+					options.scenarios.insert(name);
+				}
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::cerr << "Usage: " << argv[0] << " [--steps n] [--scenario name,name...] [--threads n]"
+			<< " [--broadphase tree,sap,quadtree] [--size n,n...] [--links n] [--enemies n] [--bodies n] [--no-sleep] [--json file]\n";
+		std::cerr << "Scenarios:";
+		for (const ScenarioInfo& info : scenarios) {
+			std::cerr << " " << info.name;
+		}
+		std::cerr << "\n";
+		return 1;
+	}
+
+	JobSystem* jobs = options.threads != 0 ? new JobSystem(options.threads < 0 ? -1 : options.threads - 1) : nullptr;
+	int threadCount = jobs ? jobs->GetThreadCount() : 1;
+
+	//Keep stdout clean for the JSON if that's where it's going
+	bool jsonToStdout = options.jsonFile == "-";
+	std::ostream& log = jsonToStdout ? std::cerr : std::cout;
+
+	std::vector<Result> results;
+	for (int size : options.gridSizes) {
+		Options sized	= options;
+		sized.gridSize	= size;
+		for (const ScenarioInfo& info : scenarios) {
+			if (!options.scenarios.empty() && !options.scenarios.count(info.name)) {
+				continue;
+			}
+			for (const BroadPhaseInfo& broadPhase : broadPhases) {
+				if (!options.broadPhases.count(broadPhase.name)) {
+					continue;
+				}
+				results.push_back(RunScenario(info, broadPhase, sized, jobs));
+				PrintSummary(log, results.back());
+			}
+		}
+	}
+	delete jobs;
+
+	if (results.empty()) {
+		std::cerr << "No scenarios matched\n";
+		return 1;
+	}
+
+	if (jsonToStdout) {
+		WriteJSON(std::cout, results, options, threadCount);
+	}
+	else if (!options.jsonFile.empty()) {
+		std::ofstream file(options.jsonFile);
+		if (!file) {
+			std::cerr << "Couldn't write " << options.jsonFile << "\n";
+			return 1;
+		}
+		WriteJSON(file, results, options, threadCount);
+	}
+	return 0;
+}